@@ -1,111 +1,400 @@
 #include "DeadlockDetector.h"
 #include <iostream>
-#include <algorithm> 
-#include <cmath>    
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+namespace
+{
+// Visits the rows of every part of view, as the row-generic helpers below expect.
+auto viewRows(const WFGView &view)
+{
+    return [&view](const auto &visit) {
+        for (const WFGPairs *part : view)
+        {
+            for (const auto &pair : *part)
+            {
+                visit(pair.first, pair.second);
+            }
+        }
+    };
+}
+} // namespace
+
+std::vector<std::vector<TransactionId>> CycleSet::toVectors() const
+{
+    std::vector<std::vector<TransactionId>> cycles;
+    cycles.reserve(size());
+    for (size_t i = 0; i < size(); ++i)
+    {
+        cycles.emplace_back(members.begin() + offsets[i], members.begin() + offsets[i + 1]);
+    }
+    return cycles;
+}
+
+// Prepares the workspace for a round with at most expectedVertices distinct transactions.
+// Buffers only grow; a round that fits in the current capacity allocates nothing.
+void DeadlockDetector::resetWorkspace(size_t expectedVertices)
+{
+    size_t tableSize = 16;
+    while (tableSize < expectedVertices * 2)
+    {
+        tableSize <<= 1;
+    }
+    if (ws_.slotKeys.size() < tableSize)
+    {
+        ws_.slotKeys.resize(tableSize);
+        ws_.slotValues.resize(tableSize);
+    }
+    std::fill(ws_.slotValues.begin(), ws_.slotValues.end(), -1);
+    ws_.ids.clear();
+    ws_.roots.clear();
+    ws_.cycleVertices.clear();
+    ws_.dfsStack.clear();
+}
+
+int DeadlockDetector::internTransaction(TransactionId transId)
+{
+    const size_t mask = ws_.slotKeys.size() - 1;
+    size_t slot = (static_cast<size_t>(transId) * 0x9E3779B97F4A7C15ULL) & mask;
+    while (ws_.slotValues[slot] != -1)
+    {
+        if (ws_.slotKeys[slot] == transId)
+        {
+            return ws_.slotValues[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    int denseId = static_cast<int>(ws_.ids.size());
+    ws_.slotKeys[slot] = transId;
+    ws_.slotValues[slot] = denseId;
+    ws_.ids.push_back(transId);
+    return denseId;
+}
+
+int DeadlockDetector::lookupTransaction(TransactionId transId) const
+{
+    const size_t mask = ws_.slotKeys.size() - 1;
+    size_t slot = (static_cast<size_t>(transId) * 0x9E3779B97F4A7C15ULL) & mask;
+    while (ws_.slotValues[slot] != -1)
+    {
+        if (ws_.slotKeys[slot] == transId)
+        {
+            return ws_.slotValues[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
 
 // Depth-First Search (DFS) utility function for cycle detection.
-// This function recursively traverses the graph, identifying cycles by detecting back-edges
-// to nodes already in the current recursion stack. It's a core component for deadlock detection
+// This function traverses the graph from root, identifying cycles by detecting back-edges
+// to nodes already on the current DFS stack. It's a core component for deadlock detection
 // in various modes, including HAWK, where it operates on local or aggregated WFGs.
-void DeadlockDetector::dfs(TransactionId u,
-                         const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph,
-                         std::unordered_map<TransactionId, int> &visited_count, 
-                         std::unordered_map<TransactionId, bool> &recursionStack,
-                         std::unordered_map<TransactionId, TransactionId> &parent,
-                         std::vector<std::vector<TransactionId>> &cycles,
-                         std::unordered_map<TransactionId, int> &frequency)
+// A node on the stack is never re-entered, so the stack is always a simple path and the
+// cycle closed by a back-edge is exactly the stack segment above its target.
+void DeadlockDetector::dfs(int root, CycleSet &out)
 {
-    // Decrement visited_count for the current node. This count mechanism is
-    // used to ensure that nodes with multiple incoming edges are processed correctly
-    // or to limit redundant traversals in certain graph structures.
-    visited_count[u]--;
-
-    recursionStack[u] = true;
+    auto push = [this](int u) {
+        // Decrement visited_count for the node. This count mechanism is
+        // used to ensure that nodes with multiple incoming edges are processed correctly
+        // or to limit redundant traversals in certain graph structures.
+        ws_.visitedCount[u]--;
+        ws_.stackPos[u] = static_cast<int>(ws_.dfsStack.size());
+        ws_.dfsStack.push_back({u, ws_.rowStart[u]});
+    };
 
-    if (graph.count(u))
+    push(root);
+    while (!ws_.dfsStack.empty())
     {
-        for (TransactionId v : graph.at(u))
+        auto &top = ws_.dfsStack.back();
+        int u = top.first;
+        if (top.second == ws_.rowStart[u + 1])
         {
-            if (visited_count[v] > 0)
+            ws_.stackPos[u] = -1;
+            ws_.dfsStack.pop_back();
+            continue;
+        }
+
+        int v = ws_.targets[top.second++];
+        if (ws_.stackPos[v] >= 0)
+        {
+            for (size_t i = ws_.stackPos[v]; i < ws_.dfsStack.size(); ++i)
             {
-                parent[v] = u;
-                dfs(v, graph, visited_count, recursionStack, parent, cycles, frequency);
-            }
-            else if (recursionStack[v])
-            {
-                std::vector<TransactionId> cycle;
-                TransactionId curr = u;
-                while (curr != v)
-                {
-                    cycle.push_back(curr);
-                    frequency[curr]++; 
-                    curr = parent[curr];
-                }
-                cycle.push_back(v);
-                frequency[v]++;
-                std::reverse(cycle.begin(), cycle.end());
-                cycles.push_back(cycle);
+                int member = ws_.dfsStack[i].first;
+                ws_.cycleVertices.push_back(member);
+                ws_.frequency[member]++;
             }
+            out.offsets.push_back(ws_.cycleVertices.size());
+        }
+        else if (ws_.visitedCount[v] > 0)
+        {
+            push(v);
         }
     }
-    recursionStack[u] = false; 
 }
-// Finds all cycles in the given Wait-For Graph (WFG).
+
+template <typename ForEachRow>
+void DeadlockDetector::findCyclesInRows(const ForEachRow &forEachRow, size_t rowCount, size_t edgeCount, CycleSet &out)
+{
+    out.clear();
+    resetWorkspace(rowCount + edgeCount);
+
+    // Waiting transactions are interned first and in row order, so they double as DFS roots.
+    forEachRow([this](TransactionId waiting, const std::vector<TransactionId> &) {
+        size_t known = ws_.ids.size();
+        int u = internTransaction(waiting);
+        if (static_cast<size_t>(u) == known)
+        {
+            ws_.roots.push_back(u);
+        }
+    });
+    forEachRow([this](TransactionId, const std::vector<TransactionId> &holding) {
+        for (TransactionId target : holding)
+        {
+            internTransaction(target);
+        }
+    });
+    const size_t n = ws_.ids.size();
+
+    ws_.rowStart.assign(n + 1, 0);
+    forEachRow([this](TransactionId waiting, const std::vector<TransactionId> &holding) {
+        ws_.rowStart[lookupTransaction(waiting) + 1] += static_cast<int>(holding.size());
+    });
+    for (size_t i = 0; i < n; ++i)
+    {
+        ws_.rowStart[i + 1] += ws_.rowStart[i];
+    }
+
+    ws_.targets.resize(edgeCount);
+    ws_.inDegree.assign(n, 0);
+    ws_.rowFill.assign(ws_.rowStart.begin(), ws_.rowStart.end() - 1);
+    forEachRow([this](TransactionId waiting, const std::vector<TransactionId> &holding) {
+        int &cursor = ws_.rowFill[lookupTransaction(waiting)];
+        for (TransactionId target : holding)
+        {
+            int v = lookupTransaction(target);
+            ws_.targets[cursor++] = v;
+            ws_.inDegree[v]++;
+        }
+    });
+
+    // The visited_count is initialized based on degree differences,
+    // which can help in prioritizing nodes or handling certain graph properties.
+    ws_.visitedCount.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        int outDegree = ws_.rowStart[i + 1] - ws_.rowStart[i];
+        ws_.visitedCount[i] = std::abs(outDegree - ws_.inDegree[i]) + 1;
+    }
+    ws_.stackPos.assign(n, -1);
+    ws_.frequency.assign(n, 0);
+
+    for (int root : ws_.roots)
+    {
+        dfs(root, out);
+    }
+
+    out.members.resize(ws_.cycleVertices.size());
+    out.memberFrequency.resize(ws_.cycleVertices.size());
+    for (size_t i = 0; i < ws_.cycleVertices.size(); ++i)
+    {
+        int member = ws_.cycleVertices[i];
+        out.members[i] = ws_.ids[member];
+        out.memberFrequency[i] = ws_.frequency[member];
+    }
+}
+
+// Finds all cycles in the given Wait-For Graph (WFG) into a caller-owned buffer.
 // This is the main entry point for cycle detection, used by various deadlock detection
 // algorithms, including HAWK, to find deadlocks in local or aggregated WFGs.
+void DeadlockDetector::findCycles(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph,
+                                  CycleSet &out)
+{
+    auto forEachRow = [&graph](const auto &visit) {
+        for (const auto &pair : graph)
+        {
+            visit(pair.first, pair.second);
+        }
+    };
+    findCyclesInRows(forEachRow, graph.size(), edgeCount(graph), out);
+}
+
+void DeadlockDetector::findCycles(const WFGView &view, CycleSet &out)
+{
+    size_t rowCount = 0;
+    for (const WFGPairs *part : view)
+    {
+        rowCount += part->size();
+    }
+    findCyclesInRows(viewRows(view), rowCount, edgeCount(view), out);
+}
+
+// Finds all cycles in the given Wait-For Graph (WFG).
+// Convenience wrapper returning freshly allocated containers; the detection loops use the
+// CycleSet overload instead.
 std::pair<std::vector<std::vector<TransactionId>>, std::unordered_map<TransactionId, int>>
 DeadlockDetector::findCycles(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph)
 {
-    std::vector<std::vector<TransactionId>> cycles;
-    std::unordered_map<TransactionId, int> visited_count; 
-    std::unordered_map<TransactionId, bool> recursionStack;
-    std::unordered_map<TransactionId, TransactionId> parent;
-    std::unordered_map<TransactionId, int> frequency; 
-
-    std::unordered_map<TransactionId, int> in_degree;
-    std::unordered_map<TransactionId, int> out_degree;
-    // Initialize visited_count, recursionStack, parent, and frequency for all transactions
-    // that are part of the graph. The visited_count is initialized based on degree differences,
-    // which can help in prioritizing nodes or handling certain graph properties.
+    CycleSet cycleSet;
+    findCycles(graph, cycleSet);
+
+    std::unordered_map<TransactionId, int> frequency;
+    for (size_t i = 0; i < ws_.ids.size(); ++i)
+    {
+        frequency[ws_.ids[i]] = ws_.frequency[i];
+    }
+    return {cycleSet.toVectors(), frequency};
+}
+
+size_t DeadlockDetector::edgeCount(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph)
+{
+    size_t edges = 0;
     for (const auto &pair : graph)
     {
-        TransactionId u = pair.first;
-        out_degree[u] = pair.second.size(); 
-        for (TransactionId v : pair.second)
+        edges += pair.second.size();
+    }
+    return edges;
+}
+
+size_t DeadlockDetector::edgeCount(const WFGView &view)
+{
+    size_t edges = 0;
+    for (const WFGPairs *part : view)
+    {
+        for (const auto &pair : *part)
         {
-            in_degree[v]++;
+            edges += pair.second.size();
         }
     }
+    return edges;
+}
 
-    for (const auto &pair : graph)
-    {
-        TransactionId txn_id = pair.first;
-        recursionStack[txn_id] = false;
-        parent[txn_id] = 0;
-        frequency[txn_id] = 0;
+namespace
+{
+// entries, when given, limits the result to edges reachable from one of them.
+template <typename ForEachRow>
+std::unordered_map<TransactionId, std::vector<TransactionId>>
+residualOfRows(const ForEachRow &forEachRow, const std::unordered_set<TransactionId> *entries)
+{
+    std::unordered_map<TransactionId, std::vector<TransactionId>> reverse;
+    std::unordered_set<TransactionId> waiting;
+    forEachRow([&](TransactionId u, const std::vector<TransactionId> &holding) {
+        if (!holding.empty())
+        {
+            waiting.insert(u);
+        }
+        for (TransactionId v : holding)
+        {
+            reverse[v].push_back(u);
+        }
+    });
 
-        visited_count[txn_id] = std::abs(out_degree[txn_id] - in_degree[txn_id]) + 1;
+    // Walk backwards from the exits to everything that reaches one.
+    std::unordered_set<TransactionId> reachesExit;
+    std::vector<TransactionId> frontier;
+    for (const auto &pair : reverse)
+    {
+        if (!waiting.count(pair.first))
+        {
+            reachesExit.insert(pair.first);
+            frontier.push_back(pair.first);
+        }
     }
-    for (const auto &pair : graph) {
-        for (TransactionId target : pair.second) {
-            if (visited_count.find(target) == visited_count.end()) {
-                visited_count[target] = std::abs(out_degree[target] - in_degree[target]) + 1;
-                recursionStack[target] = false;
-                parent[target] = 0;
-                frequency[target] = 0;
+    while (!frontier.empty())
+    {
+        TransactionId u = frontier.back();
+        frontier.pop_back();
+        auto it = reverse.find(u);
+        if (it == reverse.end())
+        {
+            continue;
+        }
+        for (TransactionId w : it->second)
+        {
+            if (reachesExit.insert(w).second)
+            {
+                frontier.push_back(w);
             }
         }
     }
 
-    for (const auto &pair : graph)
+    // Walk forwards from the entries to everything one reaches.
+    std::unordered_set<TransactionId> reachedFromEntry;
+    if (entries)
     {
-        TransactionId txn_id = pair.first;
+        std::unordered_map<TransactionId, std::vector<const std::vector<TransactionId> *>> forward;
+        forEachRow([&](TransactionId u, const std::vector<TransactionId> &holding) { forward[u].push_back(&holding); });
+        for (TransactionId entry : *entries)
+        {
+            if (reachedFromEntry.insert(entry).second)
+            {
+                frontier.push_back(entry);
+            }
+        }
+        while (!frontier.empty())
         {
-            dfs(txn_id, graph, visited_count, recursionStack, parent, cycles, frequency);
+            TransactionId u = frontier.back();
+            frontier.pop_back();
+            auto it = forward.find(u);
+            if (it == forward.end())
+            {
+                continue;
+            }
+            for (const std::vector<TransactionId> *holding : it->second)
+            {
+                for (TransactionId v : *holding)
+                {
+                    if (reachedFromEntry.insert(v).second)
+                    {
+                        frontier.push_back(v);
+                    }
+                }
+            }
         }
     }
-    return {cycles, frequency};
+
+    std::unordered_map<TransactionId, std::vector<TransactionId>> residual;
+    forEachRow([&](TransactionId u, const std::vector<TransactionId> &holding) {
+        if (entries && !reachedFromEntry.count(u))
+        {
+            return;
+        }
+        for (TransactionId v : holding)
+        {
+            if (reachesExit.count(v))
+            {
+                residual[u].push_back(v);
+            }
+        }
+    });
+    return residual;
 }
+} // namespace
+
+std::unordered_map<TransactionId, std::vector<TransactionId>>
+DeadlockDetector::residualGraph(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph)
+{
+    auto forEachRow = [&graph](const auto &visit) {
+        for (const auto &pair : graph)
+        {
+            visit(pair.first, pair.second);
+        }
+    };
+    return residualOfRows(forEachRow, nullptr);
+}
+
+std::unordered_map<TransactionId, std::vector<TransactionId>> DeadlockDetector::residualGraph(const WFGView &view)
+{
+    return residualOfRows(viewRows(view), nullptr);
+}
+
+std::unordered_map<TransactionId, std::vector<TransactionId>>
+DeadlockDetector::residualGraph(const WFGView &view, const std::unordered_set<TransactionId> &entries)
+{
+    return residualOfRows(viewRows(view), &entries);
+}
+
 // Compares two transactions based on their involvement frequency in detected cycles.
 // This function is used to prioritize transactions for victim selection during deadlock resolution.
 // Transactions involved in more cycles typically have higher priority to be aborted.
@@ -114,7 +403,7 @@ bool DeadlockDetector::compareTransactionPriority(const std::pair<TransactionId,
 {
     if (a.second != b.second)
     {
-        return a.second > b.second; 
+        return a.second > b.second;
     }
-    return a.first < b.first;      
+    return a.first < b.first;
 }
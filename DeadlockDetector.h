@@ -4,8 +4,44 @@
 #include "commons.h"
 #include <vector>
 #include <unordered_map>
-#include <stack>   
-#include <algorithm> 
+#include <unordered_set>
+#include <stack>
+#include <algorithm>
+
+// Caller-owned output buffer for a detection round.
+// All detected cycles are stored back to back in `members`; cycle i occupies
+// members[offsets[i], offsets[i + 1]). `memberFrequency` runs parallel to `members`
+// and holds how many cycles that transaction participates in.
+// clear() keeps the capacity, so a buffer reused across rounds stops allocating
+// once it has grown to the size of the largest round.
+struct CycleSet
+{
+    std::vector<TransactionId> members;
+    std::vector<int> memberFrequency;
+    std::vector<size_t> offsets{0};
+
+    size_t size() const { return offsets.size() - 1; }
+    bool empty() const { return offsets.size() == 1; }
+
+    void clear()
+    {
+        members.clear();
+        memberFrequency.clear();
+        offsets.clear();
+        offsets.push_back(0);
+    }
+
+    // Copies the cycles out as nested vectors, e.g. for network messages.
+    std::vector<std::vector<TransactionId>> toVectors() const;
+};
+
+// Adjacency lists as carried in WFG messages: one (waiting, holding) row per transaction.
+using WFGPairs = std::vector<std::pair<TransactionId, std::vector<TransactionId>>>;
+
+// Several reports read as one graph without merging them. A transaction may have rows in
+// more than one part; its out-edges are the union of those rows.
+using WFGView = std::vector<const WFGPairs *>;
+
 class DeadlockDetector
 {
 public:
@@ -20,6 +56,35 @@ public:
     std::pair<std::vector<std::vector<TransactionId>>, std::unordered_map<TransactionId, int>>
     findCycles(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph);
 
+    // Allocation-free variant used on the detection path. Cycles are written into the
+    // caller-owned `out` (cleared first) and all scratch state lives in the detector's
+    // workspace, which is cleared but never freed between rounds. Once the workspace and
+    // `out` have grown to the working-set size, a round performs no heap allocations.
+    // Not thread-safe: one detector instance must not be used by two threads at once.
+    void findCycles(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph,
+                    CycleSet &out);
+    // Same, over the union of a view's parts. Zone leaders run it on the reports of their
+    // members as received, so no aggregated graph is built.
+    void findCycles(const WFGView &view, CycleSet &out);
+
+    // Returns the edges of a subtree's WFG that can still be part of a cycle crossing the
+    // subtree boundary, i.e. the edges u -> v where v reaches a transaction without any
+    // out-edge in the graph. A transaction waits for one resource at a time, so one that
+    // has out-edges here has all of them here; any path that leaves the subtree must
+    // therefore leave through a transaction with none. Edges that cannot reach such an exit
+    // only lie on cycles that are entirely inside the subtree and already detected by it.
+    static std::unordered_map<TransactionId, std::vector<TransactionId>>
+    residualGraph(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph);
+    static std::unordered_map<TransactionId, std::vector<TransactionId>> residualGraph(const WFGView &view);
+    // Same, also dropping the edges no entry reaches. An entry is a transaction that may
+    // be waited for from outside the subtree, i.e. one holding a lock outside it; a path
+    // that comes into the subtree must start at one.
+    static std::unordered_map<TransactionId, std::vector<TransactionId>>
+    residualGraph(const WFGView &view, const std::unordered_set<TransactionId> &entries);
+
+    static size_t edgeCount(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph);
+    static size_t edgeCount(const WFGView &view);
+
     // Compares transaction priorities for deadlock resolution.
     // This is a static function that can be used to select a victim transaction
     // based on certain criteria (e.g., transaction ID, number of cycles involved).
@@ -27,25 +92,48 @@ public:
                                           const std::pair<TransactionId, int> &b);
 
 private:
+    // Reusable scratch space for findCycles. Transactions are mapped to dense indices
+    // through an open-addressing table, and the graph is flattened into CSR form so that
+    // every per-vertex array is a plain vector indexed by the dense id.
+    struct Workspace
+    {
+        std::vector<TransactionId> slotKeys;  // open-addressing table: TransactionId -> dense id
+        std::vector<int> slotValues;
+        std::vector<TransactionId> ids;       // dense id -> TransactionId
+        std::vector<int> rowStart;            // CSR row offsets, size n + 1
+        std::vector<int> rowFill;             // next free CSR slot per row while filling
+        std::vector<int> targets;             // CSR column indices (dense ids)
+        std::vector<int> inDegree;
+        std::vector<int> visitedCount;
+        std::vector<int> stackPos;            // position on the DFS stack, -1 if not on it
+        std::vector<int> frequency;
+        std::vector<int> roots;               // dense ids of the graph's keys, in iteration order
+        std::vector<std::pair<int, int>> dfsStack; // (vertex, next edge index)
+        std::vector<int> cycleVertices;       // dense ids of all cycle members, in output order
+    };
+
+    Workspace ws_;
+
+    // Returns the dense id of transId, assigning the next one if it is new.
+    int internTransaction(TransactionId transId);
+    // Looks up the dense id of transId, or -1 if it was never interned.
+    int lookupTransaction(TransactionId transId) const;
+    void resetWorkspace(size_t expectedVertices);
+    // Flattens the rows visited by forEachRow(f), which calls f(waiting, holding list) once
+    // per row, into the workspace and runs the DFS from every waiting transaction. rowCount
+    // and edgeCount size the workspace.
+    template <typename ForEachRow>
+    void findCyclesInRows(const ForEachRow &forEachRow, size_t rowCount, size_t edgeCount, CycleSet &out);
+
     // Depth-First Search (DFS) utility function to detect cycles in a graph.
-    // This recursive function traverses the graph, keeping track of visited nodes
-    // and nodes currently in the recursion stack to identify back-edges, which indicate cycles.
+    // Iterative over an explicit stack so deep wait chains cannot overflow the thread
+    // stack. It keeps track of visited nodes and nodes currently on the DFS stack to
+    // identify back-edges, which indicate cycles.
     // In HAWK, this DFS is crucial for identifying deadlocks within a zone's WFG
     // or the globally aggregated WFG.
-    // u: Current transaction being visited.
-    // graph: The WFG.
-    // visited_count: Keeps track of how many times a node has been visited to handle complex graphs.
-    // recursionStack: Marks nodes currently in the recursion stack to detect back-edges.
-    // parent: Stores the parent of each node in the DFS tree to reconstruct cycles.
-    // cycles: Stores detected deadlock cycles.
-    // frequency: Counts how many cycles each transaction is part of.
-    void dfs(TransactionId u,
-             const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph,
-             std::unordered_map<TransactionId, int> &visited_count,
-             std::unordered_map<TransactionId, bool> &recursionStack,
-             std::unordered_map<TransactionId, TransactionId> &parent,
-             std::vector<std::vector<TransactionId>> &cycles,
-             std::unordered_map<TransactionId, int> &frequency);
+    // root: Dense id of the transaction to start from.
+    // out: Receives each detected cycle.
+    void dfs(int root, CycleSet &out);
 };
 
 #endif // HAWK_DEADLOCK_DETECTOR_H
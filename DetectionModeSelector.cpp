@@ -0,0 +1,75 @@
+#include "DetectionModeSelector.h"
+#include <iostream>
+#include <limits>
+
+DetectionModeSelector::DetectionModeSelector(int numNodes, DeadlockDetectionMode initialMode)
+    : numNodes_(numNodes), mode_(initialMode), candidate_(initialMode),
+      centralizedMaxWaitRate_(std::numeric_limits<double>::infinity())
+{
+}
+
+DeadlockDetectionMode DetectionModeSelector::update(const Interval &interval)
+{
+    DeadlockDetectionMode preferred = preferredMode(interval);
+    if (preferred == mode_)
+    {
+        candidateRounds_ = 0;
+        return mode_;
+    }
+    candidateRounds_ = preferred == candidate_ ? candidateRounds_ + 1 : 1;
+    candidate_ = preferred;
+    if (candidateRounds_ >= ADAPTIVE_SWITCH_ROUNDS)
+    {
+        std::cout << "DetectionModeSelector: Switching from " << modeName(mode_) << " to " << modeName(preferred)
+                  << " detection.\n";
+        mode_ = preferred;
+        candidateRounds_ = 0;
+    }
+    return mode_;
+}
+
+DeadlockDetectionMode DetectionModeSelector::preferredMode(const Interval &interval)
+{
+    if (interval.seconds <= 0.0 || numNodes_ <= 0)
+    {
+        return mode_;
+    }
+    double waitRate = interval.crossNodeWaits / (numNodes_ * interval.seconds);
+    double meanCycleLength =
+        interval.cyclesResolved > 0 ? static_cast<double>(interval.cycleMembers) / interval.cyclesResolved : 0.0;
+    double centralShare = interval.centralDetectionTimeUs / (interval.seconds * 1e6);
+    std::cout << "DetectionModeSelector: " << waitRate << " cross-node waits per node and second, "
+              << interval.cyclesResolved << " cycles of mean length " << meanCycleLength << ", central node "
+              << centralShare * 100 << "% detecting.\n";
+
+    if (mode_ == MODE_CENTRALIZED && centralShare > ADAPTIVE_MAX_CENTRAL_DETECTION_SHARE)
+    {
+        centralizedMaxWaitRate_ = waitRate / 2;
+    }
+    if (waitRate < ADAPTIVE_RARE_WAITS_PER_NODE_S && meanCycleLength <= ADAPTIVE_MAX_PROBE_CYCLE_LENGTH)
+    {
+        return MODE_PATH_PUSHING;
+    }
+    if (numNodes_ <= ADAPTIVE_CENTRALIZED_MAX_NODES && waitRate < centralizedMaxWaitRate_)
+    {
+        return MODE_CENTRALIZED;
+    }
+    return MODE_HAWK;
+}
+
+const char *DetectionModeSelector::modeName(DeadlockDetectionMode mode)
+{
+    switch (mode)
+    {
+    case MODE_CENTRALIZED:
+        return "centralized";
+    case MODE_HAWK:
+        return "HAWK";
+    case MODE_PATH_PUSHING:
+        return "path-pushing";
+    case MODE_ADAPTIVE:
+        return "adaptive";
+    default:
+        return "no";
+    }
+}
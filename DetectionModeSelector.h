@@ -0,0 +1,47 @@
+#ifndef HAWK_DETECTION_MODE_SELECTOR_H
+#define HAWK_DETECTION_MODE_SELECTOR_H
+
+#include "commons.h"
+
+// DetectionModeSelector picks the detector the cluster runs in MODE_ADAPTIVE, on the
+// central node, once per PAG round. Path-pushing is preferred while cross-node waits are
+// rare and the cycles short, since it costs nothing while no transaction is blocked.
+// Otherwise centralized detection is preferred on small clusters and HAWK on large ones.
+// HAWK is also preferred once centralized detection has taken more than
+// ADAPTIVE_MAX_CENTRAL_DETECTION_SHARE of the central node's time. After that,
+// centralized detection is only preferred again below half the wait rate at which that
+// happened. A new choice must win ADAPTIVE_SWITCH_ROUNDS rounds in a row before it
+// replaces the current one.
+class DetectionModeSelector
+{
+public:
+    // What the central node measured over one PAG round.
+    struct Interval
+    {
+        double seconds = 0.0;
+        long long crossNodeWaits = 0;
+        long long cyclesResolved = 0;          // by any node
+        long long cycleMembers = 0;            // their total length
+        long long centralDetectionTimeUs = 0;  // spent by the central node
+    };
+
+    DetectionModeSelector(int numNodes, DeadlockDetectionMode initialMode);
+
+    // Folds in one round and returns the detector to run from now on.
+    DeadlockDetectionMode update(const Interval &interval);
+
+    DeadlockDetectionMode getMode() const { return mode_; }
+
+    static const char *modeName(DeadlockDetectionMode mode);
+
+private:
+    DeadlockDetectionMode preferredMode(const Interval &interval);
+
+    int numNodes_;
+    DeadlockDetectionMode mode_;
+    DeadlockDetectionMode candidate_;
+    int candidateRounds_ = 0;
+    double centralizedMaxWaitRate_; // waits per node and second
+};
+
+#endif // HAWK_DETECTION_MODE_SELECTOR_H
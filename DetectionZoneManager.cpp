@@ -1,65 +1,377 @@
 #include "DetectionZoneManager.h"
 #include <iostream> 
 
-DetectionZoneManager::DetectionZoneManager(NodeId nodeId) : nodeId(nodeId), myZoneLeaderId_(nodeId)
+DetectionZoneManager::DetectionZoneManager(NodeId nodeId) : nodeId(nodeId)
 {
-    detectionZones[nodeId].push_back(nodeId);
-    myDetectionZoneMembers_.push_back(nodeId);
+    auto tree = std::make_shared<Snapshot>();
+    tree->zones[nodeId].push_back(nodeId);
+    tree->myZoneLeaderId = nodeId;
+    tree->myZoneMembers.push_back(nodeId);
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(tree)));
 }
+
+std::shared_ptr<const DetectionZoneManager::Snapshot> DetectionZoneManager::getSnapshot() const
+{
+    return std::atomic_load(&snapshot_);
+}
+
+void DetectionZoneManager::publish(std::shared_ptr<Snapshot> tree)
+{
+    updateMyZone(*tree);
+    printMyZone(*tree);
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(tree)));
+}
+
 // Updates the detection zones and leaders.
 // This function receives the new global detection zone configuration (e.g., from a central node)
 // and updates the local state of the manager, determining this node's new zone and leader.
 // This is a crucial step in the adaptive nature of HAWK where zones can change over time.
-void DetectionZoneManager::updateDetectionZones(const std::vector<std::vector<NodeId>> &newZones, const std::vector<NodeId>& newLeaders)
+void DetectionZoneManager::updateDetectionZones(const std::vector<std::vector<NodeId>> &newZones, const std::vector<NodeId>& newLeaders,
+                                                const std::vector<int>& newLevels, long long version)
 {
-    std::unique_lock<std::mutex> lock(zoneMutex); 
-    detectionZones.clear(); 
-    myDetectionZoneMembers_.clear(); 
-    myZoneLeaderId_ = 0;
+    std::unique_lock<std::mutex> lock(updateMutex_);
+    auto tree = std::make_shared<Snapshot>();
+    tree->version = version;
 
     for (size_t i = 0; i < newZones.size(); ++i)
     {
         const auto &zone = newZones[i];
         NodeId leader = newLeaders[i];
+        int level = i < newLevels.size() ? newLevels[i] : 0;
 
-        if (!zone.empty())
+        if (level > 0 && !zone.empty())
+        {
+            if (tree->upperTierZones.size() < static_cast<size_t>(level))
+            {
+                tree->upperTierZones.resize(level);
+            }
+            tree->upperTierZones[level - 1][leader] = zone;
+        }
+        else if (!zone.empty())
         {
-            detectionZones[leader] = zone; 
+            tree->zones[leader] = zone; 
+        }
+    }
+    publish(std::move(tree));
+}
+
+bool DetectionZoneManager::applyDetectionTree(const NetworkMessage &msg)
+{
+    if (msg.baseTreeVersion == 0)
+    {
+        updateDetectionZones(msg.detectionZones, msg.detectionZoneLeaders, msg.detectionZoneLevels, msg.treeVersion);
+        return true;
+    }
 
-            if (std::find(zone.begin(), zone.end(), nodeId) != zone.end())
+    std::unique_lock<std::mutex> lock(updateMutex_);
+    std::shared_ptr<const Snapshot> current = getSnapshot();
+    if (current->version != msg.baseTreeVersion)
+    {
+        std::cerr << "Node " << nodeId << ": Ignoring detection tree diff " << msg.baseTreeVersion << " -> " << msg.treeVersion
+                  << ", this node is at version " << current->version << ".\n";
+        return false;
+    }
+    // Readers may hold the current snapshot; the diff is applied to a copy.
+    auto tree = std::make_shared<Snapshot>(*current);
+    for (size_t i = 0; i < msg.removedZoneLeaders.size(); ++i)
+    {
+        int level = i < msg.removedZoneLevels.size() ? msg.removedZoneLevels[i] : 0;
+        if (level == 0)
+        {
+            tree->zones.erase(msg.removedZoneLeaders[i]);
+        }
+        else if (static_cast<size_t>(level) <= tree->upperTierZones.size())
+        {
+            tree->upperTierZones[level - 1].erase(msg.removedZoneLeaders[i]);
+        }
+    }
+    for (size_t i = 0; i < msg.detectionZones.size(); ++i)
+    {
+        int level = i < msg.detectionZoneLevels.size() ? msg.detectionZoneLevels[i] : 0;
+        if (level == 0)
+        {
+            tree->zones[msg.detectionZoneLeaders[i]] = msg.detectionZones[i];
+            continue;
+        }
+        if (tree->upperTierZones.size() < static_cast<size_t>(level))
+        {
+            tree->upperTierZones.resize(level);
+        }
+        tree->upperTierZones[level - 1][msg.detectionZoneLeaders[i]] = msg.detectionZones[i];
+    }
+    while (!tree->upperTierZones.empty() && tree->upperTierZones.back().empty())
+    {
+        tree->upperTierZones.pop_back();
+    }
+    tree->version = msg.treeVersion;
+    publish(std::move(tree));
+    return true;
+}
+
+size_t DetectionZoneManager::diffDetectionTree(const std::vector<std::vector<NodeId>> &zones, const std::vector<NodeId> &leaders,
+                                               const std::vector<int> &levels, NetworkMessage &diff)
+{
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    // Zones are keyed by (tier, leader); a leader leads at most one zone per tier.
+    std::map<std::pair<int, NodeId>, const std::vector<NodeId> *> current;
+    for (const auto &zone : tree->zones)
+    {
+        current[{0, zone.first}] = &zone.second;
+    }
+    for (size_t tier = 1; tier <= tree->upperTierZones.size(); ++tier)
+    {
+        for (const auto &zone : tree->upperTierZones[tier - 1])
+        {
+            current[{static_cast<int>(tier), zone.first}] = &zone.second;
+        }
+    }
+
+    size_t changed = 0;
+    for (size_t i = 0; i < zones.size(); ++i)
+    {
+        int level = i < levels.size() ? levels[i] : 0;
+        auto it = current.find({level, leaders[i]});
+        if (it != current.end())
+        {
+            bool same = *it->second == zones[i];
+            current.erase(it);
+            if (same)
             {
-                myZoneLeaderId_ = leader;
-                myDetectionZoneMembers_ = zone;
+                continue;
             }
         }
+        diff.detectionZones.push_back(zones[i]);
+        diff.detectionZoneLeaders.push_back(leaders[i]);
+        diff.detectionZoneLevels.push_back(level);
+        changed++;
+    }
+    for (const auto &removed : current)
+    {
+        diff.removedZoneLevels.push_back(removed.first.first);
+        diff.removedZoneLeaders.push_back(removed.first.second);
+        changed++;
+    }
+    diff.baseTreeVersion = tree->version;
+    return changed;
+}
+
+void DetectionZoneManager::getDetectionTree(std::vector<std::vector<NodeId>> &zones, std::vector<NodeId> &leaders,
+                                            std::vector<int> &levels)
+{
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    for (const auto &zone : tree->zones)
+    {
+        zones.push_back(zone.second);
+        leaders.push_back(zone.first);
+        levels.push_back(0);
+    }
+    for (size_t tier = 1; tier <= tree->upperTierZones.size(); ++tier)
+    {
+        for (const auto &zone : tree->upperTierZones[tier - 1])
+        {
+            zones.push_back(zone.second);
+            leaders.push_back(zone.first);
+            levels.push_back(static_cast<int>(tier));
+        }
     }
-    std::cout << "Node " << nodeId << ": Detection zones updated. My leader: " << myZoneLeaderId_ << ", My zone members: ";
-    for(NodeId member : myDetectionZoneMembers_) {
+}
+
+long long DetectionZoneManager::getTreeVersion()
+{
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    return tree->version;
+}
+
+std::map<int, std::vector<NodeId>> DetectionZoneManager::getLedZones()
+{
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    std::map<int, std::vector<NodeId>> led;
+    auto own = tree->zones.find(nodeId);
+    if (own != tree->zones.end())
+    {
+        led[0] = own->second;
+    }
+    else if (tree->replacedLeaderId != 0)
+    {
+        led[0] = tree->myZoneMembers;
+    }
+    for (size_t tier = 1; tier <= tree->upperTierZones.size(); ++tier)
+    {
+        auto it = tree->upperTierZones[tier - 1].find(nodeId);
+        if (it != tree->upperTierZones[tier - 1].end())
+        {
+            led[static_cast<int>(tier)] = it->second;
+        }
+    }
+    return led;
+}
+
+void DetectionZoneManager::updateMyZone(Snapshot &tree) const
+{
+    tree.myZoneMembers.clear(); 
+    tree.myZoneLeaderId = 0;
+    tree.replacedLeaderId = 0;
+    for (const auto &zone : tree.zones)
+    {
+        if (std::find(zone.second.begin(), zone.second.end(), nodeId) != zone.second.end())
+        {
+            tree.myZoneLeaderId = zone.first;
+            tree.myZoneMembers = zone.second;
+            return;
+        }
+    }
+}
+
+void DetectionZoneManager::printMyZone(const Snapshot &tree) const
+{
+    std::cout << "Node " << nodeId << ": Detection zones updated. My leader: " << tree.myZoneLeaderId << ", My zone members: ";
+    for(NodeId member : tree.myZoneMembers) {
         std::cout << member << " ";
     }
-    std::cout << "\n";
+    std::cout << "(" << tree.upperTierZones.size() + 1 << " tiers, version " << tree.version << ")\n";
 }
 
 std::unordered_map<NodeId, std::vector<NodeId>> DetectionZoneManager::getCurrentDetectionZones()
 {
-    std::unique_lock<std::mutex> lock(zoneMutex); 
-    return detectionZones; 
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    return tree->zones; 
 }
 
 NodeId DetectionZoneManager::getMyZoneLeaderId()
 {
-    std::unique_lock<std::mutex> lock(zoneMutex);
-    return myZoneLeaderId_;
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    return tree->myZoneLeaderId;
 }
 
 bool DetectionZoneManager::isZoneLeader()
 {
-    std::unique_lock<std::mutex> lock(zoneMutex);
-    return nodeId == myZoneLeaderId_;
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    return nodeId == tree->myZoneLeaderId;
+}
+
+std::vector<NodeId> DetectionZoneManager::getMyDetectionZoneMembers()
+{
+    return getSnapshot()->myZoneMembers;
+}
+
+int DetectionZoneManager::getDeputyRank(const Snapshot &tree) const
+{
+    int rank = 0;
+    for (NodeId member : tree.myZoneMembers)
+    {
+        if (member == nodeId)
+        {
+            return tree.myZoneLeaderId == nodeId ? -1 : rank;
+        }
+        if (member != tree.myZoneLeaderId)
+        {
+            rank++;
+        }
+    }
+    return -1;
+}
+
+bool DetectionZoneManager::takeOverZone(NodeId failedLeaderId)
+{
+    std::unique_lock<std::mutex> lock(updateMutex_);
+    std::shared_ptr<const Snapshot> current = getSnapshot();
+    if (current->myZoneLeaderId != failedLeaderId || failedLeaderId == nodeId)
+    {
+        return false;
+    }
+    auto tree = std::make_shared<Snapshot>(*current);
+    tree->myZoneLeaderId = nodeId;
+    tree->replacedLeaderId = failedLeaderId;
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(tree)));
+    return true;
+}
+
+void DetectionZoneManager::standDown()
+{
+    std::unique_lock<std::mutex> lock(updateMutex_);
+    std::shared_ptr<const Snapshot> current = getSnapshot();
+    if (current->replacedLeaderId == 0)
+    {
+        return;
+    }
+    auto tree = std::make_shared<Snapshot>(*current);
+    tree->myZoneLeaderId = tree->replacedLeaderId;
+    tree->replacedLeaderId = 0;
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(tree)));
+}
+
+NodeId DetectionZoneManager::getParentLeaderId(int level)
+{
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    for (size_t tier = level + 1; tier <= tree->upperTierZones.size(); ++tier)
+    {
+        for (const auto &zone : tree->upperTierZones[tier - 1])
+        {
+            if (std::find(zone.second.begin(), zone.second.end(), nodeId) != zone.second.end())
+            {
+                return zone.first;
+            }
+        }
+    }
+    return CENTRALIZED_NODE_ID;
+}
+
+std::vector<std::pair<int, NodeId>> DetectionZoneManager::getCentralReporters()
+{
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    auto reportsToTier = [&tree](NodeId leader, size_t level) {
+        for (size_t tier = level + 1; tier <= tree->upperTierZones.size(); ++tier)
+        {
+            for (const auto &zone : tree->upperTierZones[tier - 1])
+            {
+                if (std::find(zone.second.begin(), zone.second.end(), leader) != zone.second.end())
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+    std::vector<std::pair<int, NodeId>> reporters;
+    for (const auto &zone : tree->zones)
+    {
+        if (!reportsToTier(zone.first, 0))
+        {
+            reporters.push_back({0, zone.first});
+        }
+    }
+    for (size_t tier = 1; tier <= tree->upperTierZones.size(); ++tier)
+    {
+        for (const auto &zone : tree->upperTierZones[tier - 1])
+        {
+            if (!reportsToTier(zone.first, tier))
+            {
+                reporters.push_back({static_cast<int>(tier), zone.first});
+            }
+        }
+    }
+    return reporters;
 }
 
-const std::vector<NodeId>& DetectionZoneManager::getMyDetectionZoneMembers()
+int DetectionZoneManager::findLedZoneForReport(NodeId reporterId, int reporterLevel, std::vector<NodeId> &members)
 {
-    std::unique_lock<std::mutex> lock(zoneMutex);
-    return myDetectionZoneMembers_;
+    std::shared_ptr<const Snapshot> tree = getSnapshot();
+    for (size_t tier = reporterLevel + 1; tier <= tree->upperTierZones.size(); ++tier)
+    {
+        for (const auto &zone : tree->upperTierZones[tier - 1])
+        {
+            if (std::find(zone.second.begin(), zone.second.end(), reporterId) == zone.second.end())
+            {
+                continue;
+            }
+            // The reporter belongs to this zone, so it reports here whoever leads it.
+            if (zone.first != nodeId)
+            {
+                return -1;
+            }
+            members = zone.second;
+            return static_cast<int>(tier);
+        }
+    }
+    return -1;
 }
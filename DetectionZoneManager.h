@@ -6,19 +6,62 @@
 #include <vector>
 #include <mutex>
 #include <algorithm>
+#include <map>
+#include <memory>
 // DetectionZoneManager manages the detection zones in the HAWK deadlock detection scheme.
 // Each node uses this manager to understand its own zone, its zone leader, and the members
 // of its zone, which is crucial for the hierarchical and adaptive nature of HAWK.
+// Zones form a tree: tier-0 zones group nodes, and a zone of tier t > 0 groups the leaders
+// of lower-tier zones. Each leader reports to the leader of the lowest higher-tier zone it
+// belongs to, and leaders that belong to none report to CENTRALIZED_NODE_ID.
+// The tree is kept as an immutable snapshot: updates build a new one and publish it
+// atomically, so readers on the detection path never block and never see a half-applied
+// update.
 class DetectionZoneManager
 {
 public:
+    // One version of the detection tree as this node knows it.
+    struct Snapshot
+    {
+        long long version = 0; // 0 until the first tree from the central node
+        std::unordered_map<NodeId, std::vector<NodeId>> zones; // tier 0: leader -> members
+        // Zones above tier 0, indexed by tier - 1: leader -> members.
+        std::vector<std::unordered_map<NodeId, std::vector<NodeId>>> upperTierZones;
+        NodeId myZoneLeaderId = 0;
+        std::vector<NodeId> myZoneMembers;
+        // Set while this node leads its tier-0 zone in place of this stalled leader; the
+        // zones themselves are the central node's and stay as they were.
+        NodeId replacedLeaderId = 0;
+    };
+
     DetectionZoneManager(NodeId nodeId);
     // Updates the detection zones and their leaders based on information received
     // from a higher-level coordinator (e.g., the central node in HAWK).
     // This is a key function in HAWK as it allows zones to be dynamically reconfigured.
     // newZones: A vector of vectors, where each inner vector represents a detection zone.
     // newLeaders: A vector containing the leader NodeId for each corresponding detection zone.
-    void updateDetectionZones(const std::vector<std::vector<NodeId>> &newZones, const std::vector<NodeId>& newLeaders);
+    // newLevels: The tier of each zone; missing entries are tier 0.
+    void updateDetectionZones(const std::vector<std::vector<NodeId>> &newZones, const std::vector<NodeId>& newLeaders,
+                              const std::vector<int>& newLevels = {}, long long version = 0);
+
+    // Applies a DISTRIBUTED_DETECTION_INIT message: the whole tree, or a diff against
+    // baseTreeVersion. Returns false and keeps the current tree if this node is not at the
+    // diff's base version.
+    bool applyDetectionTree(const NetworkMessage &msg);
+
+    // Fills diff with the zones of the given tree that are new or have other members than in
+    // the current tree, and with the (tier, leader) keys of current zones it no longer has.
+    // Returns the number of zones changed or removed.
+    size_t diffDetectionTree(const std::vector<std::vector<NodeId>> &zones, const std::vector<NodeId> &leaders,
+                             const std::vector<int> &levels, NetworkMessage &diff);
+
+    // Copies the whole tree, tier-0 zones first.
+    void getDetectionTree(std::vector<std::vector<NodeId>> &zones, std::vector<NodeId> &leaders, std::vector<int> &levels);
+
+    long long getTreeVersion();
+
+    // Members of the zones this node leads, by tier.
+    std::map<int, std::vector<NodeId>> getLedZones();
 
     std::unordered_map<NodeId, std::vector<NodeId>> getCurrentDetectionZones();
 
@@ -26,15 +69,46 @@ public:
 
     bool isZoneLeader();
 
-    const std::vector<NodeId>& getMyDetectionZoneMembers();
+    std::vector<NodeId> getMyDetectionZoneMembers();
+
+    // The current tree. It stays valid, and unchanged, for as long as the caller holds it.
+    std::shared_ptr<const Snapshot> getSnapshot() const;
+
+    // This node's place in the line of deputies of its tier-0 zone: the other members in
+    // zone order, so every member agrees on it without a message. Returns -1 for the
+    // leader and for a node alone in its zone.
+    int getDeputyRank(const Snapshot &tree) const;
+
+    // Makes this node the leader of its tier-0 zone in place of failedLeaderId, until it
+    // stands down or the next tree arrives. Returns false if failedLeaderId does not lead
+    // this node's zone.
+    bool takeOverZone(NodeId failedLeaderId);
+    // Hands the zone back to the leader this node replaced, if it replaced one.
+    void standDown();
+
+    // Where this node sends the report of the tier-`level` zone it leads: the leader of the
+    // lowest zone above that tier containing this node, or CENTRALIZED_NODE_ID.
+    NodeId getParentLeaderId(int level);
+
+    // Finds the lowest zone above tier `reporterLevel` that this node leads and that has
+    // `reporterId` as a member. Returns its tier and copies its members, or returns -1.
+    int findLedZoneForReport(NodeId reporterId, int reporterLevel, std::vector<NodeId> &members);
+
+    // The (tier, leader) of every zone whose leader belongs to no zone above that tier,
+    // i.e. the reports CENTRALIZED_NODE_ID receives each round.
+    std::vector<std::pair<int, NodeId>> getCentralReporters();
 
 private:
-    NodeId nodeId;
-    std::unordered_map<NodeId, std::vector<NodeId>> detectionZones; 
-    std::mutex zoneMutex; 
+    // Fills in this node's own tier-0 zone.
+    void updateMyZone(Snapshot &tree) const;
+    void printMyZone(const Snapshot &tree) const;
+    // Completes tree and makes it the current snapshot; updateMutex_ must be held.
+    void publish(std::shared_ptr<Snapshot> tree);
 
-    NodeId myZoneLeaderId_; 
-    std::vector<NodeId> myDetectionZoneMembers_; 
+    NodeId nodeId;
+    // Read with std::atomic_load and replaced with std::atomic_store only.
+    std::shared_ptr<const Snapshot> snapshot_;
+    std::mutex updateMutex_; // serializes updates; readers never take it
 };
 
 #endif // HAWK_DETECTION_ZONE_MANAGER_H
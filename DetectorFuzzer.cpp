@@ -0,0 +1,1768 @@
+#include "DetectorFuzzer.h"
+#include "DeadlockDetector.h"
+#include "PAGManager.h"
+#include "ZonePartitioner.h"
+#include "LeaderElector.h"
+#include "PAGSampler.h"
+#include "DetectionZoneManager.h"
+#include "WFGValidator.h"
+#include "VictimRegistry.h"
+#include "VictimSelector.h"
+#include "DetectionModeSelector.h"
+#include "PAGTrace.h"
+#include "ZonePlanner.h"
+#include "ZoneQualityMonitor.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <unordered_set>
+#include <map>
+#include <cstdlib>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <new>
+
+namespace
+{
+// Heap allocations made by the calling thread, counted by the replacement operator new
+// below so the steady-state check can see whether findCycles allocates.
+thread_local long long threadAllocations = 0;
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    ++threadAllocations;
+    if (void *block = std::malloc(size != 0 ? size : 1))
+    {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+// GCC pairs the free below with the operator new that allocated the block once both are
+// inlined into a caller, and takes them for a mismatch.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void *block) noexcept
+{
+    std::free(block);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+void operator delete[](void *block) noexcept
+{
+    ::operator delete(block);
+}
+
+void operator delete(void *block, std::size_t) noexcept
+{
+    ::operator delete(block);
+}
+
+void operator delete[](void *block, std::size_t) noexcept
+{
+    ::operator delete(block);
+}
+
+namespace
+{
+// PAGManager reports every SCC, and DetectionModeSelector every round, on stdout, and
+// PAGTrace the traces it rejects on stderr; keep that out of the fuzzer's output.
+class ScopedSilence
+{
+public:
+    ScopedSilence() : saved_(std::cout.rdbuf(sink_.rdbuf())), savedErr_(std::cerr.rdbuf(sink_.rdbuf())) {}
+    ~ScopedSilence()
+    {
+        std::cout.rdbuf(saved_);
+        std::cerr.rdbuf(savedErr_);
+    }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf *saved_;
+    std::streambuf *savedErr_;
+};
+
+long long edgeKey(TransactionId from, TransactionId to)
+{
+    return (static_cast<long long>(from) << 32) | static_cast<unsigned int>(to);
+}
+
+double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+} // namespace
+
+DetectorFuzzer::DetectorFuzzer(unsigned int seed) : rng_(seed) {}
+
+size_t DetectorFuzzer::edgeCount(const WFG &graph)
+{
+    size_t edges = 0;
+    for (const auto &pair : graph)
+    {
+        edges += pair.second.size();
+    }
+    return edges;
+}
+
+void DetectorFuzzer::fail(const std::string &name, const std::string &error)
+{
+    failures_++;
+    std::cout << "FAIL [" << name << "]: " << error << "\n";
+}
+
+// --- Graph generators ---
+
+DetectorFuzzer::WFG DetectorFuzzer::randomGraph(int numVertices, int numEdges)
+{
+    std::uniform_int_distribution<int> vertex(1, numVertices);
+    WFG graph;
+    for (int i = 0; i < numEdges; ++i)
+    {
+        graph[vertex(rng_)].push_back(vertex(rng_));
+    }
+    return graph;
+}
+
+DetectorFuzzer::WFG DetectorFuzzer::acyclicGraph(int numVertices, int numEdges)
+{
+    std::uniform_int_distribution<int> vertex(1, numVertices);
+    WFG graph;
+    for (int i = 0; i < numEdges; ++i)
+    {
+        int a = vertex(rng_);
+        int b = vertex(rng_);
+        if (a == b)
+        {
+            continue;
+        }
+        graph[std::min(a, b)].push_back(std::max(a, b));
+    }
+    return graph;
+}
+
+DetectorFuzzer::WFG DetectorFuzzer::ringGraph(int numVertices)
+{
+    WFG graph;
+    for (int i = 1; i <= numVertices; ++i)
+    {
+        graph[i].push_back(i % numVertices + 1);
+    }
+    return graph;
+}
+
+// Rings that share a common hub plus a few random cross-links between rings.
+DetectorFuzzer::WFG DetectorFuzzer::overlappingRingsGraph(int numRings, int ringLength)
+{
+    WFG graph;
+    const TransactionId hub = 1;
+    TransactionId next = 2;
+    std::vector<TransactionId> all{hub};
+    for (int r = 0; r < numRings; ++r)
+    {
+        TransactionId prev = hub;
+        for (int i = 0; i < ringLength; ++i)
+        {
+            graph[prev].push_back(next);
+            all.push_back(next);
+            prev = next++;
+        }
+        graph[prev].push_back(hub);
+    }
+    std::uniform_int_distribution<size_t> pick(0, all.size() - 1);
+    for (int i = 0; i < numRings; ++i)
+    {
+        graph[all[pick(rng_)]].push_back(all[pick(rng_)]);
+    }
+    return graph;
+}
+
+DetectorFuzzer::WFG DetectorFuzzer::cliqueGraph(int numVertices)
+{
+    WFG graph;
+    for (int i = 1; i <= numVertices; ++i)
+    {
+        for (int j = 1; j <= numVertices; ++j)
+        {
+            if (i != j)
+            {
+                graph[i].push_back(j);
+            }
+        }
+    }
+    return graph;
+}
+
+WeightedPAG DetectorFuzzer::plantedPartitionPAG(int numClusters, int maxZoneSize, double &plantedCut)
+{
+    std::uniform_int_distribution<int> clusterSize(1, maxZoneSize);
+    std::uniform_real_distribution<double> heavy(5.0, 10.0);
+    WeightedPAG pag;
+    std::vector<std::vector<NodeId>> clusters;
+    NodeId next = 1;
+    for (int c = 0; c < numClusters; ++c)
+    {
+        std::vector<NodeId> cluster;
+        int size = clusterSize(rng_);
+        for (int i = 0; i < size; ++i)
+        {
+            cluster.push_back(next++);
+        }
+        // A ring keeps every cluster connected; extra chords make it denser.
+        for (int i = 0; i < size && size > 1; ++i)
+        {
+            pag[cluster[i]][cluster[(i + 1) % size]] += heavy(rng_);
+        }
+        std::uniform_int_distribution<int> member(0, size - 1);
+        for (int i = 0; i < size; ++i)
+        {
+            NodeId from = cluster[member(rng_)];
+            NodeId to = cluster[member(rng_)];
+            if (from != to)
+            {
+                pag[from][to] += heavy(rng_);
+            }
+        }
+        clusters.push_back(std::move(cluster));
+    }
+
+    plantedCut = 0.0;
+    if (numClusters > 1)
+    {
+        std::uniform_int_distribution<int> cluster(0, numClusters - 1);
+        for (int i = 0; i < numClusters; ++i)
+        {
+            int a = cluster(rng_);
+            int b = cluster(rng_);
+            if (a == b)
+            {
+                continue;
+            }
+            NodeId from = clusters[a][std::uniform_int_distribution<int>(0, clusters[a].size() - 1)(rng_)];
+            NodeId to = clusters[b][std::uniform_int_distribution<int>(0, clusters[b].size() - 1)(rng_)];
+            pag[from][to] += 1.0;
+            plantedCut += 1.0;
+        }
+    }
+    return pag;
+}
+
+WeightedPAG DetectorFuzzer::randomWeightedPAG(int numNodes, int numEdges)
+{
+    std::uniform_int_distribution<int> node(1, numNodes);
+    std::uniform_real_distribution<double> weight(PAG_MIN_EDGE_WEIGHT, 10.0);
+    WeightedPAG pag;
+    for (int i = 0; i < numEdges; ++i)
+    {
+        NodeId from = node(rng_);
+        NodeId to = node(rng_);
+        if (from != to)
+        {
+            pag[from][to] += weight(rng_);
+        }
+    }
+    return pag;
+}
+
+// --- Oracle ---
+
+std::unordered_map<TransactionId, bool> DetectorFuzzer::bruteForceCyclicVertices(const WFG &graph)
+{
+    std::unordered_set<TransactionId> vertices;
+    for (const auto &pair : graph)
+    {
+        vertices.insert(pair.first);
+        vertices.insert(pair.second.begin(), pair.second.end());
+    }
+
+    std::unordered_map<TransactionId, bool> cyclic;
+    for (TransactionId start : vertices)
+    {
+        std::unordered_set<TransactionId> seen;
+        std::vector<TransactionId> frontier{start};
+        bool reachesItself = false;
+        while (!frontier.empty() && !reachesItself)
+        {
+            TransactionId u = frontier.back();
+            frontier.pop_back();
+            auto it = graph.find(u);
+            if (it == graph.end())
+            {
+                continue;
+            }
+            for (TransactionId v : it->second)
+            {
+                if (v == start)
+                {
+                    reachesItself = true;
+                    break;
+                }
+                if (seen.insert(v).second)
+                {
+                    frontier.push_back(v);
+                }
+            }
+        }
+        cyclic[start] = reachesItself;
+    }
+    return cyclic;
+}
+
+std::unordered_map<TransactionId, int> DetectorFuzzer::kosarajuComponents(const WFG &graph)
+{
+    WFG reverse;
+    std::vector<TransactionId> vertices;
+    std::unordered_set<TransactionId> known;
+    for (const auto &pair : graph)
+    {
+        if (known.insert(pair.first).second)
+        {
+            vertices.push_back(pair.first);
+        }
+        for (TransactionId v : pair.second)
+        {
+            reverse[v].push_back(pair.first);
+            if (known.insert(v).second)
+            {
+                vertices.push_back(v);
+            }
+        }
+    }
+
+    // First pass: finishing order on the forward graph.
+    std::vector<TransactionId> order;
+    std::unordered_set<TransactionId> visited;
+    for (TransactionId root : vertices)
+    {
+        if (!visited.insert(root).second)
+        {
+            continue;
+        }
+        std::vector<std::pair<TransactionId, size_t>> stack{{root, 0}};
+        while (!stack.empty())
+        {
+            TransactionId u = stack.back().first;
+            auto it = graph.find(u);
+            size_t &next = stack.back().second;
+            if (it != graph.end() && next < it->second.size())
+            {
+                TransactionId v = it->second[next++];
+                if (visited.insert(v).second)
+                {
+                    stack.push_back({v, 0});
+                }
+            }
+            else
+            {
+                order.push_back(u);
+                stack.pop_back();
+            }
+        }
+    }
+
+    // Second pass: collect components on the reverse graph in reverse finishing order.
+    std::unordered_map<TransactionId, int> component;
+    int nextComponent = 0;
+    for (auto rit = order.rbegin(); rit != order.rend(); ++rit)
+    {
+        if (component.count(*rit))
+        {
+            continue;
+        }
+        std::vector<TransactionId> stack{*rit};
+        component[*rit] = nextComponent;
+        while (!stack.empty())
+        {
+            TransactionId u = stack.back();
+            stack.pop_back();
+            auto it = reverse.find(u);
+            if (it == reverse.end())
+            {
+                continue;
+            }
+            for (TransactionId v : it->second)
+            {
+                if (component.emplace(v, nextComponent).second)
+                {
+                    stack.push_back(v);
+                }
+            }
+        }
+        nextComponent++;
+    }
+    return component;
+}
+
+std::vector<std::vector<TransactionId>> DetectorFuzzer::cyclicComponents(const WFG &graph)
+{
+    std::unordered_map<TransactionId, int> component = kosarajuComponents(graph);
+    std::unordered_map<int, std::vector<TransactionId>> members;
+    for (const auto &pair : component)
+    {
+        members[pair.second].push_back(pair.first);
+    }
+    std::unordered_set<int> selfLoops;
+    for (const auto &pair : graph)
+    {
+        if (std::find(pair.second.begin(), pair.second.end(), pair.first) != pair.second.end())
+        {
+            selfLoops.insert(component[pair.first]);
+        }
+    }
+
+    std::vector<std::vector<TransactionId>> cyclic;
+    for (auto &pair : members)
+    {
+        if (pair.second.size() > 1 || selfLoops.count(pair.first))
+        {
+            cyclic.push_back(std::move(pair.second));
+        }
+    }
+    return cyclic;
+}
+
+// --- Checks ---
+
+bool DetectorFuzzer::cyclesAreValid(const WFG &graph, const std::vector<std::vector<TransactionId>> &cycles,
+                                    std::string &error)
+{
+    std::unordered_set<long long> edges;
+    for (const auto &pair : graph)
+    {
+        for (TransactionId v : pair.second)
+        {
+            edges.insert(edgeKey(pair.first, v));
+        }
+    }
+    for (const auto &cycle : cycles)
+    {
+        if (cycle.empty())
+        {
+            error = "empty cycle reported";
+            return false;
+        }
+        std::unordered_set<TransactionId> distinct(cycle.begin(), cycle.end());
+        if (distinct.size() != cycle.size())
+        {
+            error = "cycle repeats a transaction";
+            return false;
+        }
+        for (size_t i = 0; i < cycle.size(); ++i)
+        {
+            TransactionId from = cycle[i];
+            TransactionId to = cycle[(i + 1) % cycle.size()];
+            if (!edges.count(edgeKey(from, to)))
+            {
+                error = "reported cycle uses missing edge T" + std::to_string(from) + " -> T" + std::to_string(to);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool DetectorFuzzer::cyclesCoverComponents(const std::vector<std::vector<TransactionId>> &components,
+                                           const std::vector<std::vector<TransactionId>> &cycles, std::string &error)
+{
+    std::unordered_set<TransactionId> onReportedCycle;
+    for (const auto &cycle : cycles)
+    {
+        onReportedCycle.insert(cycle.begin(), cycle.end());
+    }
+    for (const auto &component : components)
+    {
+        bool covered = std::any_of(component.begin(), component.end(),
+                                   [&](TransactionId t) { return onReportedCycle.count(t) > 0; });
+        if (!covered)
+        {
+            error = "cyclic SCC of " + std::to_string(component.size()) + " transactions (e.g. T" +
+                    std::to_string(component[0]) + ") has no reported cycle";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DetectorFuzzer::checkDetector(const std::string &name, const WFG &graph, bool useBruteForce)
+{
+    DeadlockDetector detector;
+    CycleSet cycleSet;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    detector.findCycles(graph, cycleSet);
+    double detectMs = elapsedMs(start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<std::vector<TransactionId>> components = cyclicComponents(graph);
+    double oracleMs = elapsedMs(start);
+
+    std::vector<std::vector<TransactionId>> cycles = cycleSet.toVectors();
+    std::string error;
+    if (!cyclesAreValid(graph, cycles, error) || !cyclesCoverComponents(components, cycles, error))
+    {
+        fail(name, error);
+        return false;
+    }
+
+    if (useBruteForce)
+    {
+        // Cross-check the SCC oracle itself against plain self-reachability.
+        std::unordered_set<TransactionId> sccCyclic;
+        for (const auto &component : components)
+        {
+            sccCyclic.insert(component.begin(), component.end());
+        }
+        for (const auto &pair : bruteForceCyclicVertices(graph))
+        {
+            if (pair.second != (sccCyclic.count(pair.first) > 0))
+            {
+                fail(name, "oracle disagreement on T" + std::to_string(pair.first));
+                return false;
+            }
+        }
+    }
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << graph.size() << std::setw(10) << edgeCount(graph)
+              << std::setw(9) << cycleSet.size() << std::setw(12) << std::fixed << std::setprecision(3) << detectMs
+              << std::setw(12) << oracleMs << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkSteadyStateAllocations(const std::string &name, const WFG &graph)
+{
+    WFGPairs pairs(graph.begin(), graph.end());
+    WFGView view{&pairs};
+    DeadlockDetector detector;
+    CycleSet cycleSet;
+    // The first rounds grow the workspace and the output buffer to the working-set size.
+    for (int round = 0; round < 2; ++round)
+    {
+        detector.findCycles(graph, cycleSet);
+        detector.findCycles(view, cycleSet);
+    }
+
+    long long before = threadAllocations;
+    for (int round = 0; round < 10; ++round)
+    {
+        detector.findCycles(graph, cycleSet);
+        detector.findCycles(view, cycleSet);
+    }
+    long long allocations = threadAllocations - before;
+    if (allocations != 0)
+    {
+        fail(name, std::to_string(allocations) + " heap allocations in 20 warm findCycles calls");
+        return false;
+    }
+    return true;
+}
+
+bool DetectorFuzzer::checkPAGCut(const std::string &name, const WFG &pag, int threshold)
+{
+    PAGManager pagManager;
+    std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>> cut;
+    double cutMs = 0.0;
+    {
+        ScopedSilence silence;
+        // The central node reuses one PAGManager, so time the cut once its workspace is warm.
+        pagManager.greedySCCcut(pag, threshold);
+        auto start = std::chrono::high_resolution_clock::now();
+        cut = pagManager.greedySCCcut(pag, threshold);
+        cutMs = elapsedMs(start);
+    }
+    const auto &zones = cut.first;
+    const auto &leaders = cut.second;
+
+    if (zones.size() != leaders.size())
+    {
+        fail(name, "zone and leader counts differ");
+        return false;
+    }
+
+    std::unordered_map<NodeId, int> zoneOf;
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        for (NodeId node : zones[z])
+        {
+            if (!zoneOf.emplace(node, static_cast<int>(z)).second)
+            {
+                fail(name, "node " + std::to_string(node) + " assigned to two zones");
+                return false;
+            }
+        }
+        if (zones[z].empty() || *std::min_element(zones[z].begin(), zones[z].end()) != leaders[z])
+        {
+            fail(name, "zone leader is not the lowest member");
+            return false;
+        }
+    }
+
+    // Every PAG node must be covered, and the multi-node zones must be exactly the
+    // oracle's SCCs that reach the threshold.
+    std::unordered_map<TransactionId, int> component = kosarajuComponents(pag);
+    std::unordered_map<int, size_t> componentSize;
+    for (const auto &pair : component)
+    {
+        componentSize[pair.second]++;
+        if (!zoneOf.count(pair.first))
+        {
+            fail(name, "node " + std::to_string(pair.first) + " is not in any zone");
+            return false;
+        }
+    }
+    for (const auto &zone : zones)
+    {
+        int c = component.at(zone[0]);
+        bool kept = componentSize[c] >= static_cast<size_t>(threshold);
+        size_t expectedSize = kept ? componentSize[c] : 1;
+        bool sameComponent = std::all_of(zone.begin(), zone.end(), [&](NodeId n) { return component.at(n) == c; });
+        if (zone.size() != expectedSize || !sameComponent)
+        {
+            fail(name, "zone of " + std::to_string(zone.size()) + " nodes does not match its SCC");
+            return false;
+        }
+    }
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << component.size() << std::setw(10) << edgeCount(pag)
+              << std::setw(9) << zones.size() << std::setw(12) << std::fixed << std::setprecision(3) << cutMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkBalancedPartition(const std::string &name, const WeightedPAG &pag, int maxZoneSize,
+                                            double maxCut)
+{
+    ZonePartitioner partitioner;
+    std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>> result;
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        ScopedSilence silence;
+        result = partitioner.partition(pag, maxZoneSize, 0.0);
+    }
+    double partitionMs = elapsedMs(start);
+    const auto &zones = result.first;
+    const auto &leaders = result.second;
+
+    if (zones.size() != leaders.size())
+    {
+        fail(name, "zone and leader counts differ");
+        return false;
+    }
+    std::unordered_set<NodeId> covered;
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        if (zones[z].empty() || zones[z].size() > static_cast<size_t>(maxZoneSize))
+        {
+            fail(name, "zone of " + std::to_string(zones[z].size()) + " nodes exceeds the bound of " +
+                           std::to_string(maxZoneSize));
+            return false;
+        }
+        if (*std::min_element(zones[z].begin(), zones[z].end()) != leaders[z])
+        {
+            fail(name, "zone leader is not the lowest member");
+            return false;
+        }
+        for (NodeId node : zones[z])
+        {
+            if (!covered.insert(node).second)
+            {
+                fail(name, "node " + std::to_string(node) + " assigned to two zones");
+                return false;
+            }
+        }
+    }
+    size_t edges = 0;
+    for (const auto &pair : pag)
+    {
+        for (const auto &neighbor : pair.second)
+        {
+            edges++;
+            if (!covered.count(pair.first) || !covered.count(neighbor.first))
+            {
+                fail(name, "node with PAG edges is not in any zone");
+                return false;
+            }
+        }
+    }
+
+    double cut = ZonePartitioner::cutWeight(pag, zones);
+    if (maxCut >= 0.0 && cut > maxCut + 1e-6)
+    {
+        std::ostringstream error;
+        error << "cut weight " << cut << " is heavier than the planted partition's " << maxCut;
+        fail(name, error.str());
+        return false;
+    }
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << covered.size() << std::setw(10) << edges
+              << std::setw(9) << zones.size() << std::setw(12) << std::fixed << std::setprecision(3) << partitionMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+// Simulates HAWK's detection tree on a WFG whose transactions are spread over numNodes
+// nodes. Transaction t lives on node (t % numNodes) + 1. A transaction waits for one
+// resource at a time, so all of its out-edges are reported by one node, here the home node
+// of the first transaction it waits for. Zones come from the PAG of cross-node edges and
+// are grouped into tiers of at most `fanout` leaders exactly as on the central node; each
+// leader detects cycles in the reports of its members and forwards only the residual graph.
+bool DetectorFuzzer::checkHawk(const std::string &name, const WFG &graph, int numNodes, int maxZoneSize, int fanout)
+{
+    auto homeNode = [numNodes](TransactionId t) { return static_cast<NodeId>(t % numNodes) + 1; };
+
+    std::vector<WFDEdge> pagEdges;
+    for (const auto &pair : graph)
+    {
+        for (TransactionId v : pair.second)
+        {
+            if (homeNode(pair.first) != homeNode(v))
+            {
+                pagEdges.push_back({pair.first, v, homeNode(pair.first), homeNode(v)});
+            }
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    PAGManager pagManager;
+    ZonePartitioner partitioner;
+    std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>> cut;
+    std::vector<int> levels;
+    {
+        ScopedSilence silence;
+        pagManager.accumulateSample(pagEdges);
+        cut = maxZoneSize > 0 ? partitioner.partition(pagManager.getWeightedPAG(), maxZoneSize, 0.0)
+                              : pagManager.greedySCCcut(pagManager.generatePAG(pagEdges), SCC_CUT_THRESHOLD);
+        PAGManager::addSingletonZones(cut.first, cut.second, numNodes);
+        levels.assign(cut.first.size(), 0);
+        partitioner.buildHierarchy(pagManager.getWeightedPAG(), cut.first, cut.second, levels, fanout);
+    }
+    const auto &zones = cut.first;
+    const auto &leaders = cut.second;
+
+    // Zones are appended tier by tier, so one pass in order sees every report before its
+    // receiver runs. parent[z] is the zone the leader of z reports to, -1 for the root.
+    std::vector<int> zoneOf(numNodes + 1, -1);
+    std::vector<int> parent(zones.size(), -1);
+    int rootReporters = 0;
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        if (levels[z] == 0)
+        {
+            for (NodeId node : zones[z])
+            {
+                zoneOf[node] = static_cast<int>(z);
+            }
+        }
+        else if (zones[z].size() > static_cast<size_t>(fanout) ||
+                 std::find(zones[z].begin(), zones[z].end(), leaders[z]) == zones[z].end())
+        {
+            fail(name, "tier-" + std::to_string(levels[z]) + " zone exceeds the fanout or lacks its leader");
+            return false;
+        }
+        for (size_t p = z + 1; p < zones.size() && parent[z] == -1; ++p)
+        {
+            if (levels[p] > levels[z] && std::find(zones[p].begin(), zones[p].end(), leaders[z]) != zones[p].end())
+            {
+                parent[z] = static_cast<int>(p);
+            }
+        }
+        if (parent[z] == -1)
+        {
+            rootReporters++;
+        }
+    }
+    if (rootReporters > fanout)
+    {
+        fail(name, std::to_string(rootReporters) + " leaders report to the central node");
+        return false;
+    }
+
+    // Tier-0 leaders read their members' reports as one view, as in the live system;
+    // upper tiers merge the residual graphs they receive.
+    std::vector<WFGPairs> reports(numNodes + 1);
+    for (const auto &pair : graph)
+    {
+        if (!pair.second.empty())
+        {
+            reports[homeNode(pair.second[0])].push_back(pair);
+        }
+    }
+    // An entry of a tier-0 zone is a transaction waited for by an edge reported outside it.
+    // waitedFrom holds the reporting zone, or -1 once edges from two zones were seen.
+    std::unordered_map<TransactionId, int> waitedFrom;
+    for (const auto &pair : graph)
+    {
+        if (pair.second.empty())
+        {
+            continue;
+        }
+        int reporterZone = zoneOf[homeNode(pair.second[0])];
+        for (TransactionId v : pair.second)
+        {
+            auto it = waitedFrom.emplace(v, reporterZone).first;
+            if (it->second != reporterZone)
+            {
+                it->second = -1;
+            }
+        }
+    }
+    std::vector<WFG> inbox(zones.size());
+    WFGView view;
+    std::unordered_set<TransactionId> entries;
+
+    DeadlockDetector detector;
+    CycleSet cycleSet;
+    std::vector<std::vector<TransactionId>> allCycles;
+    WFG centralGraph;
+    size_t zoneCycles = 0;
+    size_t upperTierCycles = 0;
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        view.clear();
+        for (NodeId node : zones[z])
+        {
+            view.push_back(&reports[node]);
+        }
+        if (levels[z] == 0)
+        {
+            detector.findCycles(view, cycleSet);
+        }
+        else
+        {
+            detector.findCycles(inbox[z], cycleSet);
+        }
+        (levels[z] == 0 ? zoneCycles : upperTierCycles) += cycleSet.size();
+        for (auto &cycle : cycleSet.toVectors())
+        {
+            allCycles.push_back(std::move(cycle));
+        }
+        WFG &receiver = parent[z] == -1 ? centralGraph : inbox[parent[z]];
+        WFG residual;
+        if (levels[z] == 0)
+        {
+            // Only entries with out-edges in the zone matter.
+            entries.clear();
+            for (const WFGPairs *part : view)
+            {
+                for (const auto &pair : *part)
+                {
+                    auto it = waitedFrom.find(pair.first);
+                    if (it != waitedFrom.end() && it->second != static_cast<int>(z))
+                    {
+                        entries.insert(pair.first);
+                    }
+                }
+            }
+            residual = DeadlockDetector::residualGraph(view, entries);
+        }
+        else
+        {
+            residual = DeadlockDetector::residualGraph(inbox[z]);
+        }
+        for (const auto &pair : residual)
+        {
+            auto &targets = receiver[pair.first];
+            targets.insert(targets.end(), pair.second.begin(), pair.second.end());
+        }
+        WFG().swap(inbox[z]);
+    }
+    detector.findCycles(centralGraph, cycleSet);
+    size_t centralCycles = cycleSet.size();
+    for (auto &cycle : cycleSet.toVectors())
+    {
+        allCycles.push_back(std::move(cycle));
+    }
+    double hawkMs = elapsedMs(start);
+
+    std::string error;
+    if (!cyclesAreValid(graph, allCycles, error) ||
+        !cyclesCoverComponents(cyclicComponents(graph), allCycles, error))
+    {
+        fail(name, error);
+        return false;
+    }
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << graph.size() << std::setw(10) << edgeCount(graph)
+              << std::setw(12) << (std::to_string(zoneCycles) + "/" + std::to_string(upperTierCycles) + "/" +
+                                  std::to_string(centralCycles))
+              << std::setw(12) << std::fixed << std::setprecision(3) << hawkMs
+              << std::setw(12) << zones.size() << " zones, " << levels.back() + 1 << " tiers, "
+              << edgeCount(centralGraph) << " central edges\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkPAGSampler(const std::string &name, int numNodes, int numWaits, size_t capacity)
+{
+    // Half the waits go to a few hot pairs, the rest are spread over all pairs.
+    std::uniform_int_distribution<int> node(1, numNodes);
+    std::uniform_int_distribution<int> hotPair(0, 3);
+    std::bernoulli_distribution hot(0.5);
+    std::vector<std::pair<NodeId, NodeId>> hotPairs;
+    for (int i = 0; i < 4; ++i)
+    {
+        hotPairs.push_back({node(rng_), node(rng_)});
+    }
+    std::map<std::pair<NodeId, NodeId>, long long> truth;
+    PAGSampler sampler(capacity);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numWaits; ++i)
+    {
+        std::pair<NodeId, NodeId> pair = hot(rng_) ? hotPairs[hotPair(rng_)] : std::make_pair(node(rng_), node(rng_));
+        sampler.recordWait(pair.first, pair.second);
+        truth[pair]++;
+    }
+    std::vector<PAGPairCount> summary = sampler.drain();
+    double sampleMs = elapsedMs(start);
+
+    if (summary.size() > capacity)
+    {
+        fail(name, std::to_string(summary.size()) + " pairs reported with a capacity of " + std::to_string(capacity));
+        return false;
+    }
+    long long slack = numWaits / static_cast<long long>(capacity);
+    std::map<std::pair<NodeId, NodeId>, long long> reported;
+    for (const PAGPairCount &pair : summary)
+    {
+        long long actual = truth[{pair.waitingNodeId, pair.holdingNodeId}];
+        if (pair.count > actual || pair.count < actual - slack)
+        {
+            fail(name, "pair " + std::to_string(pair.waitingNodeId) + "->" + std::to_string(pair.holdingNodeId) +
+                           " reported " + std::to_string(pair.count) + " waits, saw " + std::to_string(actual));
+            return false;
+        }
+        reported[{pair.waitingNodeId, pair.holdingNodeId}] = pair.count;
+    }
+    for (const auto &pair : truth)
+    {
+        if (pair.second > slack && !reported.count(pair.first))
+        {
+            fail(name, "heavy pair " + std::to_string(pair.first.first) + "->" + std::to_string(pair.first.second) +
+                           " with " + std::to_string(pair.second) + " waits was dropped");
+            return false;
+        }
+    }
+    if (!sampler.drain().empty())
+    {
+        fail(name, "drain did not start a new round");
+        return false;
+    }
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << truth.size() << std::setw(10) << numWaits
+              << std::setw(9) << summary.size() << std::setw(12) << std::fixed << std::setprecision(3) << sampleMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkIncrementalZones(const std::string &name, const WeightedPAG &pag, const WeightedPAG &drift,
+                                           int maxZoneSize)
+{
+    ZonePartitioner partitioner;
+    std::vector<std::vector<NodeId>> zones;
+    std::vector<NodeId> leaders;
+    std::vector<int> levels;
+    WeightedPAG drifted = pag;
+    for (const auto &pair : drift)
+    {
+        for (const auto &neighbor : pair.second)
+        {
+            drifted[pair.first][neighbor.first] += neighbor.second;
+        }
+    }
+    std::vector<std::vector<NodeId>> newZones;
+    std::vector<NodeId> newLeaders;
+    std::vector<int> newLevels;
+    int moved = 0;
+    double cutBefore = 0.0;
+    DetectionZoneManager sender(1);
+    DetectionZoneManager receiver(1);
+    NetworkMessage diff;
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        ScopedSilence silence;
+        auto result = partitioner.partition(pag, maxZoneSize);
+        zones = result.first;
+        leaders = result.second;
+        levels.assign(zones.size(), 0);
+        cutBefore = ZonePartitioner::cutWeight(drifted, zones);
+        newZones = zones;
+        newLeaders = leaders;
+        moved = partitioner.repartition(drifted, newZones, newLeaders, maxZoneSize, ZONE_MOVE_MIN_GAIN);
+        newLevels.assign(newZones.size(), 0);
+
+        partitioner.buildHierarchy(pag, zones, leaders, levels, 2);
+        partitioner.buildHierarchy(drifted, newZones, newLeaders, newLevels, 2);
+        sender.updateDetectionZones(zones, leaders, levels, 1);
+        receiver.updateDetectionZones(zones, leaders, levels, 1);
+        sender.diffDetectionTree(newZones, newLeaders, newLevels, diff);
+        diff.treeVersion = 2;
+        receiver.applyDetectionTree(diff);
+    }
+    double repartitionMs = elapsedMs(start);
+
+    std::unordered_set<NodeId> covered;
+    size_t edges = 0;
+    for (size_t z = 0; z < newZones.size(); ++z)
+    {
+        if (newLevels[z] > 0)
+        {
+            continue;
+        }
+        if (newZones[z].empty() || newZones[z].size() > static_cast<size_t>(maxZoneSize))
+        {
+            fail(name, "zone of " + std::to_string(newZones[z].size()) + " nodes after repartition");
+            return false;
+        }
+        if (!std::binary_search(newZones[z].begin(), newZones[z].end(), newLeaders[z]))
+        {
+            fail(name, "zone leader is not a member after repartition");
+            return false;
+        }
+        for (NodeId node : newZones[z])
+        {
+            if (!covered.insert(node).second)
+            {
+                fail(name, "node " + std::to_string(node) + " assigned to two zones after repartition");
+                return false;
+            }
+        }
+    }
+    for (const auto &pair : drifted)
+    {
+        edges += pair.second.size();
+        for (const auto &neighbor : pair.second)
+        {
+            if (neighbor.second >= PAG_MIN_EDGE_WEIGHT && neighbor.first != pair.first &&
+                (!covered.count(pair.first) || !covered.count(neighbor.first)))
+            {
+                fail(name, "node with PAG edges is not in any zone after repartition");
+                return false;
+            }
+        }
+    }
+    std::vector<std::vector<NodeId>> tier0;
+    for (size_t z = 0; z < newZones.size(); ++z)
+    {
+        if (newLevels[z] == 0)
+        {
+            tier0.push_back(newZones[z]);
+        }
+    }
+    double cutAfter = ZonePartitioner::cutWeight(drifted, tier0);
+    if (cutAfter > cutBefore + 1e-6)
+    {
+        std::ostringstream error;
+        error << "repartition raised the cut weight from " << cutBefore << " to " << cutAfter;
+        fail(name, error.str());
+        return false;
+    }
+
+    // The receiver saw the old tree and the diff only; it has to end up with the new tree.
+    std::vector<std::vector<NodeId>> appliedZones;
+    std::vector<NodeId> appliedLeaders;
+    std::vector<int> appliedLevels;
+    receiver.getDetectionTree(appliedZones, appliedLeaders, appliedLevels);
+    std::map<std::pair<int, NodeId>, std::vector<NodeId>> expected;
+    std::map<std::pair<int, NodeId>, std::vector<NodeId>> applied;
+    for (size_t z = 0; z < newZones.size(); ++z)
+    {
+        expected[{newLevels[z], newLeaders[z]}] = newZones[z];
+    }
+    for (size_t z = 0; z < appliedZones.size(); ++z)
+    {
+        applied[{appliedLevels[z], appliedLeaders[z]}] = appliedZones[z];
+    }
+    if (applied != expected || receiver.getTreeVersion() != 2)
+    {
+        fail(name, "applying the tree diff did not reproduce the new tree");
+        return false;
+    }
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << covered.size() << std::setw(10) << edges
+              << std::setw(9) << moved << std::setw(12) << std::fixed << std::setprecision(3) << repartitionMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkLeaderElection(const std::string &name, int zoneSize)
+{
+    WeightedPAG pag;
+    std::vector<NodeId> zone;
+    for (NodeId node = 1; node <= zoneSize; ++node)
+    {
+        zone.push_back(node);
+        pag[node][node % zoneSize + 1] = 1.0;
+    }
+    std::uniform_int_distribution<int> loadValue(0, 1000);
+    std::uniform_real_distribution<double> jitter(0.95, 1.05);
+    std::vector<NodeLoad> loads;
+    for (NodeId node : zone)
+    {
+        loads.push_back({node, loadValue(rng_), loadValue(rng_), loadValue(rng_), 0, 0});
+    }
+
+    LeaderElector elector;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const NodeLoad &load : loads)
+    {
+        elector.recordLoad(load);
+    }
+    NodeId leader = elector.electLeader(pag, zone, 0);
+    if (std::find(zone.begin(), zone.end(), leader) == zone.end())
+    {
+        fail(name, "leader " + std::to_string(leader) + " is not a zone member");
+        return false;
+    }
+    {
+        ScopedSilence silence;
+        elector.setSittingLeaders({leader}, {0});
+    }
+
+    // A few percent of load noise must not move the leadership.
+    for (NodeLoad &load : loads)
+    {
+        load.detectionTimeUs = static_cast<long long>(load.detectionTimeUs * jitter(rng_));
+        load.activeTransactions = static_cast<int>(load.activeTransactions * jitter(rng_));
+        load.queueDepth = static_cast<int>(load.queueDepth * jitter(rng_));
+        elector.recordLoad(load);
+    }
+    if (elector.electLeader(pag, zone, 0) != leader)
+    {
+        fail(name, "leadership moved on load noise");
+        return false;
+    }
+
+    // Once the leader carries all the load, another member has to take over.
+    for (int round = 0; round < 30; ++round)
+    {
+        for (NodeId node : zone)
+        {
+            int load = node == leader ? 1000000 : 0;
+            elector.recordLoad({node, load, load, load, 0, 0});
+        }
+    }
+    if (zoneSize > 1 && elector.electLeader(pag, zone, 0) == leader)
+    {
+        fail(name, "overloaded leader " + std::to_string(leader) + " kept its zone");
+        return false;
+    }
+    double electMs = elapsedMs(start);
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << zoneSize << std::setw(10) << pag.size()
+              << std::setw(9) << "-" << std::setw(12) << std::fixed << std::setprecision(3) << electMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkWFGValidator(const std::string &name, int ringLength, int numReporters)
+{
+    // Ring 1 -> 2 -> ... -> ringLength -> 1. Each edge is reported in snapshot epoch 1 by
+    // the home node of its waiting transaction, with both ends in their first lifetime.
+    auto homeOf = [numReporters](TransactionId trans) { return static_cast<NodeId>(1 + trans % numReporters); };
+    auto lifetime = [&homeOf](TransactionId trans, long long sequence) {
+        return makeIncarnation(homeOf(trans), static_cast<long long>(trans) * 8 + sequence);
+    };
+    WFGPairs ring;
+    std::vector<WFGEdgeTag> tags;
+    for (TransactionId trans = 1; trans <= ringLength; ++trans)
+    {
+        TransactionId next = trans % ringLength + 1;
+        ring.push_back({trans, {next}});
+        tags.push_back({trans, next, homeOf(trans), 1, lifetime(trans, 0), lifetime(next, 0)});
+    }
+    WFGView view{&ring};
+    DeadlockDetector detector;
+    CycleSet cycles;
+    auto start = std::chrono::high_resolution_clock::now();
+    detector.findCycles(view, cycles);
+    if (cycles.size() != 1)
+    {
+        fail(name, "expected one cycle in a ring, found " + std::to_string(cycles.size()));
+        return false;
+    }
+
+    WFGValidator current;
+    current.addEdgeTags(tags);
+    if (!current.isCycleConsistent(cycles, 0))
+    {
+        fail(name, "a ring reported in one consistent snapshot was rejected");
+        return false;
+    }
+
+    // One reporter moves on to epoch 2, in which its edges of the ring are gone. A late
+    // epoch-1 report must not bring them back.
+    std::uniform_int_distribution<int> pick(1, ringLength);
+    NodeId stale = homeOf(pick(rng_));
+    WFGValidator validator;
+    validator.addEdgeTags(tags);
+    TransactionId unrelated = ringLength + 1;
+    validator.addEdgeTags({{unrelated, unrelated + 1, stale, 2, lifetime(unrelated, 0), lifetime(unrelated + 1, 0)}});
+    validator.addEdgeTags(tags);
+    size_t staleEdges = 0;
+    for (const WFGEdgeTag &tag : tags)
+    {
+        bool expectCurrent = tag.reporterNodeId != stale;
+        staleEdges += expectCurrent ? 0 : 1;
+        if ((validator.findCurrentTag(tag.waitingTransId, tag.holdingTransId) != nullptr) != expectCurrent)
+        {
+            fail(name, "edge " + std::to_string(tag.waitingTransId) + " -> " + std::to_string(tag.holdingTransId) +
+                           (expectCurrent ? " lost its current tag" : " kept a tag from an outdated snapshot"));
+            return false;
+        }
+    }
+    WFGPairs pruned = ring;
+    validator.pruneReport(pruned);
+    size_t kept = 0;
+    for (const auto &pair : pruned)
+    {
+        kept += pair.second.size();
+    }
+    if (kept + staleEdges != ring.size())
+    {
+        fail(name, "pruning kept " + std::to_string(kept) + " of " + std::to_string(ring.size()) + " edges, " +
+                       std::to_string(staleEdges) + " of them stale");
+        return false;
+    }
+    if (validator.isCycleConsistent(cycles, 0))
+    {
+        fail(name, "a ring with edges from an outdated snapshot was accepted");
+        return false;
+    }
+
+    // One member restarted between two reports: the edge into it names its first
+    // lifetime, the edge out of it the second. That ring is a phantom.
+    TransactionId restarted = pick(rng_);
+    std::vector<WFGEdgeTag> mixed = tags;
+    for (WFGEdgeTag &tag : mixed)
+    {
+        if (tag.waitingTransId == restarted)
+        {
+            tag.waitingIncarnation = lifetime(restarted, 1);
+        }
+    }
+    WFGValidator phantom;
+    phantom.addEdgeTags(mixed);
+    if (phantom.isCycleConsistent(cycles, 0))
+    {
+        fail(name, "a ring through two lifetimes of transaction " + std::to_string(restarted) + " was accepted");
+        return false;
+    }
+    double validateMs = elapsedMs(start);
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << ringLength << std::setw(10) << ring.size()
+              << std::setw(9) << cycles.size() << std::setw(12) << std::fixed << std::setprecision(3) << validateMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkDuplicateVictims(const std::string &name, int ringLength)
+{
+    // Ring 1 -> 2 -> ... -> ringLength -> 1 across two zones: nodes 1 and 2 each report
+    // the edges of the transactions homed on them, with the cost of each.
+    auto homeOf = [](TransactionId trans) { return static_cast<NodeId>(1 + trans % 2); };
+    auto lifetime = [&homeOf](TransactionId trans) { return makeIncarnation(homeOf(trans), trans); };
+    std::uniform_int_distribution<int> statements(0, 20);
+    std::vector<WFGPairs> reports(3);
+    std::vector<WFGEdgeTag> tags;
+    std::vector<TransactionCost> costs;
+    for (TransactionId trans = 1; trans <= ringLength; ++trans)
+    {
+        TransactionId next = trans % ringLength + 1;
+        reports[homeOf(trans)].push_back({trans, {next}});
+        tags.push_back({trans, next, homeOf(trans), 1, lifetime(trans), lifetime(next)});
+        costs.push_back({trans, lifetime(trans), 0, statements(rng_), 20, 1, {homeOf(trans)}});
+    }
+    WFGView view{&reports[1], &reports[2]};
+    WFGValidator validator;
+    validator.addEdgeTags(tags);
+    VictimCostTable costTable;
+    costTable.add(costs);
+    VictimSelector selector(VictimPolicy::LEAST_WORK);
+    DeadlockDetector detector;
+    CycleSet cycles;
+
+    // Resolves the cycles of view as a detecting node does: a cycle through a registered
+    // victim is skipped, any other one gets a victim, which is registered.
+    int aborts = 0;
+    int skipped = 0;
+    std::vector<Incarnation> victims;
+    auto resolve = [&](VictimRegistry &registry) {
+        detector.findCycles(view, cycles);
+        for (size_t i = 0; i < cycles.size(); ++i)
+        {
+            bool brokenEarlier = false;
+            for (size_t m = cycles.offsets[i]; m < cycles.offsets[i + 1]; ++m)
+            {
+                brokenEarlier = brokenEarlier ||
+                                registry.contains(validator.getCycleMemberIncarnation(cycles, i, cycles.members[m]));
+            }
+            if (brokenEarlier)
+            {
+                ++skipped;
+                continue;
+            }
+            TransactionId victimId = selector.selectVictim(cycles, i, validator, costTable);
+            Incarnation incarnation = validator.getCycleMemberIncarnation(cycles, i, victimId);
+            if (registry.add(incarnation))
+            {
+                ++aborts;
+                victims.push_back(incarnation);
+            }
+        }
+    };
+
+    // The tier-1 leader finds the ring in its children's reports and aborts one member.
+    auto start = std::chrono::high_resolution_clock::now();
+    VictimRegistry tierRegistry;
+    resolve(tierRegistry);
+    if (aborts != 1)
+    {
+        fail(name, "tier 1 aborted " + std::to_string(aborts) + " victims of one ring");
+        return false;
+    }
+
+    // Its residual graph leaves the victim out, so the ring does not travel upward.
+    std::unordered_set<Incarnation> victimSet(victims.begin(), victims.end());
+    std::vector<WFGPairs> forwarded = reports;
+    for (WFGPairs &report : forwarded)
+    {
+        validator.dropVictims(report, victimSet);
+    }
+    WFGView forwardedView{&forwarded[1], &forwarded[2]};
+    CycleSet residualCycles;
+    detector.findCycles(forwardedView, residualCycles);
+    if (!residualCycles.empty())
+    {
+        fail(name, "the tier-1 residual graph still holds a cycle through the victim");
+        return false;
+    }
+
+    // The central node registers the victims forwarded with that report, but a member's
+    // report from before the abort still shows the ring. So does the next report tier 1
+    // reads while the abort is in flight.
+    VictimRegistry centralRegistry;
+    centralRegistry.addAll(victims);
+    resolve(centralRegistry);
+    resolve(tierRegistry);
+    double resolveMs = elapsedMs(start);
+    if (aborts != 1 || skipped != 2)
+    {
+        fail(name, "one ring seen by two tiers led to " + std::to_string(aborts) + " aborts and " +
+                       std::to_string(skipped) + " skips");
+        return false;
+    }
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << ringLength << std::setw(10) << tags.size()
+              << std::setw(9) << 1 << std::setw(12) << std::fixed << std::setprecision(3) << resolveMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkModeSelector(const std::string &name, int numNodes)
+{
+    // One-second rounds with numNodes * waitRate cross-node waits. Cycles of length 10 keep
+    // path-pushing out unless waits are rare; busy rounds keep the central node detecting
+    // for half of the round.
+    auto interval = [numNodes](double waitRate, bool busy) {
+        DetectionModeSelector::Interval round;
+        round.seconds = 1.0;
+        round.crossNodeWaits = static_cast<long long>(waitRate * numNodes);
+        round.cyclesResolved = 10;
+        round.cycleMembers = 100;
+        round.centralDetectionTimeUs = busy ? 500000 : 0;
+        return round;
+    };
+    DetectionModeSelector::Interval rare;
+    rare.seconds = 1.0;
+    // Feeds round `rounds` times and fails unless the selector is in mode afterwards.
+    auto expect = [&](DetectionModeSelector &selector, const DetectionModeSelector::Interval &round, int rounds,
+                      DeadlockDetectionMode mode, const std::string &what) {
+        {
+            ScopedSilence silence;
+            for (int r = 0; r < rounds; ++r)
+            {
+                selector.update(round);
+            }
+        }
+        if (selector.getMode() == mode)
+        {
+            return true;
+        }
+        fail(name, what + ": running " + DetectionModeSelector::modeName(selector.getMode()) + " instead of " +
+                       DetectionModeSelector::modeName(mode));
+        return false;
+    };
+    std::uniform_real_distribution<double> rates(2 * ADAPTIVE_RARE_WAITS_PER_NODE_S, 100.0);
+    double busyRate = rates(rng_);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    // A preferred detector only takes over after ADAPTIVE_SWITCH_ROUNDS rounds in a row.
+    DetectionModeSelector hysteresis(numNodes, MODE_CENTRALIZED);
+    if (!expect(hysteresis, rare, ADAPTIVE_SWITCH_ROUNDS - 1, MODE_CENTRALIZED, "switched before the rounds were up") ||
+        !expect(hysteresis, rare, 1, MODE_PATH_PUSHING, "rare waits kept path-pushing off"))
+    {
+        return false;
+    }
+
+    // A round in which the running detector wins again restarts the count.
+    DetectionModeSelector streak(numNodes, MODE_CENTRALIZED);
+    if (!expect(streak, rare, ADAPTIVE_SWITCH_ROUNDS - 1, MODE_CENTRALIZED, "switched before the rounds were up") ||
+        !expect(streak, interval(busyRate, false), 1, MODE_CENTRALIZED, "a quiet central node lost its detector") ||
+        !expect(streak, rare, ADAPTIVE_SWITCH_ROUNDS - 1, MODE_CENTRALIZED, "an interrupted streak was kept") ||
+        !expect(streak, rare, 1, MODE_PATH_PUSHING, "rare waits kept path-pushing off"))
+    {
+        return false;
+    }
+
+    // Once centralized detection overloads the central node at busyRate, HAWK takes over and
+    // keeps the cluster down to half that rate, even while the central node is idle.
+    DetectionModeSelector latch(numNodes, MODE_CENTRALIZED);
+    if (!expect(latch, interval(busyRate, true), ADAPTIVE_SWITCH_ROUNDS, MODE_HAWK,
+                "an overloaded central node kept detecting") ||
+        !expect(latch, interval(busyRate * 0.6, false), 4 * ADAPTIVE_SWITCH_ROUNDS, MODE_HAWK,
+                "centralized detection came back above half the overload rate") ||
+        !expect(latch, interval(busyRate * 0.4, false), ADAPTIVE_SWITCH_ROUNDS, MODE_CENTRALIZED,
+                "centralized detection stayed off below half the overload rate"))
+    {
+        return false;
+    }
+    double selectMs = elapsedMs(start);
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << numNodes << std::setw(10) << "-"
+              << std::setw(9) << "-" << std::setw(12) << std::fixed << std::setprecision(3) << selectMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkPAGTrace(const std::string &name, int numClusters, int maxZoneSize, int numRounds)
+{
+    // Clusters of 2 to maxZoneSize consecutive nodes. Every round, the nodes of each cluster
+    // wait on one another in a ring and declare remote accesses to the next member.
+    std::uniform_int_distribution<int> clusterSize(2, std::max(2, maxZoneSize));
+    std::uniform_int_distribution<int> waitCount(20, 50);
+    std::vector<std::vector<NodeId>> clusters;
+    int numNodes = 0;
+    for (int c = 0; c < numClusters; ++c)
+    {
+        clusters.emplace_back();
+        for (int size = clusterSize(rng_); size > 0; --size)
+        {
+            clusters.back().push_back(++numNodes);
+        }
+    }
+    std::vector<PAGTraceRound> written(numRounds);
+    for (PAGTraceRound &round : written)
+    {
+        for (const std::vector<NodeId> &cluster : clusters)
+        {
+            for (size_t m = 0; m < cluster.size(); ++m)
+            {
+                NodeId next = cluster[(m + 1) % cluster.size()];
+                round.waits.push_back({cluster[m], next, waitCount(rng_)});
+                round.predicted.push_back({cluster[m], next, waitCount(rng_)});
+            }
+        }
+    }
+
+    auto path = std::filesystem::temp_directory_path() / ("detector_fuzzer_" + std::to_string(rng_()) + ".pagtrace");
+    auto failCheck = [&](const std::string &error) {
+        std::remove(path.c_str());
+        fail(name, error);
+        return false;
+    };
+    auto start = std::chrono::high_resolution_clock::now();
+    {
+        PAGTrace trace;
+        if (!trace.open(path.string(), numNodes))
+        {
+            return failCheck("cannot create " + path.string());
+        }
+        for (const PAGTraceRound &round : written)
+        {
+            trace.writeRound(round.waits, round.predicted);
+        }
+    }
+
+    // Every round comes back as it was written.
+    int loadedNodes = 0;
+    std::vector<PAGTraceRound> loaded;
+    auto samePairs = [](const std::vector<PAGPairCount> &a, const std::vector<PAGPairCount> &b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const PAGPairCount &x, const PAGPairCount &y) {
+            return x.waitingNodeId == y.waitingNodeId && x.holdingNodeId == y.holdingNodeId && x.count == y.count;
+        });
+    };
+    if (!PAGTrace::load(path.string(), loadedNodes, loaded) || loadedNodes != numNodes ||
+        loaded.size() != written.size())
+    {
+        return failCheck("the trace did not load back with its " + std::to_string(numRounds) + " rounds");
+    }
+    for (size_t r = 0; r < loaded.size(); ++r)
+    {
+        if (!samePairs(loaded[r].waits, written[r].waits) || !samePairs(loaded[r].predicted, written[r].predicted) ||
+            (r > 0 && loaded[r].timestampMs < loaded[r - 1].timestampMs))
+        {
+            return failCheck("round " + std::to_string(r) + " changed on the way through the trace");
+        }
+    }
+
+    // Replayed, the first round escalates every cluster's cycle, since no zones exist yet;
+    // zones planned from it hold every cycle after that.
+    for (const char *kind : {"balanced:", "incremental:"})
+    {
+        ZonePlanner::Strategy strategy;
+        std::string text = kind + std::to_string(maxZoneSize);
+        if (!ZonePlanner::parseStrategy(text, strategy))
+        {
+            return failCheck("strategy " + text + " was not accepted");
+        }
+        ZonePlanner planner(loadedNodes);
+        ZonePlanner::Result result = planner.replay(loaded, strategy);
+        if (result.rounds != numRounds || result.escalatedCycles != (numRounds > 0 ? numClusters : 0) ||
+            result.caughtCycles != static_cast<long long>(numClusters) * std::max(0, numRounds - 1) ||
+            result.maxZoneSize > static_cast<size_t>(maxZoneSize))
+        {
+            std::ostringstream error;
+            error << strategy.name << " caught " << result.caughtCycles << " and escalated " << result.escalatedCycles
+                  << " cycles of " << numClusters << " clusters in " << result.rounds << " rounds, zones of up to "
+                  << result.maxZoneSize << " nodes";
+            return failCheck(error.str());
+        }
+    }
+    ZonePlanner::Strategy malformed;
+    if (ZonePlanner::parseStrategy("balanced", malformed) || ZonePlanner::parseStrategy("balanced:0", malformed) ||
+        ZonePlanner::parseStrategy("spectral:8", malformed))
+    {
+        return failCheck("a malformed strategy was accepted");
+    }
+
+    // A torn last round is dropped; a foreign, torn or missing file is refused.
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto loads = [&](const std::string &contents) {
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+        ScopedSilence silence;
+        return PAGTrace::load(path.string(), loadedNodes, loaded);
+    };
+    if (numRounds > 0 && (!loads(bytes.substr(0, bytes.size() - 5)) || loaded.size() != written.size() - 1))
+    {
+        return failCheck("a trace with a torn last round did not load its " + std::to_string(numRounds - 1) +
+                    " whole rounds");
+    }
+    std::string corrupt = bytes;
+    corrupt[0] ^= 0x20;
+    if (loads(corrupt))
+    {
+        return failCheck("a file with a foreign header was loaded as a trace");
+    }
+    corrupt = bytes;
+    corrupt[4] ^= 0x7f;
+    if (loads(corrupt))
+    {
+        return failCheck("a trace of an unknown format version was loaded");
+    }
+    if (loads(bytes.substr(0, 6)))
+    {
+        return failCheck("a trace with a torn header was loaded");
+    }
+    std::remove(path.c_str());
+    bool loadedMissing;
+    {
+        ScopedSilence silence;
+        loadedMissing = PAGTrace::load(path.string(), loadedNodes, loaded);
+    }
+    if (loadedMissing)
+    {
+        return failCheck("a missing trace was loaded");
+    }
+    double traceMs = elapsedMs(start);
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << numNodes << std::setw(10) << written.size() * written.front().waits.size()
+              << std::setw(9) << numClusters << std::setw(12) << std::fixed << std::setprecision(3) << traceMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+bool DetectorFuzzer::checkZoneQuality(const std::string &name, int numZones, int zoneSize)
+{
+    // numZones tier-0 zones of zoneSize consecutive nodes, led by their first member, and
+    // a tier-1 zone over their leaders. The PAG the tree is built from stays inside zones.
+    std::vector<std::vector<NodeId>> zones(numZones);
+    std::vector<NodeId> leaders;
+    std::vector<int> levels(numZones, 0);
+    WeightedPAG insidePag;
+    WeightedPAG crossPag;
+    NodeId node = 0;
+    for (std::vector<NodeId> &zone : zones)
+    {
+        for (int m = 0; m < zoneSize; ++m)
+        {
+            zone.push_back(++node);
+        }
+        leaders.push_back(zone.front());
+        for (int m = 0; m < zoneSize; ++m)
+        {
+            insidePag[zone[m]][zone[(m + 1) % zoneSize]] = 10.0;
+        }
+    }
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        crossPag[zones[z].back()][zones[(z + 1) % zones.size()].front()] = 10.0;
+    }
+    zones.push_back(leaders);
+    leaders.push_back(leaders.front());
+    levels.push_back(1);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    ZoneQualityMonitor monitor;
+    ZoneQualityMonitor::Summary summary;
+    std::string reason;
+    auto close = [&](const WeightedPAG &pag) {
+        ScopedSilence silence;
+        summary = monitor.closeInterval(pag);
+        return ZoneQualityMonitor::shouldAdjust(summary, reason);
+    };
+    monitor.setTree(zones, leaders, levels, insidePag);
+
+    // Every leader resolves its cycles quickly; one cycle spans two zones.
+    std::uniform_int_distribution<int> cycles(2, 20);
+    long long zoneCycles = 0;
+    std::vector<ZoneReportStats> stats;
+    for (int z = 0; z < numZones; ++z)
+    {
+        stats.push_back({leaders[z], 0, cycles(rng_), 100, 40, 4});
+        zoneCycles += stats.back().cyclesDetected;
+    }
+    monitor.recordZoneStats(stats);
+    monitor.recordEscapedCycle({zones[0].back(), zones[1].back()});
+    if (close(insidePag) || summary.zoneCycles != zoneCycles || summary.escapedCycles != 1 ||
+        summary.cutShare != 0.0 || summary.builtCutShare != 0.0 || summary.meanReportEdges != 40.0 ||
+        summary.meanResidualEdges != 4.0)
+    {
+        fail(name, "a tree that holds its cycles was judged as: " + reason);
+        return false;
+    }
+
+    // The next interval starts empty; cycles that escape its zones call for a new tree.
+    monitor.recordEscapedCycle({zones[0].front(), zones[1].front()});
+    monitor.recordEscapedCycle({zones[1].front()});
+    if (!close(insidePag) || summary.zoneCycles != 0 || summary.escapedCycles != 2 || summary.escapedShare != 1.0)
+    {
+        fail(name, "escaping cycles were judged as: " + reason);
+        return false;
+    }
+
+    // So does a workload that moved its waits across the zones since the tree was built.
+    if (!close(crossPag) || summary.cutShare != 1.0)
+    {
+        fail(name, "a PAG that the zones cut entirely was judged as: " + reason);
+        return false;
+    }
+
+    // And a leader spending far more time detecting than the others.
+    stats.clear();
+    for (int z = 0; z < numZones; ++z)
+    {
+        stats.push_back({leaders[z], 0, 1, z == 0 ? 10 * ZONE_LEADER_MIN_DETECTION_US : 1, 1, 0});
+    }
+    monitor.recordZoneStats(stats);
+    if (!close(insidePag) || summary.busiestLeader != leaders[0])
+    {
+        fail(name, "leader " + std::to_string(leaders[0]) + " doing most of the detection was judged as: " + reason);
+        return false;
+    }
+    double monitorMs = elapsedMs(start);
+
+    std::cout << std::left << std::setw(28) << name << std::right
+              << std::setw(9) << node << std::setw(10) << insidePag.size()
+              << std::setw(9) << zoneCycles << std::setw(12) << std::fixed << std::setprecision(3) << monitorMs
+              << std::setw(12) << "-" << "\n";
+    return true;
+}
+
+int DetectorFuzzer::run(int iterations)
+{
+    std::cout << std::left << std::setw(28) << "graph" << std::right << std::setw(9) << "vertices"
+              << std::setw(10) << "edges" << std::setw(9) << "cycles" << std::setw(12) << "detect_ms"
+              << std::setw(12) << "oracle_ms" << "\n";
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        std::uniform_int_distribution<int> smallSize(2, 60);
+        int n = smallSize(rng_);
+        checkDetector("random/small", randomGraph(n, n + n / 2), true);
+        checkDetector("random/dense", randomGraph(n, n * 4), true);
+        checkDetector("acyclic", acyclicGraph(n, n * 3), true);
+        checkDetector("overlapping-rings", overlappingRingsGraph(2 + i % 6, 3 + i % 20), true);
+        checkDetector("clique", cliqueGraph(2 + i % 30), true);
+        checkSteadyStateAllocations("alloc/overlapping-rings", overlappingRingsGraph(2 + i % 6, 3 + i % 20));
+        checkPAGCut("pag/random", randomGraph(n, n * 2), SCC_CUT_THRESHOLD);
+        double plantedCut = 0.0;
+        WeightedPAG planted = plantedPartitionPAG(1 + n % 12, 2 + i % 15, plantedCut);
+        checkBalancedPartition("balanced/planted", planted, 2 + i % 15, plantedCut);
+        checkPAGSampler("pag/sampler", 2 + n, n * 50, 4 + i % 64);
+        checkIncrementalZones("zones/incremental", planted, randomWeightedPAG(static_cast<int>(planted.size()) + 3, 1 + n / 4),
+                              2 + i % 15);
+        // Small balanced zones and fanouts give trees of several tiers on few nodes.
+        checkHawk("hawk/random", randomGraph(n * 8, n * 10), 1 + n % 32, 0, HAWK_TREE_FANOUT);
+        checkHawk("hawk/random-tree", randomGraph(n * 8, n * 10), 1 + n % 64, 1 + i % 4, 2 + i % 3);
+        checkLeaderElection("leader/ring", 1 + n % 40);
+        checkWFGValidator("validator/ring", n, 1 + i % 8);
+        checkDuplicateVictims("victims/two-tiers", n);
+        checkModeSelector("adaptive/selector", 1 + n % ADAPTIVE_CENTRALIZED_MAX_NODES);
+        checkPAGTrace("trace/planted", 1 + n % 12, 2 + i % 15, 1 + i % 10);
+        checkZoneQuality("zones/quality", 5 + n % 20, 2 + i % 15);
+    }
+
+    // Stress sizes, reported with timings for run-to-run comparison.
+    for (int n : {1000, 10000, 100000})
+    {
+        checkDetector("random/" + std::to_string(n), randomGraph(n, n + n / 4), false);
+        checkDetector("ring/" + std::to_string(n), ringGraph(n), false);
+    }
+    checkDetector("overlapping-rings/100x1000", overlappingRingsGraph(100, 1000), false);
+    checkDetector("clique/300", cliqueGraph(300), false);
+    checkSteadyStateAllocations("alloc/random/10000", randomGraph(10000, 12500));
+    for (int n : {2000, 10000})
+    {
+        checkPAGCut("pag/" + std::to_string(n), randomGraph(n, n * 2), SCC_CUT_THRESHOLD);
+    }
+    checkPAGSampler("pag/sampler/" + std::to_string(NUM_NODES), NUM_NODES, 200000, PAG_SAMPLER_CAPACITY);
+    checkBalancedPartition("balanced/" + std::to_string(NUM_NODES), randomWeightedPAG(NUM_NODES, NUM_NODES * 4),
+                           MAX_ZONE_SIZE, -1.0);
+    checkBalancedPartition("balanced/2000", randomWeightedPAG(2000, 6000), MAX_ZONE_SIZE, -1.0);
+    checkHawk("hawk/" + std::to_string(NUM_NODES) + "-nodes", randomGraph(20000, 24000), NUM_NODES, 0, HAWK_TREE_FANOUT);
+    checkHawk("hawk/1024-nodes-tree", randomGraph(40000, 44000), 1024, MAX_ZONE_SIZE, HAWK_TREE_FANOUT);
+
+    std::cout << (failures_ == 0 ? "All detector checks passed.\n"
+                                 : std::to_string(failures_) + " detector checks FAILED.\n");
+    return failures_;
+}
@@ -0,0 +1,120 @@
+#ifndef HAWK_DETECTOR_FUZZER_H
+#define HAWK_DETECTOR_FUZZER_H
+
+#include "commons.h"
+#include "PAGManager.h"
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <string>
+
+// DetectorFuzzer checks the deadlock detectors against a ground-truth oracle.
+// It generates random and adversarial Wait-For Graphs (long rings, overlapping cycles,
+// cliques, DAGs, sparse graphs up to 100k transactions) and verifies that
+//   - DeadlockDetector::findCycles only reports real cycles and reports at least one
+//     cycle in every cyclic strongly connected component,
+//   - once its workspace and output buffer are warm, findCycles makes no heap allocation
+//     (counted by a replacement operator new),
+//   - PAGManager::greedySCCcut keeps exactly the SCCs above the threshold and covers
+//     every node exactly once,
+//   - ZonePartitioner splits a weighted PAG into zones of bounded size whose cut is no
+//     heavier than that of a planted partition,
+//   - a simulated HAWK detection tree of any depth (zone leaders reading their members'
+//     reports as one WFGView, leaders of leaders, then the central node), forwarding only
+//     residual graphs upward (from the zone's entries to its exits at tier 0), only reports
+//     real cycles and leaves no cyclic SCC undetected,
+//   - PAGSampler never overstates a node pair's wait count, understates it by at most
+//     waits/capacity, and keeps every pair above that share,
+//   - ZonePartitioner::repartition only makes moves that lower the cut and keeps zones
+//     bounded, and a DetectionZoneManager diff between two trees rebuilds the new one,
+//   - LeaderElector keeps a sitting leader under small load changes and replaces it once
+//     it is overloaded,
+//   - WFGValidator drops the edges of a reporter whose newer snapshot no longer holds
+//     them, and rejects a cycle whose edges disagree on a member's incarnation,
+//   - a cycle found by two tiers, or again while its abort is in flight, loses exactly
+//     one victim (VictimRegistry, WFGValidator::dropVictims),
+//   - DetectionModeSelector only switches after ADAPTIVE_SWITCH_ROUNDS rounds in a row,
+//     restarts that count when the running detector wins a round, and keeps centralized
+//     detection off above half the wait rate at which it overloaded the central node,
+//   - a PAGTrace loads back as it was recorded, drops a torn last round and refuses a
+//     foreign or torn header, and ZonePlanner's zones catch the planted cycles it holds,
+//   - ZoneQualityMonitor keeps a tree that holds its cycles, and rebuilds it once cycles
+//     escape its zones, the PAG drifts across them, or one leader is overloaded.
+// The oracle is a brute-force self-reachability search on small graphs and an
+// independent Kosaraju SCC pass on large ones. Runtime per graph size is printed so
+// detector optimizations can be compared run to run.
+class DetectorFuzzer
+{
+public:
+    using WFG = std::unordered_map<TransactionId, std::vector<TransactionId>>;
+
+    explicit DetectorFuzzer(unsigned int seed);
+
+    // Runs `iterations` rounds of every generator plus the large stress graphs.
+    // Returns the number of failed checks (0 on success).
+    int run(int iterations);
+
+private:
+    std::mt19937 rng_;
+    int failures_ = 0;
+
+    // --- Graph generators ---
+    WFG randomGraph(int numVertices, int numEdges);
+    WFG acyclicGraph(int numVertices, int numEdges);
+    WFG ringGraph(int numVertices);
+    WFG overlappingRingsGraph(int numRings, int ringLength);
+    WFG cliqueGraph(int numVertices);
+    // Weighted PAG made of random-sized clusters of at most maxZoneSize nodes with heavy
+    // internal edges and light edges between clusters. plantedCut receives the cut
+    // weight of the clusters themselves.
+    WeightedPAG plantedPartitionPAG(int numClusters, int maxZoneSize, double &plantedCut);
+    WeightedPAG randomWeightedPAG(int numNodes, int numEdges);
+
+    // --- Oracle ---
+    // Marks every vertex that reaches itself; O(V * (V + E)), small graphs only.
+    static std::unordered_map<TransactionId, bool> bruteForceCyclicVertices(const WFG &graph);
+    // Component id per vertex, computed with an iterative Kosaraju pass.
+    static std::unordered_map<TransactionId, int> kosarajuComponents(const WFG &graph);
+    // Groups the vertices of every cyclic SCC (size > 1, or a self-loop).
+    static std::vector<std::vector<TransactionId>> cyclicComponents(const WFG &graph);
+
+    // --- Checks ---
+    bool checkDetector(const std::string &name, const WFG &graph, bool useBruteForce);
+    // Repeats findCycles, over the map and over a WFGView, on a warmed workspace and
+    // output buffer and fails if any call allocates.
+    bool checkSteadyStateAllocations(const std::string &name, const WFG &graph);
+    bool checkPAGCut(const std::string &name, const WFG &pag, int threshold);
+    // maxCut < 0 skips the cut-weight comparison.
+    bool checkBalancedPartition(const std::string &name, const WeightedPAG &pag, int maxZoneSize, double maxCut);
+    // maxZoneSize <= 0 forms zones with the greedy SCC cut, otherwise with ZonePartitioner.
+    bool checkHawk(const std::string &name, const WFG &graph, int numNodes, int maxZoneSize, int fanout);
+    // Feeds a skewed stream of numWaits waits over numNodes nodes through a sampler.
+    bool checkPAGSampler(const std::string &name, int numNodes, int numWaits, size_t capacity);
+    // Partitions pag, perturbs it with `drift` and updates the zones incrementally.
+    bool checkIncrementalZones(const std::string &name, const WeightedPAG &pag, const WeightedPAG &drift, int maxZoneSize);
+    // Elects the leader of a ring-shaped zone, in which every member is equally central.
+    bool checkLeaderElection(const std::string &name, int zoneSize);
+    // Tags a ring as numReporters nodes would, then outdates one reporter's snapshot and
+    // restarts one member.
+    bool checkWFGValidator(const std::string &name, int ringLength, int numReporters);
+    // Lets a tier-1 leader and the central node both see one ring spanning two zones.
+    bool checkDuplicateVictims(const std::string &name, int ringLength);
+    // Replays fixed round sequences through DetectionModeSelector on a small cluster.
+    bool checkModeSelector(const std::string &name, int numNodes);
+    // Records numRounds rounds of waits inside planted clusters with PAGTrace, loads them
+    // back, replays them through ZonePlanner, then loads damaged copies of the file.
+    bool checkPAGTrace(const std::string &name, int numClusters, int maxZoneSize, int numRounds);
+    // Feeds ZoneQualityMonitor a healthy interval, then ones that must trigger a rebuild.
+    // Needs numZones >= 5 for one leader to stand out as overloaded.
+    bool checkZoneQuality(const std::string &name, int numZones, int zoneSize);
+
+    static bool cyclesAreValid(const WFG &graph, const std::vector<std::vector<TransactionId>> &cycles,
+                               std::string &error);
+    static bool cyclesCoverComponents(const std::vector<std::vector<TransactionId>> &components,
+                                      const std::vector<std::vector<TransactionId>> &cycles, std::string &error);
+
+    void fail(const std::string &name, const std::string &error);
+    static size_t edgeCount(const WFG &graph);
+};
+
+#endif // HAWK_DETECTOR_FUZZER_H
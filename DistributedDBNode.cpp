@@ -14,8 +14,9 @@
  * @param id The unique identifier of the current node.
  * @param numNodes The total number of nodes in the system.
  * @param network A reference to the network communication instance, used for inter-node message passing.
+ * @param victimPolicy How this node picks deadlock victims when it aggregates WFGs.
  */
-DistributedDBNode::DistributedDBNode(NodeId id, int numNodes, Network &network)
+DistributedDBNode::DistributedDBNode(NodeId id, int numNodes, Network &network, VictimPolicy victimPolicy)
     : nodeId_(id),
       numNodes_(numNodes),
       resourceManager_(id),
@@ -24,38 +25,70 @@ DistributedDBNode::DistributedDBNode(NodeId id, int numNodes, Network &network)
                          [&](const NetworkMessage &msg) { network.sendMessage(msg); }, tpcc_rng_),
       lockTable_(id, resourceManager_, transactionManager_),
       pagManager_(),
+      pagSampler_(),
+      predictedPagSampler_(),
+      zonePartitioner_(),
+      modeSelector_(numNodes, ADAPTIVE_INITIAL_MODE),
       detectionZoneManager_(id),
       network_(network),
-      deadlockDetector_(std::make_unique<DeadlockDetector>()),
       isCentralizedNode_(id == CENTRALIZED_NODE_ID),
-      isCentralizedDetectionMode_(DEADLOCK_DETECTION_MODE == MODE_CENTRALIZED),
-      aggregatedWfg_(),
-      wfgReportsReceived_(0),
-      wfgReportsExpected_(0),
-      aggregatedPagEdges_(),
+      activeDetectionMode_(DEADLOCK_DETECTION_MODE == MODE_ADAPTIVE ? ADAPTIVE_INITIAL_MODE : DEADLOCK_DETECTION_MODE),
+      detectionModeEpoch_(0),
+      wfgRound_(),
+      staleWfgReportsDropped_(0),
+      lastZoneLeaderContactMs_(0),
+      zoneStrategy_(ZONE_DETECT_WFG),
+      sparseZoneRounds_(0),
+      zoneRoundOverflowed_(false),
+      probeOverflowPending_(false),
+      aggregatedPagCounts_(),
       pagResponsesReceived_(0),
       pagResponsesExpected_(0),
-      centralAggregatedWfg_(),
-      centralWfgReportsReceived_(0),
+      centralReports_(),
+      centralRoundOpen_(false),
       centralDeadlockCount_(0),
       centralDetectedCycles_(),
+      wfgEpoch_(0),
+      detectionTimeUs_(0),
+      cyclesResolved_(0),
+      cycleMembersResolved_(0),
+      staleAbortsIgnored_(0),
+      victimSelector_(victimPolicy),
+      duplicateCyclesSkipped_(0),
+      victimAborts_(0),
+      wastedStatements_(0),
+      wastedLocks_(0),
+      wastedTimeMs_(0),
       completedTransactionLatencies_(),
       lastReportTime_(std::chrono::high_resolution_clock::now()),
-      totalDeadlocksFromZones_(0),
-      totalDeadlocksFromCentral_(0),
-      lastTreeAdjustTime_(std::chrono::high_resolution_clock::now()),
-      prevTotalDeadlocksFromZones_(0),
-      prevTotalDeadlocksFromCentral_(0)
+      lastTreeAdjustTime_(std::chrono::high_resolution_clock::now())
 {
+    resourceManager_.onTransactionBlocked = [this](TransactionId waitingTransId, const std::vector<TransactionId> &holdingTransIds) {
+        recordCrossNodeWait(waitingTransId, holdingTransIds);
+    };
+    if (isCentralizedNode_ && (DEADLOCK_DETECTION_MODE == MODE_HAWK || DEADLOCK_DETECTION_MODE == MODE_ADAPTIVE) &&
+        !PAG_TRACE_FILE.empty()) {
+        pagTrace_.open(PAG_TRACE_FILE, numNodes_);
+    }
+    noteZoneLeaderContact();
     transactionPollingThread_ = std::thread(&DistributedDBNode::transactionPollingLoop, this);
     messageProcessingThread_ = std::thread(&DistributedDBNode::messageProcessingLoop, this);
 
-    if (DEADLOCK_DETECTION_MODE == MODE_CENTRALIZED) {
+    if (DEADLOCK_DETECTION_MODE == MODE_ADAPTIVE) {
+        // Every detector is ready; each loop idles while another one is active. PAG rounds
+        // always run, since the choice is made from them.
+        centralizedDetectThread = std::thread(&DistributedDBNode::centralizedDetectLoop, this);
+        distributedDetectCoordinatorThread = std::thread(&DistributedDBNode::distributedDetectCoordinatorLoop, this);
+        pagSampleThread = std::thread(&DistributedDBNode::pagSamplingLoop, this);
+        pathPushingThread = std::thread(&DistributedDBNode::pathPushingDetectionLoop, this);
+        roundTimerThread = std::thread(&DistributedDBNode::roundTimerLoop, this);
+    } else if (DEADLOCK_DETECTION_MODE == MODE_CENTRALIZED) {
         centralizedDetectThread = std::thread(&DistributedDBNode::centralizedDetectLoop, this);
     } else if (DEADLOCK_DETECTION_MODE == MODE_HAWK) {
         distributedDetectCoordinatorThread = std::thread(&DistributedDBNode::distributedDetectCoordinatorLoop, this);
         pagSampleThread = std::thread(&DistributedDBNode::pagSamplingLoop, this);
         treeAdjustThread = std::thread(&DistributedDBNode::treeAdjustmentLoop, this);
+        roundTimerThread = std::thread(&DistributedDBNode::roundTimerLoop, this);
     } else if (DEADLOCK_DETECTION_MODE == MODE_PATH_PUSHING) {
         pathPushingThread = std::thread(&DistributedDBNode::pathPushingDetectionLoop, this);
     }
@@ -84,6 +117,14 @@ DistributedDBNode::~DistributedDBNode()
     {
         deadlockDetectionThread_.join();
     }
+    for (std::thread *detectionThread : {&pagSampleThread, &treeAdjustThread, &distributedDetectCoordinatorThread,
+                                         &centralizedDetectThread, &pathPushingThread, &roundTimerThread})
+    {
+        if (detectionThread->joinable())
+        {
+            detectionThread->join();
+        }
+    }
     std::cout << "Node " << nodeId_ << " server shut down.\\n";
 }
 
@@ -190,6 +231,9 @@ void DistributedDBNode::tpccWorkloadLoop() {
         }
 
         if (tpcc_txn) {
+            for (NodeId remoteNode : tpcc_txn->remoteAccessNodes()) {
+                predictedPagSampler_.recordWait(nodeId_, remoteNode);
+            }
             transactionManager_.addTPCCTransaction(tpcc_txn);
         }
 
@@ -205,6 +249,20 @@ void DistributedDBNode::run() {}
 std::vector<long long> DistributedDBNode::getCompletedTransactionLatencies() {
     return completedTransactionLatencies_.drain();
 }
+
+void DistributedDBNode::printVictimPolicyStats() {
+    long long aborts = victimAborts_.load();
+    std::cout << "Node " << nodeId_ << ": Victim policy " << VictimSelector::policyName(victimSelector_.getPolicy())
+              << ", deadlock aborts: " << aborts
+              << ", duplicate cycles skipped: " << duplicateCyclesSkipped_.load()
+              << ", wasted statements: " << wastedStatements_.load()
+              << ", wasted locks: " << wastedLocks_.load()
+              << ", wasted time: " << wastedTimeMs_.load() << " ms";
+    if (aborts > 0) {
+        std::cout << " (" << static_cast<double>(wastedTimeMs_.load()) / aborts << " ms per abort)";
+    }
+    std::cout << "\n";
+}
 /**
  * @brief Transaction polling loop.
  *
@@ -265,15 +323,16 @@ void DistributedDBNode::messageProcessingLoop()
                 break;
 
             case NetworkMessageType::WFG_REPORT:
-                handleWFGReport(msg.senderId, msg.wfgData);
+                handleWFGReport(msg.senderId, msg.roundId, msg.wfgData, msg.wfgEdgeTags, msg.transactionCosts);
                 break;
 
             case NetworkMessageType::PAG_REQUEST:
+                applyDetectionMode(msg.detectionMode, msg.modeEpoch);
                 handlePAGRequest(msg.senderId);
                 break;
 
             case NetworkMessageType::PAG_RESPONSE:
-                handlePAGResponse(msg.senderId, msg.pagEdges);
+                handlePAGResponse(msg.senderId, msg.pagPairCounts, msg.predictedPagPairCounts, msg.nodeLoad);
                 break;
 
             case NetworkMessageType::DEADLOCK_RESOLUTION:
@@ -281,23 +340,33 @@ void DistributedDBNode::messageProcessingLoop()
                 break;
 
             case NetworkMessageType::ABORT_TRANSACTION_SIGNAL:
-                handleAbortTransactionSignal(msg.deadlockedTransactions);
+                handleAbortTransactionSignal(msg.deadlockedTransactions, msg.deadlockedIncarnations);
                 break;
 
             case NetworkMessageType::DISTRIBUTED_DETECTION_INIT:
-                handleDistributedDetectionInit(msg.detectionZones, msg.detectionZoneLeaders);
+                handleDistributedDetectionInit(msg);
                 break;
 
             case NetworkMessageType::ZONE_DETECTION_REQUEST:
-                handleZoneDetectionRequest(msg.centralNodeId, msg.zoneMembers);
+                handleZoneDetectionRequest(msg.centralNodeId, msg.roundId, msg.treeVersion, msg.zoneMembers, msg.zoneStrategy);
                 break;
 
             case NetworkMessageType::ZONE_WFG_REPORT:
-                handleZoneWFGReport(msg.senderId, msg.wfgDataPairs);
+                handleZoneWFGReport(msg.senderId, msg.roundId, std::move(msg.wfgDataPairs), msg.wfgEdgeTags,
+                                    std::move(msg.transactionCosts), msg.probeOverflow, msg.victimIncarnations);
                 break;
 
             case NetworkMessageType::CENTRAL_WFG_REPORT_FROM_ZONE:
-                handleCentralWFGReportFromZone(msg.senderId, msg.wfgDataPairs, msg.detectedCycles, msg.deadlockCount);
+                handleCentralWFGReportFromZone(msg.senderId, msg.roundId, msg.wfgDataPairs, msg.detectedCycles, msg.deadlockCount, msg.wfgEdgeTags,
+                                               msg.transactionCosts, msg.zoneLevel, msg.zoneStats, msg.victimIncarnations);
+                break;
+
+            case NetworkMessageType::DETECTION_MODE_CHANGE:
+                applyDetectionMode(msg.detectionMode, msg.modeEpoch);
+                break;
+
+            case NetworkMessageType::ZONE_LEADER_FAILOVER:
+                handleZoneLeaderFailover(msg.senderId, msg.failedLeaderId, msg.treeVersion);
                 break;
 
             case NetworkMessageType::PATH_PUSHING_PROBE:
@@ -354,46 +423,251 @@ void DistributedDBNode::centralizedDetectLoop() {
     while (systemRunning) {
         std::this_thread::sleep_for(std::chrono::milliseconds(DEADLOCK_DETECTION_INTERVAL_MS));
         if (!systemRunning) break;
-        if (isCentralizedNode_) {
-            wfgReportsReceived_ = 0;
-            aggregatedWfg_.clear();
-            wfgReportsExpected_ = numNodes_;
+        if (isCentralizedNode_ && detectionMode() == MODE_CENTRALIZED) {
+            long long roundId = beginWFGRound(numNodes_);
             for (int i = 1; i <= numNodes_; ++i) {
+                if (i == nodeId_) {
+                    // A request would be taken for a report here; report the local WFG instead.
+                    sendToNode(makeLocalWFGReport(nodeId_, roundId));
+                    continue;
+                }
                 NetworkMessage requestMsg;
                 requestMsg.type = NetworkMessageType::WFG_REPORT;
                 requestMsg.senderId = nodeId_;
                 requestMsg.receiverId = i;
+                requestMsg.roundId = roundId;
                 network_.sendMessage(requestMsg);
             }
+            awaitWFGRound(roundId);
         }
     }
 }
 
 void DistributedDBNode::distributedDetectCoordinatorLoop() {
+    int intervalMs = ZONE_ROUND_MIN_INTERVAL_MS;
     while (systemRunning) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
         if (!systemRunning) break;
-        if (detectionZoneManager_.isZoneLeader()) {
-            NodeId myZoneLeaderId = detectionZoneManager_.getMyZoneLeaderId();
-            const std::vector<NodeId>& myZoneMembers = detectionZoneManager_.getMyDetectionZoneMembers();
-            wfgReportsReceived_ = 0;
-            aggregatedWfg_.clear();
-            wfgReportsExpected_ = myZoneMembers.size();
-            for (NodeId memberId : myZoneMembers) {
-                NetworkMessage requestMsg;
-                requestMsg.type = NetworkMessageType::ZONE_WFG_REPORT;
-                requestMsg.senderId = nodeId_;
-                requestMsg.receiverId = memberId;
-                network_.sendMessage(requestMsg);
-            }
+        // One snapshot for the whole round, so the members and the version stamped on the
+        // requests always belong to the same tree.
+        std::shared_ptr<const DetectionZoneManager::Snapshot> tree = detectionZoneManager_.getSnapshot();
+        if (detectionMode() != MODE_HAWK) {
+            // Leaders are quiet while another detector runs; that is no stall.
+            noteZoneLeaderContact();
+            intervalMs = DEADLOCK_DETECTION_INTERVAL_MS;
+            continue;
+        }
+        if (tree->myZoneLeaderId != nodeId_) {
+            watchZoneLeader(tree);
+            intervalMs = ZONE_ROUND_MIN_INTERVAL_MS;
+            continue;
         }
+        long long roundId = beginWFGRound(tree->myZoneMembers.size(), tree);
+        ZoneDetectionStrategy strategy;
+        {
+            std::unique_lock<std::mutex> lock(aggregatedWfgMutex_);
+            strategy = zoneStrategy_;
+        }
+        for (NodeId memberId : tree->myZoneMembers) {
+            NetworkMessage requestMsg;
+            requestMsg.type = NetworkMessageType::ZONE_DETECTION_REQUEST;
+            requestMsg.senderId = nodeId_;
+            requestMsg.receiverId = memberId;
+            requestMsg.centralNodeId = nodeId_;
+            requestMsg.roundId = roundId;
+            requestMsg.treeVersion = tree->version;
+            requestMsg.zoneMembers = tree->myZoneMembers;
+            requestMsg.zoneStrategy = strategy;
+            sendToNode(requestMsg);
+        }
+
+        size_t cycles = awaitWFGRound(roundId);
+        // Poll busy zones often and idle ones rarely.
+        intervalMs = cycles > 0 ? std::max(ZONE_ROUND_MIN_INTERVAL_MS, intervalMs / 2)
+                                : std::min(ZONE_ROUND_MAX_INTERVAL_MS, intervalMs + intervalMs / 2 + 1);
+    }
+}
+
+long long DistributedDBNode::beginWFGRound(int expectedReports, std::shared_ptr<const DetectionZoneManager::Snapshot> tree) {
+    std::unique_lock<std::mutex> lock(aggregatedWfgMutex_);
+    wfgValidator_.clearRound();
+    wfgRound_.id++;
+    wfgRound_.active = true;
+    wfgRound_.reportsReceived = 0;
+    wfgRound_.reportsExpected = expectedReports;
+    wfgRound_.cyclesResolved = 0;
+    wfgRound_.tree = std::move(tree);
+    return wfgRound_.id;
+}
+
+bool DistributedDBNode::acceptWFGReport(NodeId reporterNodeId, long long roundId) {
+    if (wfgRound_.active && roundId == wfgRound_.id) return true;
+    countStaleWFGReport(reporterNodeId, roundId);
+    return false;
+}
+
+bool DistributedDBNode::acceptWFGReport(TierAggregation &aggregation, NodeId childLeaderId, long long roundId) {
+    long long &latestRoundId = aggregation.childRoundIds[childLeaderId];
+    if (roundId > latestRoundId) {
+        latestRoundId = roundId;
+        return true;
+    }
+    countStaleWFGReport(childLeaderId, roundId);
+    return false;
+}
+
+void DistributedDBNode::countStaleWFGReport(NodeId reporterNodeId, long long roundId) {
+    staleWfgReportsDropped_++;
+    std::cout << "Node " << nodeId_ << ": Dropping WFG report of round " << roundId << " from Node " << reporterNodeId
+              << " (" << staleWfgReportsDropped_.load() << " total).\n";
+}
+
+void DistributedDBNode::closeWFGRound() {
+    // Only zone rounds record a tree.
+    if (!wfgRound_.tree) {
+        checkAndResolveDeadlocks();
+        wfgRound_.cyclesResolved = 0;
+    } else {
+        wfgRound_.cyclesResolved = checkAndResolveDeadlocksForZone();
+    }
+    wfgValidator_.clearRound();
+    wfgRound_.active = false;
+    wfgRoundCv_.notify_all();
+}
+
+size_t DistributedDBNode::awaitWFGRound(long long roundId) {
+    std::unique_lock<std::mutex> lock(aggregatedWfgMutex_);
+    auto closed = [this, roundId] { return !wfgRound_.active || wfgRound_.id != roundId || !systemRunning; };
+    if (!wfgRoundCv_.wait_for(lock, std::chrono::milliseconds(WFG_ROUND_TIMEOUT_MS), closed)) {
+        // A lost or slow reply must not stall detection; what did arrive is still worth checking.
+        std::cout << "Node " << nodeId_ << ": WFG round " << roundId << " timed out with " << wfgRound_.reportsReceived
+                  << " of " << wfgRound_.reportsExpected << " reports; closing it with partial data.\n";
+        closeWFGRound();
+    }
+    return wfgRound_.id == roundId ? wfgRound_.cyclesResolved : 0;
+}
+
+void DistributedDBNode::updateZoneStrategy(size_t cycles, size_t edges) {
+    bool overflowed = zoneRoundOverflowed_;
+    zoneRoundOverflowed_ = false;
+    if (zoneStrategy_ == ZONE_DETECT_PROBES) {
+        // A probe that could not finish may be on a cycle through other zones, which only the
+        // residual graph of a WFG round carries up the tree.
+        if (!overflowed) return;
+        std::cout << "Node " << nodeId_ << ": Zone probes overflowed; back to WFG collection.\n";
+        zoneStrategy_ = ZONE_DETECT_WFG;
+        sparseZoneRounds_ = 0;
+        return;
+    }
+    bool sparse = cycles == 0 && edges <= static_cast<size_t>(ZONE_PROBE_SPARSE_EDGES);
+    sparseZoneRounds_ = sparse ? sparseZoneRounds_ + 1 : 0;
+    if (sparseZoneRounds_ >= ZONE_PROBE_SPARSE_ROUNDS) {
+        std::cout << "Node " << nodeId_ << ": Zone contention is sparse; switching to probes.\n";
+        zoneStrategy_ = ZONE_DETECT_PROBES;
+    }
+}
+
+bool DistributedDBNode::launchZoneProbes(NodeId zoneLeaderId) {
+    bool overflowed = probeOverflowPending_.exchange(false);
+    std::vector<TransactionId> blocked = transactionManager_.getTransactionsBlockedFor(ZONE_PROBE_BLOCKED_MS);
+    if (blocked.size() > static_cast<size_t>(ZONE_PROBE_MAX_PER_MEMBER)) {
+        std::cout << "Node " << nodeId_ << ": " << blocked.size() << " blocked transactions are too many to probe.\n";
+        return true;
+    }
+    for (TransactionId transId : blocked) {
+        NetworkMessage probeMsg;
+        probeMsg.type = NetworkMessageType::PATH_PUSHING_PROBE;
+        probeMsg.senderId = nodeId_;
+        probeMsg.receiverId = nodeId_;
+        probeMsg.centralNodeId = zoneLeaderId;
+        probeMsg.path.push_back(transId);
+        network_.getIncomingQueue()->push(probeMsg);
+    }
+    return overflowed;
+}
+
+std::vector<Incarnation> DistributedDBNode::takeProbeVictims() {
+    std::unique_lock<std::mutex> lock(probeVictimsMutex_);
+    std::vector<Incarnation> victims;
+    victims.swap(probeVictimsPending_);
+    return victims;
+}
+
+DeadlockDetectionMode DistributedDBNode::detectionMode() const {
+    return static_cast<DeadlockDetectionMode>(activeDetectionMode_.load());
+}
+
+void DistributedDBNode::applyDetectionMode(int mode, long long epoch) {
+    if (DEADLOCK_DETECTION_MODE != MODE_ADAPTIVE) return;
+    std::unique_lock<std::mutex> lock(detectionModeMutex_);
+    if (epoch <= detectionModeEpoch_) return;
+    detectionModeEpoch_ = epoch;
+    activeDetectionMode_ = mode;
+    std::cout << "Node " << nodeId_ << ": Running " << DetectionModeSelector::modeName(static_cast<DeadlockDetectionMode>(mode))
+              << " detection from epoch " << epoch << ".\n";
+}
+
+void DistributedDBNode::announceDetectionMode(DeadlockDetectionMode mode) {
+    long long epoch = detectionModeEpoch_ + 1;
+    applyDetectionMode(mode, epoch);
+    std::vector<NetworkMessage> modeMsgs;
+    for (int i = 1; i <= numNodes_; ++i) {
+        if (i == nodeId_) continue;
+        NetworkMessage modeMsg;
+        modeMsg.type = NetworkMessageType::DETECTION_MODE_CHANGE;
+        modeMsg.senderId = nodeId_;
+        modeMsg.receiverId = i;
+        modeMsg.detectionMode = mode;
+        modeMsg.modeEpoch = epoch;
+        modeMsgs.push_back(std::move(modeMsg));
+    }
+    if (!modeMsgs.empty()) network_.sendMessagesInParallel(modeMsgs);
+}
+
+void DistributedDBNode::countResolvedCycle(size_t length) {
+    cyclesResolved_++;
+    cycleMembersResolved_ += static_cast<long long>(length);
+}
+
+void DistributedDBNode::noteZoneLeaderContact() {
+    lastZoneLeaderContactMs_ = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void DistributedDBNode::watchZoneLeader(const std::shared_ptr<const DetectionZoneManager::Snapshot> &tree) {
+    int rank = detectionZoneManager_.getDeputyRank(*tree);
+    if (rank < 0) return;
+    long long nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch()).count();
+    long long silentMs = nowMs - lastZoneLeaderContactMs_.load();
+    // Later deputies give the ones before them a full period each to take over first.
+    if (silentMs < static_cast<long long>(rank + 1) * ZONE_LEADER_TIMEOUT_MS) return;
+    NodeId failedLeaderId = tree->myZoneLeaderId;
+    if (!detectionZoneManager_.takeOverZone(failedLeaderId)) return;
+    std::cout << "Node " << nodeId_ << ": No detection request from zone leader " << failedLeaderId << " for " << silentMs
+              << " ms; taking over its zone as deputy " << rank << ".\n";
+    noteZoneLeaderContact();
+
+    // The zone is checked again from the next round on; the central node makes the change
+    // part of the tree so the rest of it routes reports here.
+    if (isCentralizedNode_) {
+        handleZoneLeaderFailover(nodeId_, failedLeaderId, tree->version);
+        return;
     }
+    NetworkMessage failoverMsg;
+    failoverMsg.type = NetworkMessageType::ZONE_LEADER_FAILOVER;
+    failoverMsg.senderId = nodeId_;
+    failoverMsg.receiverId = CENTRALIZED_NODE_ID;
+    failoverMsg.treeVersion = tree->version;
+    failoverMsg.failedLeaderId = failedLeaderId;
+    network_.sendMessage(failoverMsg);
 }
 
 void DistributedDBNode::pathPushingDetectionLoop() {
     while (systemRunning) {
         std::this_thread::sleep_for(std::chrono::milliseconds(DEADLOCK_DETECTION_INTERVAL_MS));
         if (!systemRunning) break;
-        initiatePathPushingProbes();
+        if (detectionMode() == MODE_PATH_PUSHING) initiatePathPushingProbes();
     }
 }
 
@@ -401,16 +675,24 @@ void DistributedDBNode::pagSamplingLoop() {
     while (systemRunning) {
         std::this_thread::sleep_for(std::chrono::milliseconds(PAG_SAMPLE_INTERVAL_MS));
         if (!systemRunning) break;
-        if (DEADLOCK_DETECTION_MODE == MODE_HAWK && isCentralizedNode_) {
-            pagResponsesReceived_ = 0;
-            aggregatedPagEdges_.clear();
-            pagResponsesExpected_ = numNodes_;
+        if ((DEADLOCK_DETECTION_MODE == MODE_HAWK || DEADLOCK_DETECTION_MODE == MODE_ADAPTIVE) && isCentralizedNode_) {
+            {
+                std::unique_lock<std::mutex> lock(aggregatedPagCountsMutex_);
+                pagResponsesReceived_ = 0;
+                aggregatedPagCounts_.clear();
+                roundWaitPairs_.clear();
+                roundPredictedPairs_.clear();
+                pagResponsesExpected_ = numNodes_;
+            }
             for (int i = 1; i <= numNodes_; ++i) {
                 NetworkMessage requestMsg;
                 requestMsg.type = NetworkMessageType::PAG_REQUEST;
                 requestMsg.senderId = nodeId_;
                 requestMsg.receiverId = i;
-                network_.sendMessage(requestMsg);
+                // Repeats the current detector for nodes that missed its announcement.
+                requestMsg.detectionMode = detectionMode();
+                requestMsg.modeEpoch = detectionModeEpoch_;
+                sendToNode(requestMsg);
             }
         }
     }
@@ -423,138 +705,239 @@ void DistributedDBNode::pagSamplingLoop() {
 //     }
 // }
 
+NetworkMessage DistributedDBNode::makeLocalWFGReport(NodeId receiverId, long long roundId)
+{
+    std::unordered_map<TransactionId, std::vector<TransactionId>> lwfg = lockTable_.buildLocalWaitForGraph();
+    NetworkMessage reportMsg;
+    reportMsg.type = NetworkMessageType::WFG_REPORT;
+    reportMsg.senderId = nodeId_;
+    reportMsg.receiverId = receiverId;
+    reportMsg.roundId = roundId;
+    reportMsg.wfgEdgeTags = tagLocalWFG(lwfg);
+    reportMsg.transactionCosts = transactionManager_.getBlockedTransactionCosts();
+    reportMsg.wfgData = std::move(lwfg);
+    return reportMsg;
+}
+
 /**
  * @brief Handles a WFG report message.
  *
  * In centralized deadlock detection mode, the central node receives WFG reports from other nodes.
- * It merges the WFG data from the report into its global aggregated WFG.
+ * It stores the WFG data of the report in the reporter's slot of the current round.
  *
  * @param reporterNodeId The ID of the node reporting the WFG.
  * @param wfgDataPairs The list of WFG data pairs contained in the report.
  */
-void DistributedDBNode::handleWFGReport(NodeId reporterNodeId, const std::unordered_map<TransactionId, std::vector<TransactionId>> &wfgData)
+void DistributedDBNode::handleWFGReport(NodeId reporterNodeId, long long roundId, const std::unordered_map<TransactionId, std::vector<TransactionId>> &wfgData,
+                                        const std::vector<WFGEdgeTag> &edgeTags,
+                                        const std::vector<TransactionCost> &transactionCosts)
 {
-    if (!isCentralizedNode_) return;
+    if (!isCentralizedNode_) {
+        network_.sendMessage(makeLocalWFGReport(reporterNodeId, roundId));
+        return;
+    }
 
     std::unique_lock<std::mutex> lock(aggregatedWfgMutex_);
-    mergeWFG(aggregatedWfg_, convertWFGToMessageFormat(wfgData));
-    wfgReportsReceived_++;
-    if (wfgReportsReceived_ >= wfgReportsExpected_)
+    if (!acceptWFGReport(reporterNodeId, roundId)) return;
+    MemberWFGSlot &slot = memberWfgSlots_[reporterNodeId];
+    slot.roundId = roundId;
+    assignWFGPairs(slot.wfg, wfgData);
+    wfgValidator_.addEdgeTags(edgeTags);
+    slot.costs = transactionCosts;
+    wfgRound_.reportsReceived++;
+    if (wfgRound_.reportsReceived >= wfgRound_.reportsExpected)
     {
-        checkAndResolveDeadlocks(aggregatedWfg_);
-        aggregatedWfg_.clear();
-        wfgReportsReceived_ = 0;
+        closeWFGRound();
     }
 }
 
 void DistributedDBNode::handlePAGRequest(NodeId requesterNodeId)
 {
-    std::vector<WFDEdge> crossNodeEdges = lockTable_.collectCrossNodeWFDEdges();
     NetworkMessage responseMsg;
     responseMsg.type = NetworkMessageType::PAG_RESPONSE;
     responseMsg.senderId = nodeId_;
     responseMsg.receiverId = requesterNodeId;
-    responseMsg.pagEdges = crossNodeEdges;
-    network_.sendMessage(responseMsg);
+    responseMsg.pagPairCounts = pagSampler_.drain();
+    responseMsg.predictedPagPairCounts = predictedPagSampler_.drain();
+    responseMsg.nodeLoad = collectNodeLoad();
+    sendToNode(responseMsg);
+}
+
+void DistributedDBNode::recordCrossNodeWait(TransactionId waitingTransId, const std::vector<TransactionId> &holdingTransIds)
+{
+    NodeId waitingNode = transactionManager_.getTransactionHomeNode(waitingTransId);
+    if (waitingNode == 0) return;
+    for (TransactionId holder : holdingTransIds)
+    {
+        NodeId holdingNode = transactionManager_.getTransactionHomeNode(holder);
+        if (holdingNode != 0 && holdingNode != waitingNode)
+        {
+            pagSampler_.recordWait(waitingNode, holdingNode);
+        }
+    }
+}
+
+NodeLoad DistributedDBNode::collectNodeLoad()
+{
+    NodeLoad load;
+    load.nodeId = nodeId_;
+    load.detectionTimeUs = detectionTimeUs_.exchange(0);
+    load.activeTransactions = static_cast<int>(transactionManager_.getActiveTransactions().size());
+    load.queueDepth = static_cast<int>(network_.getIncomingQueue()->size());
+    load.cyclesResolved = static_cast<int>(cyclesResolved_.exchange(0));
+    load.cycleMembers = cycleMembersResolved_.exchange(0);
+    return load;
+}
+
+void DistributedDBNode::findCyclesTimed(DetectionWorkspace &workspace, const WFGView &view)
+{
+    auto start = std::chrono::steady_clock::now();
+    workspace.detector.findCycles(view, workspace.cycles);
+    detectionTimeUs_ += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
 }
 
-void DistributedDBNode::handlePAGResponse(NodeId reporterNodeId, const std::vector<WFDEdge> &pagEdges)
+void DistributedDBNode::handlePAGResponse(NodeId reporterNodeId, const std::vector<PAGPairCount> &pairCounts,
+                                          const std::vector<PAGPairCount> &predictedPairCounts, const NodeLoad &load)
 {
     if (!isCentralizedNode_) return;
 
-    std::unique_lock<std::mutex> lock(aggregatedPagEdgesMutex_);
-    aggregatedPagEdges_.insert(aggregatedPagEdges_.end(), pagEdges.begin(), pagEdges.end());
+    std::unique_lock<std::mutex> lock(aggregatedPagCountsMutex_);
+    leaderElector_.recordLoad(load);
+    for (const PAGPairCount &pair : pairCounts) {
+        aggregatedPagCounts_[pair.waitingNodeId][pair.holdingNodeId] += pair.count;
+        modeInterval_.crossNodeWaits += pair.count;
+    }
+    modeInterval_.cyclesResolved += load.cyclesResolved;
+    modeInterval_.cycleMembers += load.cycleMembers;
+    if (reporterNodeId == nodeId_) modeInterval_.centralDetectionTimeUs += load.detectionTimeUs;
+    for (const PAGPairCount &pair : predictedPairCounts) {
+        aggregatedPagCounts_[pair.waitingNodeId][pair.holdingNodeId] += PREDICTED_PAG_WEIGHT * pair.count;
+    }
+    if (pagTrace_.isOpen()) {
+        roundWaitPairs_.insert(roundWaitPairs_.end(), pairCounts.begin(), pairCounts.end());
+        roundPredictedPairs_.insert(roundPredictedPairs_.end(), predictedPairCounts.begin(), predictedPairCounts.end());
+    }
     pagResponsesReceived_++;
 
     if (pagResponsesReceived_ >= pagResponsesExpected_) {
+        // Every completed round is folded into the decayed weights, whether or not the
+        // zones are rebuilt this time.
+        pagManager_.accumulateSample(aggregatedPagCounts_);
+        pagTrace_.writeRound(roundWaitPairs_, roundPredictedPairs_);
+        roundWaitPairs_.clear();
+        roundPredictedPairs_.clear();
+
         auto currentTime = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - lastTreeAdjustTime_).count();
 
-        long long currentTotalDeadlocksFromZones = totalDeadlocksFromZones_.load();
-        long long currentTotalDeadlocksFromCentral = totalDeadlocksFromCentral_.load();
-
-        long long newDeadlocksFromZones = currentTotalDeadlocksFromZones - prevTotalDeadlocksFromZones_;
-        long long newDeadlocksFromCentral = currentTotalDeadlocksFromCentral - prevTotalDeadlocksFromCentral_;
-
-        prevTotalDeadlocksFromZones_ = currentTotalDeadlocksFromZones;
-        prevTotalDeadlocksFromCentral_ = currentTotalDeadlocksFromCentral;
+        ZoneQualityMonitor::Summary quality = zoneQualityMonitor_.closeInterval(pagManager_.getWeightedPAG());
         lastTreeAdjustTime_ = currentTime;
 
+        if (DEADLOCK_DETECTION_MODE == MODE_ADAPTIVE) {
+            modeInterval_.seconds = duration / 1000.0;
+            DeadlockDetectionMode mode = modeSelector_.update(modeInterval_);
+            if (mode != detectionMode()) announceDetectionMode(mode);
+            modeInterval_ = DetectionModeSelector::Interval();
+        }
+
         const int CHECK_INTERVAL_MS = 5000;
-        const double CR_OVER_C_THRESHOLD = 1.0;
 
         bool shouldAdjustTree = false;
 
         if (duration >= CHECK_INTERVAL_MS) {
-            if (newDeadlocksFromZones > 0) {
-                double ratio = static_cast<double>(newDeadlocksFromCentral) / newDeadlocksFromZones;
-                if (ratio > CR_OVER_C_THRESHOLD) {
-                    shouldAdjustTree = true;
-                    std::cout << "Node " << nodeId_ << ": CR/C ratio (" << ratio << ") > " << CR_OVER_C_THRESHOLD 
-                              << ". Triggering Tree Adjustment.\n";
-                } else {
-                    std::cout << "Node " << nodeId_ << ": CR/C ratio (" << ratio << ") <= " << CR_OVER_C_THRESHOLD 
-                              << ". Skipping Tree Adjustment.\n";
-                }
-            } else if (newDeadlocksFromCentral > 0) {
+            std::string reason;
+            if (detectionZoneManager_.getTreeVersion() == 0 && !pagManager_.getWeightedPAG().empty()) {
+                // No tree yet; the PAG, predicted or observed, is enough for a first one.
                 shouldAdjustTree = true;
-                 std::cout << "Node " << nodeId_ << ": Central detected deadlocks (" << newDeadlocksFromCentral 
-                           << ") while zones detected none. Triggering Tree Adjustment.\n";
+                reason = "no detection tree yet";
             } else {
-                std::cout << "Node " << nodeId_ << ": No new deadlocks detected in last interval. Skipping Tree Adjustment.\n";
+                shouldAdjustTree = ZoneQualityMonitor::shouldAdjust(quality, reason);
             }
+            std::cout << "Node " << nodeId_ << ": " << (shouldAdjustTree ? "Triggering" : "Skipping")
+                      << " Tree Adjustment: " << reason << ".\n";
         } else {
             std::cout << "Node " << nodeId_ << ": Not yet " << CHECK_INTERVAL_MS << "ms since last check. Skipping Tree Adjustment.\n";
         }
 
         if (shouldAdjustTree) {
-            PAG fullPag = pagManager_.generatePAG(aggregatedPagEdges_);
-            auto scc_result = pagManager_.greedySCCcut(fullPag, SCC_CUT_THRESHOLD);
-            std::vector<std::vector<NodeId>> newDetectionZones = scc_result.first;
-            std::vector<NodeId> newDetectionZoneLeaders = scc_result.second;
-            network_.broadcastTreeAdjustment(nodeId_, newDetectionZones, newDetectionZoneLeaders);
+            const WeightedPAG &weightedPag = pagManager_.getWeightedPAG();
+            std::vector<std::vector<NodeId>> newDetectionZones;
+            std::vector<NodeId> newDetectionZoneLeaders;
+            if (detectionZoneManager_.getTreeVersion() == 0) {
+                auto scc_result = ZONE_PARTITIONING_MODE == ZONES_BALANCED
+                                      ? zonePartitioner_.partition(weightedPag, MAX_ZONE_SIZE)
+                                      : pagManager_.greedySCCcut(weightedPag, SCC_CUT_THRESHOLD);
+                newDetectionZones = scc_result.first;
+                newDetectionZoneLeaders = scc_result.second;
+            } else {
+                // Start from the zones in place so only nodes whose dependencies moved change zone.
+                std::vector<std::vector<NodeId>> currentZones;
+                std::vector<NodeId> currentLeaders;
+                std::vector<int> currentLevels;
+                detectionZoneManager_.getDetectionTree(currentZones, currentLeaders, currentLevels);
+                for (size_t z = 0; z < currentZones.size(); ++z) {
+                    if (currentLevels[z] == 0) {
+                        newDetectionZones.push_back(currentZones[z]);
+                        newDetectionZoneLeaders.push_back(currentLeaders[z]);
+                    }
+                }
+                zonePartitioner_.repartition(weightedPag, newDetectionZones, newDetectionZoneLeaders,
+                                             ZONE_PARTITIONING_MODE == ZONES_BALANCED ? MAX_ZONE_SIZE : numNodes_,
+                                             ZONE_MOVE_MIN_GAIN);
+            }
+            PAGManager::addSingletonZones(newDetectionZones, newDetectionZoneLeaders, numNodes_);
+            leaderElector_.electLeaders(weightedPag, newDetectionZones, newDetectionZoneLeaders);
+            std::vector<int> newDetectionZoneLevels(newDetectionZones.size(), 0);
+            zonePartitioner_.buildHierarchy(weightedPag, newDetectionZones, newDetectionZoneLeaders,
+                                            newDetectionZoneLevels, HAWK_TREE_FANOUT,
+                                            [this, &weightedPag](const std::vector<NodeId> &members, int level) {
+                                                return leaderElector_.electLeader(weightedPag, members, level);
+                                            });
+            leaderElector_.setSittingLeaders(newDetectionZoneLeaders, newDetectionZoneLevels);
+            publishDetectionTree(newDetectionZones, newDetectionZoneLeaders, newDetectionZoneLevels);
         }
 
-        aggregatedPagEdges_.clear();
+        aggregatedPagCounts_.clear();
         pagResponsesReceived_ = 0;
     }
 }
 
-void DistributedDBNode::checkAndResolveDeadlocks(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph)
+void DistributedDBNode::checkAndResolveDeadlocks()
 {
-    std::unordered_map<TransactionId, std::vector<TransactionId>> prunedGraph;
-    std::unordered_set<TransactionId> activeTxns = transactionManager_.getActiveTransactions();
-    for (const auto& pair : graph) {
-        if (activeTxns.count(pair.first)) {
-            for (TransactionId target : pair.second) {
-                if (activeTxns.count(target)) {
-                    prunedGraph[pair.first].push_back(target);
-                }
-            }
-        }
+    // Keep only edges from current snapshots; the central node's own active set does not
+    // know about transactions homed elsewhere. The reports are pruned in place and searched
+    // as one view, so a round builds no merged graph.
+    roundWfgView_.clear();
+    zoneDetection_.costs.clear();
+    for (auto &slot : memberWfgSlots_) {
+        if (slot.second.roundId != wfgRound_.id) continue;
+        wfgValidator_.pruneReport(slot.second.wfg);
+        if (!slot.second.wfg.empty()) roundWfgView_.push_back(&slot.second.wfg);
+        zoneDetection_.costs.add(slot.second.costs);
     }
+    if (roundWfgView_.empty()) return;
 
-    if (prunedGraph.empty()) return;
-
-    auto result = deadlockDetector_->findCycles(prunedGraph);
-    std::vector<std::vector<TransactionId>> detectedCycles = result.first;
-    std::unordered_map<TransactionId, int> transactionFrequencies = result.second;
+    findCyclesTimed(zoneDetection_, roundWfgView_);
+    const CycleSet &cycles = zoneDetection_.cycles;
 
-    if (!detectedCycles.empty())
+    AbortBatch abortBatch;
+    std::vector<std::vector<TransactionId>> confirmedCycles;
+    size_t phantomCycles = 0;
+    for (size_t i = 0; i < cycles.size(); ++i)
     {
-        for (const auto &cycle : detectedCycles)
-        {
-            TransactionId victimId = selectVictim(cycle, transactionFrequencies);
-            NodeId victimHomeNode = transactionManager_.getTransactionHomeNode(victimId);
-            if (victimHomeNode != 0) {
-                NetworkMessage abortMsg;
-                abortMsg.type = NetworkMessageType::ABORT_TRANSACTION_SIGNAL;
-                abortMsg.senderId = nodeId_;
-                abortMsg.receiverId = victimHomeNode;
-                abortMsg.deadlockedTransactions.push_back(victimId);
-                network_.sendMessage(abortMsg);
-            }
+        if (!wfgValidator_.isCycleConsistent(cycles, i)) {
+            wfgValidator_.countPhantomCycle();
+            phantomCycles++;
+            continue;
         }
+        if (!abortCycleVictim(zoneDetection_, wfgValidator_, i, abortBatch)) continue;
+        confirmedCycles.emplace_back(cycles.members.begin() + cycles.offsets[i],
+                                     cycles.members.begin() + cycles.offsets[i + 1]);
+    }
+    flushAbortSignals(abortBatch);
+    if (phantomCycles > 0) {
+        std::cout << "Node " << nodeId_ << ": Suppressed " << phantomCycles
+                  << " phantom cycles (" << wfgValidator_.getPhantomCycleCount() << " total).\n";
     }
 
     if (isCentralizedNode_) {
@@ -562,77 +945,178 @@ void DistributedDBNode::checkAndResolveDeadlocks(const std::unordered_map<Transa
         reportToClientMsg.type = NetworkMessageType::DEADLOCK_REPORT_TO_CLIENT;
         reportToClientMsg.senderId = nodeId_;
         reportToClientMsg.receiverId = 0;
-        reportToClientMsg.detectedCycles = detectedCycles;
-        reportToClientMsg.deadlockCount = detectedCycles.size();
+        reportToClientMsg.deadlockCount = confirmedCycles.size();
+        reportToClientMsg.detectedCycles = std::move(confirmedCycles);
         network_.sendMessage(reportToClientMsg);
     }
 }
 
-void DistributedDBNode::checkAndResolveDeadlocksForZone(NodeId zoneLeaderId, const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph)
+size_t DistributedDBNode::checkAndResolveDeadlocksForZone()
 {
-    std::unordered_map<TransactionId, std::vector<TransactionId>> prunedGraph;
-    std::unordered_set<TransactionId> activeTxns = transactionManager_.getActiveTransactions();
-    for (const auto& pair : graph) {
-        if (activeTxns.count(pair.first)) {
-            for (TransactionId target : pair.second) {
-                if (activeTxns.count(target)) {
-                    prunedGraph[pair.first].push_back(target);
-                }
+    roundWfgView_.clear();
+    zoneDetection_.costs.clear();
+    for (auto &slot : memberWfgSlots_) {
+        if (slot.second.roundId != wfgRound_.id) continue;
+        wfgValidator_.pruneReport(slot.second.wfg);
+        roundWfgView_.push_back(&slot.second.wfg);
+        zoneDetection_.costs.add(slot.second.costs);
+    }
+
+    size_t zoneEdges = DeadlockDetector::edgeCount(roundWfgView_);
+    std::vector<std::vector<TransactionId>> confirmedCycles;
+    std::unordered_set<Incarnation> victims;
+    auto start = std::chrono::steady_clock::now();
+    if (zoneEdges > 0) {
+        findCyclesTimed(zoneDetection_, roundWfgView_);
+        confirmedCycles = resolveZoneCycles(zoneDetection_, wfgValidator_, &victims);
+    }
+    long long detectionTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    size_t resolved = confirmedCycles.size();
+    // The members' probes broke their cycles as well; the tiers above must know them too.
+    victims.insert(zoneRoundProbeVictims_.begin(), zoneRoundProbeVictims_.end());
+    zoneRoundProbeVictims_.clear();
+
+    if (detectionMode() == MODE_HAWK) {
+        // The victims' cycles are broken here; of the rest, only edges on a path from an
+        // entry of the zone to an exit can still close a cycle through other zones.
+        for (auto &slot : memberWfgSlots_) {
+            if (slot.second.roundId == wfgRound_.id) wfgValidator_.dropVictims(slot.second.wfg, victims);
+        }
+        std::unordered_map<TransactionId, std::vector<TransactionId>> residual =
+            DeadlockDetector::residualGraph(roundWfgView_, zoneEntryTransactions());
+        std::vector<WFGEdgeTag> residualTags = wfgValidator_.collectTags(residual);
+        // The tiers above rank the cycles through other zones by the same costs.
+        std::vector<TransactionCost> residualCosts = zoneDetection_.costs.collect(residualTags);
+        int deadlockCount = confirmedCycles.size();
+        ZoneReportStats stats{nodeId_, 0, deadlockCount, detectionTimeUs, static_cast<int>(zoneEdges),
+                              static_cast<int>(DeadlockDetector::edgeCount(residual))};
+        sendToNode(makeZoneReport(0, wfgRound_.id, residual, std::move(residualTags), std::move(residualCosts),
+                                         std::move(confirmedCycles), deadlockCount, {stats},
+                                         std::vector<Incarnation>(victims.begin(), victims.end())));
+        updateZoneStrategy(resolved, zoneEdges);
+    }
+    return resolved;
+}
+
+std::unordered_set<TransactionId> DistributedDBNode::zoneEntryTransactions()
+{
+    std::shared_ptr<const DetectionZoneManager::Snapshot> tree = wfgRound_.tree ? wfgRound_.tree : detectionZoneManager_.getSnapshot();
+    const std::vector<NodeId> &members = tree->myZoneMembers;
+    auto inZone = [&members](NodeId node) { return std::find(members.begin(), members.end(), node) != members.end(); };
+    // Lifetimes whose home node, a member, reported every lock they hold inside the zone.
+    std::unordered_set<Incarnation> confined;
+    for (const auto &slot : memberWfgSlots_) {
+        if (slot.second.roundId != wfgRound_.id) continue;
+        for (const TransactionCost &cost : slot.second.costs) {
+            if (cost.incarnation != 0 && std::all_of(cost.lockNodes.begin(), cost.lockNodes.end(), inZone)) {
+                confined.insert(cost.incarnation);
             }
         }
     }
 
-    if (prunedGraph.empty()) {
-        if (DEADLOCK_DETECTION_MODE == MODE_HAWK && zoneLeaderId != CENTRALIZED_NODE_ID) {
-            NetworkMessage reportMsg;
-            reportMsg.type = NetworkMessageType::CENTRAL_WFG_REPORT_FROM_ZONE;
-            reportMsg.senderId = nodeId_;
-            reportMsg.receiverId = CENTRALIZED_NODE_ID;
-            network_.sendMessage(reportMsg);
+    std::unordered_set<TransactionId> entries;
+    for (const WFGPairs *part : roundWfgView_) {
+        for (const auto &pair : *part) {
+            for (TransactionId target : pair.second) {
+                const WFGEdgeTag *tag = wfgValidator_.findCurrentTag(pair.first, target);
+                if (!tag || !confined.count(tag->waitingIncarnation)) entries.insert(pair.first);
+                if (!tag || !confined.count(tag->holdingIncarnation)) entries.insert(target);
+            }
         }
-        return;
     }
+    return entries;
+}
 
-    auto result = deadlockDetector_->findCycles(prunedGraph);
-    std::vector<std::vector<TransactionId>> detectedCycles = result.first;
-
-    if (!detectedCycles.empty()) {
-        for (const auto &cycle : detectedCycles) {
-            TransactionId victimId = selectVictim(cycle, result.second);
-            NodeId victimHomeNode = transactionManager_.getTransactionHomeNode(victimId);
-            if (victimHomeNode != 0) {
-                NetworkMessage abortMsg;
-                abortMsg.type = NetworkMessageType::ABORT_TRANSACTION_SIGNAL;
-                abortMsg.senderId = nodeId_;
-                abortMsg.receiverId = victimHomeNode;
-                abortMsg.deadlockedTransactions.push_back(victimId);
-                network_.sendMessage(abortMsg);
+std::vector<std::vector<TransactionId>> DistributedDBNode::resolveZoneCycles(const DetectionWorkspace &workspace,
+                                                                             WFGValidator &validator,
+                                                                             std::unordered_set<Incarnation> *victims)
+{
+    const CycleSet &cycles = workspace.cycles;
+    AbortBatch abortBatch;
+    std::vector<std::vector<TransactionId>> confirmedCycles;
+    for (size_t i = 0; i < cycles.size(); ++i) {
+        if (!validator.isCycleConsistent(cycles, i)) {
+            validator.countPhantomCycle();
+            continue;
+        }
+        if (!abortCycleVictim(workspace, validator, i, abortBatch)) continue;
+        confirmedCycles.emplace_back(cycles.members.begin() + cycles.offsets[i],
+                                     cycles.members.begin() + cycles.offsets[i + 1]);
+    }
+    if (victims) {
+        for (const auto &pair : abortBatch.messages) {
+            for (Incarnation incarnation : pair.second.deadlockedIncarnations) {
+                if (incarnation != 0) victims->insert(incarnation);
             }
         }
     }
+    flushAbortSignals(abortBatch);
+    return confirmedCycles;
+}
 
-    if (DEADLOCK_DETECTION_MODE == MODE_HAWK && zoneLeaderId != CENTRALIZED_NODE_ID) {
-        NetworkMessage reportMsg;
-        reportMsg.type = NetworkMessageType::CENTRAL_WFG_REPORT_FROM_ZONE;
-        reportMsg.senderId = nodeId_;
-        reportMsg.receiverId = CENTRALIZED_NODE_ID;
-        reportMsg.wfgDataPairs = convertWFGToMessageFormat(prunedGraph);
-        reportMsg.detectedCycles = detectedCycles;
-        reportMsg.deadlockCount = detectedCycles.size();
-        network_.sendMessage(reportMsg);
+NetworkMessage DistributedDBNode::makeZoneReport(int level, long long roundId,
+                                                const std::unordered_map<TransactionId, std::vector<TransactionId>> &residual,
+                                                std::vector<WFGEdgeTag> edgeTags, std::vector<TransactionCost> costs,
+                                                std::vector<std::vector<TransactionId>> detectedCycles, int deadlockCount,
+                                                std::vector<ZoneReportStats> zoneStats, std::vector<Incarnation> victims)
+{
+    NetworkMessage reportMsg;
+    reportMsg.type = NetworkMessageType::CENTRAL_WFG_REPORT_FROM_ZONE;
+    reportMsg.senderId = nodeId_;
+    reportMsg.receiverId = detectionZoneManager_.getParentLeaderId(level);
+    reportMsg.roundId = roundId;
+    reportMsg.zoneLevel = level;
+    reportMsg.wfgDataPairs = convertWFGToMessageFormat(residual);
+    reportMsg.wfgEdgeTags = std::move(edgeTags);
+    reportMsg.transactionCosts = std::move(costs);
+    reportMsg.deadlockCount = deadlockCount;
+    reportMsg.detectedCycles = std::move(detectedCycles);
+    reportMsg.zoneStats = std::move(zoneStats);
+    reportMsg.victimIncarnations = std::move(victims);
+    return reportMsg;
+}
+
+void DistributedDBNode::sendToNode(const NetworkMessage &msg)
+{
+    if (msg.receiverId == nodeId_) {
+        // There is no stub to ourselves.
+        network_.getIncomingQueue()->push(msg);
+        return;
     }
+    network_.sendMessage(msg);
 }
 
-TransactionId DistributedDBNode::selectVictim(const std::vector<TransactionId> &cycle,
-                                              const std::unordered_map<TransactionId, int> &transactionFrequencies)
+bool DistributedDBNode::abortCycleVictim(const DetectionWorkspace &workspace, const WFGValidator &validator, size_t cycleIndex,
+                                         AbortBatch &batch)
 {
-    std::vector<std::pair<TransactionId, int>> candidates;
-    for (TransactionId tid : cycle)
-    {
-        candidates.push_back({tid, transactionFrequencies.at(tid)});
+    const CycleSet &cycles = workspace.cycles;
+    size_t begin = cycles.offsets[cycleIndex];
+    size_t end = cycles.offsets[cycleIndex + 1];
+    bool brokenEarlier = false;
+    for (size_t m = begin; m < end; ++m) {
+        Incarnation member = validator.getCycleMemberIncarnation(cycles, cycleIndex, cycles.members[m]);
+        if (member != 0 && batch.queued.count(member)) {
+            // Broken by a victim of this batch; one abort resolves every cycle through it.
+            countResolvedCycle(end - begin);
+            return true;
+        }
+        brokenEarlier = brokenEarlier || victimRegistry_.contains(member);
+    }
+    if (brokenEarlier) {
+        // A tier below, or an earlier round here, already aborted a member.
+        duplicateCyclesSkipped_++;
+        return false;
+    }
+
+    countResolvedCycle(end - begin);
+    std::unique_lock<std::mutex> lock(victimSelectorMutex_);
+    TransactionId victimId = victimSelector_.selectVictim(cycles, cycleIndex, validator, workspace.costs);
+    Incarnation incarnation = validator.getCycleMemberIncarnation(cycles, cycleIndex, victimId);
+    if (queueAbortSignal(batch, victimId, incarnation)) {
+        victimSelector_.recordVictim(victimId, incarnation);
+        victimRegistry_.add(incarnation);
     }
-    std::sort(candidates.begin(), candidates.end(), DeadlockDetector::compareTransactionPriority);
-    return candidates[0].first;
+    return true;
 }
 
 void DistributedDBNode::handleDeadlockResolution(const std::vector<TransactionId> &transIdsToAbort)
@@ -643,81 +1127,460 @@ void DistributedDBNode::handleDeadlockResolution(const std::vector<TransactionId
     }
 }
 
-void DistributedDBNode::handleAbortTransactionSignal(const std::vector<TransactionId> &transIdsToAbort)
+void DistributedDBNode::handleAbortTransactionSignal(const std::vector<TransactionId> &transIdsToAbort,
+                                                     const std::vector<Incarnation> &incarnations)
 {
-    for (TransactionId tid : transIdsToAbort)
+    for (size_t i = 0; i < transIdsToAbort.size(); ++i)
     {
+        TransactionId tid = transIdsToAbort[i];
+        Incarnation expected = i < incarnations.size() ? incarnations[i] : 0;
+        if (expected != 0 && transactionManager_.getTransactionIncarnation(tid) != expected)
+        {
+            // The victim already finished, or the id now names a different transaction.
+            staleAbortsIgnored_++;
+            std::cout << "Node " << nodeId_ << ": Ignoring stale abort for Trans " << tid
+                      << " (" << staleAbortsIgnored_.load() << " total).\n";
+            continue;
+        }
+        std::shared_ptr<Transaction> trans = transactionManager_.getTransaction(tid);
+        if (trans) {
+            victimAborts_++;
+            wastedStatements_ += trans->currentSQLIndex;
+            wastedLocks_ += trans->acquiredLocks.size();
+            wastedTimeMs_ += std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::high_resolution_clock::now() - trans->startTime).count();
+        }
         transactionManager_.abortTransaction(tid);
     }
 }
 
-void DistributedDBNode::handleDistributedDetectionInit(const std::vector<std::vector<NodeId>>& detectionZones, const std::vector<NodeId>& detectionZoneLeaders) {
-    detectionZoneManager_.updateDetectionZones(detectionZones, detectionZoneLeaders);
+void DistributedDBNode::publishDetectionTree(const std::vector<std::vector<NodeId>> &zones, const std::vector<NodeId> &leaders,
+                                             const std::vector<int> &levels) {
+    NetworkMessage full;
+    full.type = NetworkMessageType::DISTRIBUTED_DETECTION_INIT;
+    full.senderId = nodeId_;
+    full.treeVersion = detectionZoneManager_.getTreeVersion() + 1;
+    full.detectionZones = zones;
+    full.detectionZoneLeaders = leaders;
+    full.detectionZoneLevels = levels;
+
+    NetworkMessage diff;
+    diff.type = NetworkMessageType::DISTRIBUTED_DETECTION_INIT;
+    diff.senderId = nodeId_;
+    diff.treeVersion = full.treeVersion;
+    size_t changed = detectionZoneManager_.diffDetectionTree(zones, leaders, levels, diff);
+    // Even an unchanged tree is the best fit for the current PAG, so cut drift counts from here.
+    zoneQualityMonitor_.setTree(zones, leaders, levels, pagManager_.getWeightedPAG());
+    if (changed == 0) {
+        std::cout << "Node " << nodeId_ << ": Detection tree unchanged, nothing to send.\n";
+        return;
+    }
+    // Nodes only know their own zone before the first tree, and a diff touching most zones
+    // is no smaller than the tree itself.
+    bool sendDiff = diff.baseTreeVersion > 0 && changed * 2 < zones.size();
+    std::cout << "Node " << nodeId_ << ": " << changed << " of " << zones.size() << " zones changed.\n";
+
+    std::vector<NodeId> unreached;
+    if (sendDiff) {
+        unreached = network_.broadcastTreeAdjustment(diff, staleTreeNodes_);
+        if (!staleTreeNodes_.empty()) {
+            std::unordered_set<NodeId> upToDate;
+            for (NodeId i = 1; i <= numNodes_; ++i) {
+                if (!staleTreeNodes_.count(i)) upToDate.insert(i);
+            }
+            std::vector<NodeId> staleUnreached = network_.broadcastTreeAdjustment(full, upToDate);
+            unreached.insert(unreached.end(), staleUnreached.begin(), staleUnreached.end());
+        }
+    } else {
+        unreached = network_.broadcastTreeAdjustment(full);
+    }
+    staleTreeNodes_.clear();
+    staleTreeNodes_.insert(unreached.begin(), unreached.end());
+    // The broadcast skips this node, which routes reports through the same tree.
+    handleDistributedDetectionInit(sendDiff ? diff : full);
 }
 
-void DistributedDBNode::handleZoneDetectionRequest(NodeId centralNodeId, const std::vector<NodeId>& zoneMembers) {
-    std::unordered_set<TransactionId> activeTxns = transactionManager_.getActiveTransactions();
-    std::unordered_map<TransactionId, std::vector<TransactionId>> lwfg = lockTable_.buildAndPruneLocalWaitForGraph(activeTxns);
+void DistributedDBNode::handleZoneLeaderFailover(NodeId deputyId, NodeId failedLeaderId, long long treeVersion) {
+    if (!isCentralizedNode_) return;
+    // Trees are only published under this lock, so the tree read here stays current.
+    std::unique_lock<std::mutex> lock(aggregatedPagCountsMutex_);
+    std::vector<std::vector<NodeId>> zones;
+    std::vector<NodeId> leaders;
+    std::vector<int> levels;
+    detectionZoneManager_.getDetectionTree(zones, leaders, levels);
+    long long currentVersion = detectionZoneManager_.getTreeVersion();
+    size_t deputyZone = zones.size();
+    for (size_t z = 0; z < zones.size(); ++z) {
+        if (levels[z] == 0 && leaders[z] == failedLeaderId &&
+            std::find(zones[z].begin(), zones[z].end(), deputyId) != zones[z].end()) {
+            deputyZone = z;
+        }
+    }
+    if (treeVersion != currentVersion || deputyZone == zones.size()) {
+        // The tree has moved on since the deputy took over; the zone has a leader in it.
+        std::cout << "Node " << nodeId_ << ": Ignoring failover of zone leader " << failedLeaderId << " to Node " << deputyId
+                  << " at tree version " << treeVersion << " (current " << currentVersion << ").\n";
+        return;
+    }
+    std::cout << "Node " << nodeId_ << ": Node " << deputyId << " replaced stalled zone leader " << failedLeaderId << ".\n";
+    leaders[deputyZone] = deputyId;
+    // The stalled leader's seats higher up the tree all stem from its tier-0 zone.
+    for (size_t z = 0; z < zones.size(); ++z) {
+        if (levels[z] == 0) continue;
+        std::replace(zones[z].begin(), zones[z].end(), failedLeaderId, deputyId);
+        if (leaders[z] == failedLeaderId) leaders[z] = deputyId;
+    }
+    leaderElector_.markStalled(failedLeaderId);
+    leaderElector_.setSittingLeaders(leaders, levels);
+    publishDetectionTree(zones, leaders, levels);
+}
+
+void DistributedDBNode::handleDistributedDetectionInit(const NetworkMessage &msg) {
+    std::map<int, std::vector<NodeId>> ledBefore = detectionZoneManager_.getLedZones();
+    if (!detectionZoneManager_.applyDetectionTree(msg)) return;
+    // A new leader gets a full period before its members give up on it.
+    noteZoneLeaderContact();
+    std::map<int, std::vector<NodeId>> ledAfter = detectionZoneManager_.getLedZones();
+    auto ledZoneChanged = [&](int tier) {
+        auto before = ledBefore.find(tier);
+        auto after = ledAfter.find(tier);
+        bool ledInBoth = before != ledBefore.end() && after != ledAfter.end();
+        return !ledInBoth || before->second != after->second;
+    };
+
+    // Partial rounds of zones that changed can no longer complete; the others keep going.
+    if (ledZoneChanged(0)) {
+        std::unique_lock<std::mutex> lock(aggregatedWfgMutex_);
+        // Keep the slots of members that stay; they are reused by the next round.
+        auto led = ledAfter.find(0);
+        for (auto it = memberWfgSlots_.begin(); it != memberWfgSlots_.end();) {
+            bool member = led != ledAfter.end() && std::find(led->second.begin(), led->second.end(), it->first) != led->second.end();
+            it = member ? std::next(it) : memberWfgSlots_.erase(it);
+        }
+        wfgValidator_.clearRound();
+        // What was measured on the old members says nothing about the new ones.
+        zoneStrategy_ = ZONE_DETECT_WFG;
+        sparseZoneRounds_ = 0;
+        zoneRoundOverflowed_ = false;
+        // Let the coordinator start a round over the new members right away.
+        wfgRound_.active = false;
+        wfgRoundCv_.notify_all();
+    }
+    std::unique_lock<std::mutex> lock(tierAggregationsMutex_);
+    for (auto it = tierAggregations_.begin(); it != tierAggregations_.end();) {
+        it = ledZoneChanged(it->first) ? tierAggregations_.erase(it) : std::next(it);
+    }
+}
+
+void DistributedDBNode::handleZoneDetectionRequest(NodeId centralNodeId, long long roundId, long long treeVersion,
+                                                   const std::vector<NodeId>& zoneMembers, int strategy) {
+    std::shared_ptr<const DetectionZoneManager::Snapshot> tree = detectionZoneManager_.getSnapshot();
+    if (tree->version > treeVersion && tree->myZoneLeaderId != centralNodeId) {
+        // The requester leads this node's zone only in a tree this node has already replaced.
+        std::cout << "Node " << nodeId_ << ": Ignoring zone detection request of tree version " << treeVersion
+                  << " from Node " << centralNodeId << "; at version " << tree->version << " the leader is Node "
+                  << tree->myZoneLeaderId << ".\n";
+        return;
+    }
+    noteZoneLeaderContact();
+    if (tree->replacedLeaderId == centralNodeId) {
+        std::cout << "Node " << nodeId_ << ": Zone leader " << centralNodeId << " is back; standing down as its deputy.\n";
+        detectionZoneManager_.standDown();
+    }
     NetworkMessage reportMsg;
     reportMsg.type = NetworkMessageType::ZONE_WFG_REPORT;
     reportMsg.senderId = nodeId_;
     reportMsg.receiverId = centralNodeId;
+    reportMsg.roundId = roundId;
+    reportMsg.treeVersion = tree->version;
+    // Sent in either strategy, since the zone may have left probes since they ran.
+    reportMsg.victimIncarnations = takeProbeVictims();
+    if (strategy == ZONE_DETECT_PROBES) {
+        // The probes stand in for the WFG; the empty report still completes the round.
+        reportMsg.probeOverflow = launchZoneProbes(centralNodeId);
+        sendToNode(reportMsg);
+        return;
+    }
+    std::unordered_set<TransactionId> activeTxns = transactionManager_.getActiveTransactions();
+    std::unordered_map<TransactionId, std::vector<TransactionId>> lwfg = lockTable_.buildAndPruneLocalWaitForGraph(activeTxns);
     reportMsg.wfgDataPairs = convertWFGToMessageFormat(lwfg);
-    network_.sendMessage(reportMsg);
+    reportMsg.wfgEdgeTags = tagLocalWFG(lwfg);
+    reportMsg.transactionCosts = transactionManager_.getBlockedTransactionCosts();
+    sendToNode(reportMsg);
 }
 
-void DistributedDBNode::handleZoneWFGReport(NodeId reporterNodeId, const std::vector<std::pair<TransactionId, std::vector<TransactionId>>> &wfgDataPairs) {
+void DistributedDBNode::handleZoneWFGReport(NodeId reporterNodeId, long long roundId, WFGPairs wfgDataPairs,
+                                            const std::vector<WFGEdgeTag> &edgeTags,
+                                            std::vector<TransactionCost> transactionCosts, bool probeOverflow,
+                                            const std::vector<Incarnation> &probeVictims) {
     if (!detectionZoneManager_.isZoneLeader()) return;
     std::unique_lock<std::mutex> lock(aggregatedWfgMutex_);
-    mergeWFG(aggregatedWfg_, wfgDataPairs);
-    wfgReportsReceived_++;
-    if (wfgReportsReceived_ >= wfgReportsExpected_) {
-        checkAndResolveDeadlocksForZone(nodeId_, aggregatedWfg_);
-        aggregatedWfg_.clear();
-        wfgReportsReceived_ = 0;
+    // A report of a round that already closed would mix old edges into the next one.
+    if (!acceptWFGReport(reporterNodeId, roundId)) return;
+    zoneRoundOverflowed_ = zoneRoundOverflowed_ || probeOverflow;
+    victimRegistry_.addAll(probeVictims);
+    zoneRoundProbeVictims_.insert(zoneRoundProbeVictims_.end(), probeVictims.begin(), probeVictims.end());
+    MemberWFGSlot &slot = memberWfgSlots_[reporterNodeId];
+    slot.roundId = roundId;
+    slot.wfg.swap(wfgDataPairs);
+    wfgValidator_.addEdgeTags(edgeTags);
+    slot.costs.swap(transactionCosts);
+    wfgRound_.reportsReceived++;
+    if (wfgRound_.reportsReceived >= wfgRound_.reportsExpected) {
+        closeWFGRound();
     }
 }
 
-void DistributedDBNode::handleCentralWFGReportFromZone(NodeId zoneLeaderId, 
+void DistributedDBNode::handleCentralWFGReportFromZone(NodeId zoneLeaderId, long long roundId,
     const std::vector<std::pair<TransactionId, std::vector<TransactionId>>> &wfgDataPairs, 
     const std::vector<std::vector<TransactionId>>& detectedCycles, 
-    int reportedDeadlockCount) {
-if (!isCentralizedNode_) return;
-std::unique_lock<std::mutex> lock(centralAggregatedWfgMutex_);
-mergeWFG(centralAggregatedWfg_, wfgDataPairs);
-centralWfgReportsReceived_++;
+    int reportedDeadlockCount,
+    const std::vector<WFGEdgeTag> &edgeTags,
+    const std::vector<TransactionCost> &transactionCosts,
+    int zoneLevel,
+    const std::vector<ZoneReportStats> &zoneStats,
+    const std::vector<Incarnation> &victims) {
+    // Registered first, so that no tier this node leads aborts a second member of their cycles.
+    victimRegistry_.addAll(victims);
+    std::vector<NodeId> tierMembers;
+    int tier = detectionZoneManager_.findLedZoneForReport(zoneLeaderId, zoneLevel, tierMembers);
+    if (tier > 0) {
+        handleTierWFGReport(tier, tierMembers.size(), zoneLeaderId, roundId, wfgDataPairs, detectedCycles, reportedDeadlockCount,
+                            edgeTags, transactionCosts, zoneStats, victims);
+        return;
+    }
+    if (!isCentralizedNode_) return;
+    std::unique_lock<std::mutex> lock(centralReportsMutex_);
+    zoneQualityMonitor_.recordZoneStats(zoneStats);
+    for (const auto& cycle : detectedCycles) {
+        centralDetectedCycles_.push_back(cycle);
+    }
 
-totalDeadlocksFromZones_ += reportedDeadlockCount; 
-for (const auto& cycle : detectedCycles) {
-centralDetectedCycles_.push_back(cycle);
+    std::vector<std::pair<int, NodeId>> expected = expectedCentralReporters();
+    std::pair<int, NodeId> reporter(zoneLevel, zoneLeaderId);
+    if (std::find(expected.begin(), expected.end(), reporter) == expected.end()) {
+        // Sent under a tree that has since changed; its cycles are resolved, its edges are stale.
+        std::cout << "Node " << nodeId_ << ": Ignoring the edges of tier-" << zoneLevel << " leader " << zoneLeaderId
+                  << ", which no longer reports here.\n";
+        return;
+    }
+    if (!centralRoundOpen_) {
+        centralRoundOpen_ = true;
+        centralRoundStart_ = std::chrono::steady_clock::now();
+        // The timer closes the round if a leader stays silent.
+        centralRoundCv_.notify_all();
+    }
+    CentralReport &report = centralReports_[reporter];
+    report.wfg.assign(wfgDataPairs.begin(), wfgDataPairs.end());
+    report.edgeTags = edgeTags;
+    report.costs = transactionCosts;
+    report.fresh = true;
+
+    if (countFreshCentralReports(expected) == expected.size()) {
+        closeCentralRound(expected);
+    }
 }
 
-if (centralWfgReportsReceived_ >= numNodes_) { 
-std::pair<std::vector<std::vector<TransactionId>>, std::unordered_map<TransactionId, int>> global_detection_result = 
-deadlockDetector_->findCycles(centralAggregatedWfg_);
+size_t DistributedDBNode::countFreshCentralReports(const std::vector<std::pair<int, NodeId>> &expected) {
+    size_t freshReports = 0;
+    for (const auto &key : expected) {
+        auto it = centralReports_.find(key);
+        if (it != centralReports_.end() && it->second.fresh) freshReports++;
+    }
+    return freshReports;
+}
 
-std::vector<std::vector<TransactionId>> globalDetectedCycles = global_detection_result.first;
+void DistributedDBNode::roundTimerLoop() {
+    const std::chrono::milliseconds timeout(WFG_ROUND_TIMEOUT_MS);
+    while (systemRunning) {
+        // Tier rounds open without waking this thread; the wait below is never longer than
+        // a timeout, so an open one is seen before its deadline.
+        auto nextCheck = std::chrono::steady_clock::now() + timeout;
+        std::vector<NetworkMessage> tierReports;
+        {
+            std::unique_lock<std::mutex> lock(tierAggregationsMutex_);
+            for (auto &entry : tierAggregations_) {
+                TierAggregation &aggregation = entry.second;
+                if (!aggregation.round.active) continue;
+                auto deadline = aggregation.roundStart + timeout;
+                if (std::chrono::steady_clock::now() < deadline) {
+                    nextCheck = std::min(nextCheck, deadline);
+                    continue;
+                }
+                // A stalled child must not hold back the cycles the others' reports already show.
+                std::cout << "Node " << nodeId_ << ": Tier-" << entry.first << " round " << aggregation.round.id
+                          << " timed out with " << aggregation.round.reportsReceived << " of "
+                          << aggregation.round.reportsExpected << " child reports; closing it with partial data.\n";
+                tierReports.push_back(closeTierRound(entry.first, aggregation));
+            }
+        }
+        // Sent unlocked, since the next tier up may be led by this node as well.
+        for (const NetworkMessage &reportMsg : tierReports) {
+            sendToNode(reportMsg);
+        }
 
-totalDeadlocksFromCentral_ += globalDetectedCycles.size(); 
+        std::unique_lock<std::mutex> lock(centralReportsMutex_);
+        if (centralRoundOpen_) {
+            auto deadline = centralRoundStart_ + timeout;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                std::vector<std::pair<int, NodeId>> expected = expectedCentralReporters();
+                std::cout << "Node " << nodeId_ << ": Central round timed out with " << countFreshCentralReports(expected)
+                          << " of " << expected.size() << " leader reports; closing it with partial data.\n";
+                closeCentralRound(expected);
+            } else {
+                nextCheck = std::min(nextCheck, deadline);
+            }
+        }
+        centralRoundCv_.wait_until(lock, nextCheck);
+    }
+}
 
-centralDeadlockCount_ += globalDetectedCycles.size(); 
-for (const auto& cycle : globalDetectedCycles) {
-centralDetectedCycles_.push_back(cycle);
+std::vector<std::pair<int, NodeId>> DistributedDBNode::expectedCentralReporters() {
+    if (detectionZoneManager_.getTreeVersion() == 0) {
+        std::vector<std::pair<int, NodeId>> everyNode;
+        for (NodeId node = 1; node <= numNodes_; ++node) {
+            everyNode.push_back({0, node});
+        }
+        return everyNode;
+    }
+    return detectionZoneManager_.getCentralReporters();
 }
 
-NetworkMessage reportToClientMsg;
-reportToClientMsg.type = NetworkMessageType::DEADLOCK_REPORT_TO_CLIENT;
-reportToClientMsg.senderId = nodeId_;
-reportToClientMsg.receiverId = 0; 
-reportToClientMsg.detectedCycles = centralDetectedCycles_; 
-reportToClientMsg.deadlockCount = centralDeadlockCount_;     
-network_.sendMessage(reportToClientMsg);
+void DistributedDBNode::closeCentralRound(const std::vector<std::pair<int, NodeId>> &expected) {
+    centralWfgView_.clear();
+    centralDetection_.costs.clear();
+    for (auto it = centralReports_.begin(); it != centralReports_.end();) {
+        if (std::find(expected.begin(), expected.end(), it->first) == expected.end()) {
+            it = centralReports_.erase(it);
+            continue;
+        }
+        if (it->second.fresh && !it->second.wfg.empty()) {
+            centralWfgValidator_.addEdgeTags(it->second.edgeTags);
+            centralWfgView_.push_back(&it->second.wfg);
+            centralDetection_.costs.add(it->second.costs);
+        }
+        ++it;
+    }
+
+    // Fast path: no leader forwarded an edge, so no cycle can span the top-level zones.
+    if (!centralWfgView_.empty()) {
+        for (auto &entry : centralReports_) {
+            if (entry.second.fresh) centralWfgValidator_.pruneReport(entry.second.wfg);
+        }
+        findCyclesTimed(centralDetection_, centralWfgView_);
+        const CycleSet &cycles = centralDetection_.cycles;
+        AbortBatch abortBatch;
+        for (size_t i = 0; i < cycles.size(); ++i) {
+            if (!centralWfgValidator_.isCycleConsistent(cycles, i)) {
+                centralWfgValidator_.countPhantomCycle();
+                continue;
+            }
+            if (!abortCycleVictim(centralDetection_, centralWfgValidator_, i, abortBatch)) continue;
+            zoneQualityMonitor_.recordEscapedCycle(centralWfgValidator_.getCycleReporters(cycles, i));
+            centralDeadlockCount_++;
+            centralDetectedCycles_.emplace_back(cycles.members.begin() + cycles.offsets[i],
+                                                cycles.members.begin() + cycles.offsets[i + 1]);
+        }
+        flushAbortSignals(abortBatch);
+    }
+
+    NetworkMessage reportToClientMsg;
+    reportToClientMsg.type = NetworkMessageType::DEADLOCK_REPORT_TO_CLIENT;
+    reportToClientMsg.senderId = nodeId_;
+    reportToClientMsg.receiverId = 0;
+    reportToClientMsg.detectedCycles = centralDetectedCycles_;
+    reportToClientMsg.deadlockCount = centralDeadlockCount_;
+    network_.sendMessage(reportToClientMsg);
 
-centralAggregatedWfg_.clear();
-centralWfgReportsReceived_ = 0;
-centralDeadlockCount_ = 0; 
-centralDetectedCycles_.clear();
+    for (auto &entry : centralReports_) {
+        entry.second.fresh = false;
+    }
+    centralWfgValidator_.clearRound();
+    centralDeadlockCount_ = 0;
+    centralDetectedCycles_.clear();
+    centralRoundOpen_ = false;
 }
+
+void DistributedDBNode::handleTierWFGReport(int tier, size_t expectedReports, NodeId childLeaderId, long long roundId,
+                                            const std::vector<std::pair<TransactionId, std::vector<TransactionId>>> &wfgDataPairs,
+                                            const std::vector<std::vector<TransactionId>> &detectedCycles, int reportedDeadlockCount,
+                                            const std::vector<WFGEdgeTag> &edgeTags,
+                                            const std::vector<TransactionCost> &transactionCosts,
+                                            const std::vector<ZoneReportStats> &zoneStats,
+                                            const std::vector<Incarnation> &victims) {
+    NetworkMessage reportMsg;
+    {
+        std::unique_lock<std::mutex> lock(tierAggregationsMutex_);
+        TierAggregation &aggregation = tierAggregations_[tier];
+        // A report overtaken by a newer one from the same child would bring back old edges.
+        if (!acceptWFGReport(aggregation, childLeaderId, roundId)) return;
+        if (!aggregation.round.active) {
+            aggregation.round.id++;
+            aggregation.round.active = true;
+            aggregation.round.reportsReceived = 0;
+            aggregation.round.reportsExpected = expectedReports;
+            aggregation.roundStart = std::chrono::steady_clock::now();
+        }
+        // A child that reports again before the others replaces its edges; it is counted once.
+        MemberWFGSlot &slot = aggregation.childSlots[childLeaderId];
+        if (slot.roundId != aggregation.round.id) aggregation.round.reportsReceived++;
+        slot.roundId = aggregation.round.id;
+        slot.wfg.assign(wfgDataPairs.begin(), wfgDataPairs.end());
+        slot.costs = transactionCosts;
+        aggregation.validator.addEdgeTags(edgeTags);
+        aggregation.detectedCycles.insert(aggregation.detectedCycles.end(), detectedCycles.begin(), detectedCycles.end());
+        aggregation.deadlockCount += reportedDeadlockCount;
+        aggregation.zoneStats.insert(aggregation.zoneStats.end(), zoneStats.begin(), zoneStats.end());
+        aggregation.victims.insert(aggregation.victims.end(), victims.begin(), victims.end());
+        if (aggregation.round.reportsReceived < aggregation.round.reportsExpected) return;
+        reportMsg = closeTierRound(tier, aggregation);
+    }
+    sendToNode(reportMsg);
+}
+
+NetworkMessage DistributedDBNode::closeTierRound(int tier, TierAggregation &aggregation) {
+    aggregation.view.clear();
+    tierDetection_.costs.clear();
+    for (auto &slot : aggregation.childSlots) {
+        if (slot.second.roundId != aggregation.round.id) continue;
+        aggregation.validator.pruneReport(slot.second.wfg);
+        aggregation.view.push_back(&slot.second.wfg);
+        tierDetection_.costs.add(slot.second.costs);
+    }
+
+    // Cycles spanning several child zones of this one show up here for the first time.
+    size_t tierEdges = DeadlockDetector::edgeCount(aggregation.view);
+    std::vector<std::vector<TransactionId>> tierCycles;
+    std::unordered_set<Incarnation> tierVictims;
+    auto start = std::chrono::steady_clock::now();
+    if (tierEdges > 0) {
+        findCyclesTimed(tierDetection_, aggregation.view);
+        tierCycles = resolveZoneCycles(tierDetection_, aggregation.validator, &tierVictims);
+    }
+    long long detectionTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    for (auto &slot : aggregation.childSlots) {
+        if (slot.second.roundId == aggregation.round.id) aggregation.validator.dropVictims(slot.second.wfg, tierVictims);
+    }
+    std::unordered_map<TransactionId, std::vector<TransactionId>> residual = DeadlockDetector::residualGraph(aggregation.view);
+    std::vector<WFGEdgeTag> residualTags = aggregation.validator.collectTags(residual);
+    std::vector<TransactionCost> residualCosts = tierDetection_.costs.collect(residualTags);
+    int deadlockCount = aggregation.deadlockCount + tierCycles.size();
+    std::vector<std::vector<TransactionId>> subtreeCycles = std::move(aggregation.detectedCycles);
+    subtreeCycles.insert(subtreeCycles.end(), tierCycles.begin(), tierCycles.end());
+    std::vector<ZoneReportStats> subtreeStats = std::move(aggregation.zoneStats);
+    subtreeStats.push_back({nodeId_, tier, static_cast<int>(tierCycles.size()), detectionTimeUs, static_cast<int>(tierEdges),
+                            static_cast<int>(DeadlockDetector::edgeCount(residual))});
+    std::vector<Incarnation> subtreeVictims = std::move(aggregation.victims);
+    subtreeVictims.insert(subtreeVictims.end(), tierVictims.begin(), tierVictims.end());
+
+    aggregation.detectedCycles.clear();
+    aggregation.deadlockCount = 0;
+    aggregation.zoneStats.clear();
+    aggregation.victims.clear();
+    aggregation.validator.clearRound();
+    aggregation.round.active = false;
+    return makeZoneReport(tier, aggregation.round.id, residual, std::move(residualTags), std::move(residualCosts),
+                          std::move(subtreeCycles), deadlockCount, std::move(subtreeStats), std::move(subtreeVictims));
 }
 
 void DistributedDBNode::handlePathPushingProbe(const NetworkMessage& msg) {
@@ -736,18 +1599,39 @@ void DistributedDBNode::handlePathPushingProbe(const NetworkMessage& msg) {
     NodeId blockingTransHomeNode = transactionManager_.getTransactionHomeNode(blockingTransId);
     std::vector<TransactionId> newPath = msg.path;
     newPath.push_back(blockingTransId);
-
-    if (std::find(msg.path.begin(), msg.path.end(), blockingTransId) != msg.path.end()) {
-        TransactionId victimId = selectVictim(newPath, {});
-        NodeId victimHomeNode = transactionManager_.getTransactionHomeNode(victimId);
-        if (victimHomeNode != 0) {
-            NetworkMessage abortMsg;
-            abortMsg.type = NetworkMessageType::ABORT_TRANSACTION_SIGNAL;
-            abortMsg.senderId = nodeId_;
-            abortMsg.receiverId = victimHomeNode;
-            abortMsg.deadlockedTransactions.push_back(victimId);
-            network_.sendMessage(abortMsg);
+    // Every node adds the cost of the path member homed on it, so the node that closes a
+    // cycle can rank all of its members with the configured victim policy.
+    std::vector<TransactionCost> pathCosts = msg.transactionCosts;
+    pathCosts.resize(msg.path.size() - 1);
+    transactionManager_.getTransactionCost(lastTransInPath, pathCosts.emplace_back());
+
+    auto cycleStart = std::find(msg.path.begin(), msg.path.end(), blockingTransId);
+    if (cycleStart != msg.path.end()) {
+        std::vector<TransactionId> cycle(cycleStart, msg.path.end());
+        std::vector<TransactionCost> cycleCosts(pathCosts.begin() + (cycleStart - msg.path.begin()), pathCosts.end());
+        for (const TransactionCost &cost : cycleCosts) {
+            if (cost.transId != 0 && victimRegistry_.contains(cost.incarnation)) {
+                // Another probe, or a WFG round, already aborted a member.
+                duplicateCyclesSkipped_++;
+                return;
+            }
+        }
+        countResolvedCycle(cycle.size());
+        AbortBatch abortBatch;
+        {
+            std::unique_lock<std::mutex> selectorLock(victimSelectorMutex_);
+            TransactionId victimId = victimSelector_.selectVictim(cycle, cycleCosts);
+            size_t victimIndex = std::find(cycle.begin(), cycle.end(), victimId) - cycle.begin();
+            Incarnation incarnation = cycleCosts[victimIndex].transId == victimId ? cycleCosts[victimIndex].incarnation : 0;
+            if (queueAbortSignal(abortBatch, victimId, incarnation)) {
+                victimSelector_.recordVictim(victimId, incarnation);
+                if (victimRegistry_.add(incarnation) && msg.centralNodeId != 0) {
+                    std::unique_lock<std::mutex> lock(probeVictimsMutex_);
+                    probeVictimsPending_.push_back(incarnation);
+                }
+            }
         }
+        flushAbortSignals(abortBatch);
         if (isCentralizedNode_) {
             NetworkMessage reportToClientMsg;
             reportToClientMsg.type = NetworkMessageType::DEADLOCK_REPORT_TO_CLIENT;
@@ -759,12 +1643,22 @@ void DistributedDBNode::handlePathPushingProbe(const NetworkMessage& msg) {
         }
     }
     else if (blockingTransHomeNode != 0) {
+        if (msg.centralNodeId != 0) {
+            std::vector<NodeId> members = detectionZoneManager_.getMyDetectionZoneMembers();
+            if (newPath.size() > static_cast<size_t>(ZONE_PROBE_MAX_PATH) ||
+                std::find(members.begin(), members.end(), blockingTransHomeNode) == members.end()) {
+                probeOverflowPending_ = true;
+                return;
+            }
+        }
         NetworkMessage newProbeMsg;
         newProbeMsg.type = NetworkMessageType::PATH_PUSHING_PROBE;
         newProbeMsg.senderId = nodeId_;
         newProbeMsg.receiverId = blockingTransHomeNode;
+        newProbeMsg.centralNodeId = msg.centralNodeId;
         newProbeMsg.path = newPath;
-        network_.sendMessage(newProbeMsg);
+        newProbeMsg.transactionCosts = std::move(pathCosts);
+        sendToNode(newProbeMsg);
     }
 }
 
@@ -783,13 +1677,66 @@ void DistributedDBNode::initiatePathPushingProbes() {
     }
 }
 
-void DistributedDBNode::mergeWFG(std::unordered_map<TransactionId, std::vector<TransactionId>>& targetWfg,
-                                const std::vector<std::pair<TransactionId, std::vector<TransactionId>>>& sourceData) {
-    for (const auto& pair : sourceData) {
+std::vector<WFGEdgeTag>
+DistributedDBNode::tagLocalWFG(const std::unordered_map<TransactionId, std::vector<TransactionId>>& wfg) {
+    long long epoch = ++wfgEpoch_;
+    std::vector<WFGEdgeTag> tags;
+    for (const auto& pair : wfg) {
+        Incarnation waitingIncarnation = transactionManager_.getTransactionIncarnation(pair.first);
         for (TransactionId target : pair.second) {
-            targetWfg[pair.first].push_back(target);
+            tags.push_back({pair.first, target, nodeId_, epoch,
+                            waitingIncarnation, transactionManager_.getTransactionIncarnation(target)});
         }
     }
+    return tags;
+}
+
+bool DistributedDBNode::queueAbortSignal(AbortBatch &batch, TransactionId victimId, Incarnation incarnation) {
+    NodeId victimHomeNode = incarnation != 0 ? getIncarnationHomeNode(incarnation)
+                                             : transactionManager_.getTransactionHomeNode(victimId);
+    if (victimHomeNode == 0) return false;
+    long long key = incarnation != 0 ? incarnation : makeIncarnation(victimHomeNode, victimId);
+    if (!batch.queued.insert(key).second) return false;
+
+    auto it = batch.messages.find(victimHomeNode);
+    if (it == batch.messages.end()) {
+        NetworkMessage abortMsg;
+        abortMsg.type = NetworkMessageType::ABORT_TRANSACTION_SIGNAL;
+        abortMsg.senderId = nodeId_;
+        abortMsg.receiverId = victimHomeNode;
+        it = batch.messages.emplace(victimHomeNode, std::move(abortMsg)).first;
+    }
+    it->second.deadlockedTransactions.push_back(victimId);
+    it->second.deadlockedIncarnations.push_back(incarnation);
+    return true;
+}
+
+void DistributedDBNode::flushAbortSignals(AbortBatch &batch) {
+    std::vector<NetworkMessage> remoteMessages;
+    for (auto &pair : batch.messages) {
+        if (pair.first == nodeId_) {
+            sendToNode(pair.second);
+        } else {
+            remoteMessages.push_back(std::move(pair.second));
+        }
+    }
+    if (!remoteMessages.empty()) {
+        network_.sendMessagesInParallel(remoteMessages);
+    }
+    batch.messages.clear();
+    batch.queued.clear();
+}
+
+void DistributedDBNode::assignWFGPairs(WFGPairs &target,
+                                       const std::unordered_map<TransactionId, std::vector<TransactionId>> &source) {
+    size_t used = 0;
+    for (const auto &pair : source) {
+        if (used == target.size()) target.emplace_back();
+        target[used].first = pair.first;
+        target[used].second.assign(pair.second.begin(), pair.second.end());
+        ++used;
+    }
+    target.resize(used);
 }
 
 std::vector<std::pair<TransactionId, std::vector<TransactionId>>>
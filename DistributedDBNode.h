@@ -7,7 +7,16 @@
 #include "LockTable.h"
 #include "DeadlockDetector.h"
 #include "PAGManager.h"
+#include "PAGSampler.h"
+#include "PAGTrace.h"
+#include "ZonePartitioner.h"
+#include "LeaderElector.h"
+#include "ZoneQualityMonitor.h"
+#include "DetectionModeSelector.h"
 #include "DetectionZoneManager.h"
+#include "WFGValidator.h"
+#include "VictimSelector.h"
+#include "VictimRegistry.h"
 #include "Network.h"
 #ifdef TRANSACTION_TYPE_TPCC
 #include "tpcc.h"
@@ -23,6 +32,7 @@
 #include <chrono>
 #include <unordered_set>
 #include <atomic>
+#include <map>
 
 #ifdef TRANSACTION_TYPE_TPCC
 #include "tpcc.h"
@@ -33,7 +43,8 @@
 class DistributedDBNode
 {
 public:
-    DistributedDBNode(NodeId id, int numNodes, Network &network);
+    DistributedDBNode(NodeId id, int numNodes, Network &network,
+                      VictimPolicy victimPolicy = VictimPolicy::MOST_CYCLES);
     ~DistributedDBNode();
 
     void run();
@@ -41,16 +52,85 @@ public:
     // Retrieves the latencies of all completed transactions on this node.
     std::vector<long long> getCompletedTransactionLatencies();
 
+    // Prints the victim policy and the work lost to deadlock aborts on this node.
+    void printVictimPolicyStats();
+
 private:
+    // Victims chosen in one detection round, grouped by home node so that each node gets a
+    // single ABORT_TRANSACTION_SIGNAL however many cycles it lost transactions to.
+    struct AbortBatch
+    {
+        std::map<NodeId, NetworkMessage> messages;
+        std::unordered_set<long long> queued; // incarnation, or home node and id if unknown
+    };
+
+    // The WFG collection round this node runs as an aggregator: the central node in
+    // centralized mode, a tier-0 leader in HAWK. Guarded by aggregatedWfgMutex_.
+    struct WFGRound
+    {
+        long long id = 0; // stamped on requests and echoed by reports
+        bool active = false;
+        int reportsReceived = 0;
+        int reportsExpected = 0;
+        size_t cyclesResolved = 0; // by the last round closed
+        // The detection tree a zone round was started under; null in centralized mode.
+        std::shared_ptr<const DetectionZoneManager::Snapshot> tree;
+    };
+
+    // The latest WFG report of one zone member, kept by its leader, or of one node, kept by
+    // the central node in centralized mode. A report replaces the slot wholesale, and
+    // detection reads the slots of the current round in place.
+    struct MemberWFGSlot
+    {
+        long long roundId = 0; // round the report answered
+        WFGPairs wfg;
+        std::vector<TransactionCost> costs; // of the member's blocked transactions
+    };
+
+    // Round state of a zone this node leads above tier 0 of the detection tree. Its child
+    // leaders report at their own pace, so a round opens with the first report and closes
+    // once every child has reported into it, or WFG_ROUND_TIMEOUT_MS after it opened.
+    struct TierAggregation
+    {
+        WFGRound round;
+        std::chrono::steady_clock::time_point roundStart;
+        // Each child's latest residual graph; a newer report replaces the child's slot.
+        std::unordered_map<NodeId, MemberWFGSlot> childSlots;
+        // The child's own round stamped on its latest report, so a reordered older one is dropped.
+        std::unordered_map<NodeId, long long> childRoundIds;
+        WFGView view; // the current round's slots, rebuilt when the round closes
+        WFGValidator validator;
+        std::vector<std::vector<TransactionId>> detectedCycles; // found further down the subtree
+        int deadlockCount = 0;
+        std::vector<ZoneReportStats> zoneStats; // of every zone in the subtree
+        std::vector<Incarnation> victims;       // aborted in the subtree
+    };
+
+    // The latest report of a leader that reports to the central node. Leaders run their
+    // rounds at their own pace; a central round closes once every expected leader has sent
+    // a fresh report.
+    struct CentralReport
+    {
+        WFGPairs wfg; // residual graph of the leader's subtree
+        std::vector<WFGEdgeTag> edgeTags;
+        std::vector<TransactionCost> costs; // of the residual graph's blocked transactions
+        bool fresh = false; // arrived in the current central round
+    };
+
     NodeId nodeId_;
     int numNodes_;
     ResourceManager resourceManager_;
     TransactionManager transactionManager_;
     LockTable lockTable_;
     PAGManager pagManager_;
+    PAGSampler pagSampler_; // this node's cross-node waits since the last PAG request
+    PAGSampler predictedPagSampler_; // remote accesses declared by this node's new TPC-C transactions
+    ZonePartitioner zonePartitioner_;
+    LeaderElector leaderElector_; // central node only
+    ZoneQualityMonitor zoneQualityMonitor_; // central node only
+    DetectionModeSelector modeSelector_; // central node only, MODE_ADAPTIVE
     DetectionZoneManager detectionZoneManager_;
     Network &network_;
-    std::unique_ptr<DeadlockDetector> deadlockDetector_;
 
     std::thread transactionPollingThread_;
     std::thread messageProcessingThread_;
@@ -61,35 +141,113 @@ private:
     std::thread distributedDetectCoordinatorThread;
     std::thread centralizedDetectThread;
     std::thread pathPushingThread;
+    std::thread roundTimerThread; // central and tier rounds, HAWK
 
     bool isCentralizedNode_;
-    bool isCentralizedDetectionMode_;
+    // The detector this node runs: DEADLOCK_DETECTION_MODE, or in MODE_ADAPTIVE the one the
+    // central node announced last, with the epoch of that announcement.
+    std::atomic<int> activeDetectionMode_;
+    std::atomic<long long> detectionModeEpoch_;
+    std::mutex detectionModeMutex_; // serializes applyDetectionMode
 
-    std::unordered_map<TransactionId, std::vector<TransactionId>> aggregatedWfg_;
     std::mutex aggregatedWfgMutex_;
-    int wfgReportsReceived_;
-    int wfgReportsExpected_;
+    WFGRound wfgRound_;
+    // Every WFG round aggregates into per-reporter slots rather than one merged graph.
+    std::unordered_map<NodeId, MemberWFGSlot> memberWfgSlots_;
+    WFGView roundWfgView_; // the current round's slots, rebuilt when the round closes
+    std::condition_variable wfgRoundCv_;
+    std::atomic<long long> staleWfgReportsDropped_;
+    // When this node last heard from the leader of its tier-0 zone, in steady-clock
+    // milliseconds; see ZONE_LEADER_TIMEOUT_MS.
+    std::atomic<long long> lastZoneLeaderContactMs_;
+    // How the tier-0 zone this node leads is checked; these three are guarded by
+    // aggregatedWfgMutex_. See ZoneDetectionStrategy.
+    ZoneDetectionStrategy zoneStrategy_;
+    int sparseZoneRounds_;
+    bool zoneRoundOverflowed_; // a member reported a probe overflow this round
+    // Set when a zone probe launched or forwarded here overflows; sent with this node's
+    // next zone report.
+    std::atomic<bool> probeOverflowPending_;
+    // Victims this node's zone probes aborted since its last zone report; sent with the next.
+    std::vector<Incarnation> probeVictimsPending_;
+    std::mutex probeVictimsMutex_;
+    // Victims the members' zone probes reported this round, forwarded up with the zone's
+    // report. Guarded by aggregatedWfgMutex_.
+    std::vector<Incarnation> zoneRoundProbeVictims_;
 
-    std::vector<WFDEdge> aggregatedPagEdges_;
-    std::mutex aggregatedPagEdgesMutex_;
+    WeightedPAG aggregatedPagCounts_; // this round's wait counts per node pair, at most numNodes^2 entries
+    std::mutex aggregatedPagCountsMutex_;
+    // This round's pairs as received, kept only while pagTrace_ is open.
+    std::vector<PAGPairCount> roundWaitPairs_;
+    std::vector<PAGPairCount> roundPredictedPairs_;
+    PAGTrace pagTrace_; // central node only, see PAG_TRACE_FILE
     int pagResponsesReceived_;
     int pagResponsesExpected_;
+    DetectionModeSelector::Interval modeInterval_; // this PAG round so far, MODE_ADAPTIVE
 
-    std::unordered_map<TransactionId, std::vector<TransactionId>> centralAggregatedWfg_;
-    std::mutex centralAggregatedWfgMutex_;
-    int centralWfgReportsReceived_;
+    // Keyed by (tier, leader); a leader may report several tiers to the central node.
+    std::map<std::pair<int, NodeId>, CentralReport> centralReports_;
+    std::mutex centralReportsMutex_;
+    bool centralRoundOpen_;
+    std::chrono::steady_clock::time_point centralRoundStart_;
+    std::condition_variable centralRoundCv_; // wakes roundTimerLoop when a round opens
+    WFGView centralWfgView_;
     int centralDeadlockCount_;
     std::vector<std::vector<TransactionId>> centralDetectedCycles_;
 
+    // Keyed by tier; a node may lead zones on several tiers at once.
+    std::map<int, TierAggregation> tierAggregations_;
+    std::mutex tierAggregationsMutex_;
+
+    // Cycle search state of one kind of detection round: the detector's scratch workspace,
+    // the reused output buffer of its findCycles calls, and the abort costs of the round
+    // being closed.
+    struct DetectionWorkspace
+    {
+        DeadlockDetector detector;
+        CycleSet cycles;
+        VictimCostTable costs;
+    };
+    // A zone round that times out closes on the coordinator thread, the central and tier
+    // rounds on the message processing thread. Each kind is serialized by its own mutex
+    // and searches in its own workspace.
+    DetectionWorkspace zoneDetection_;    // centralized and tier-0 rounds, aggregatedWfgMutex_
+    DetectionWorkspace centralDetection_; // centralReportsMutex_
+    DetectionWorkspace tierDetection_;    // tierAggregationsMutex_
+
+    // Snapshot counter stamped on every WFG this node reports (see WFGEdgeTag).
+    std::atomic<long long> wfgEpoch_;
+
+    // Time spent in cycle detection since the last load report, in microseconds.
+    std::atomic<long long> detectionTimeUs_;
+    // Cycles resolved since the last load report, and their total length.
+    std::atomic<long long> cyclesResolved_;
+    std::atomic<long long> cycleMembersResolved_;
+    // Phantom-cycle filters for the rounds aggregated in memberWfgSlots_ (central node in
+    // centralized mode, zone leaders in HAWK) and in centralReports_.
+    WFGValidator wfgValidator_;
+    WFGValidator centralWfgValidator_;
+    std::atomic<long long> staleAbortsIgnored_;
+
+    // Chooses deadlock victims on this node when it aggregates WFGs. Every kind of round
+    // consults it and its abort history, so it is guarded by victimSelectorMutex_.
+    VictimSelector victimSelector_;
+    std::mutex victimSelectorMutex_;
+    // Victims aborted by this node or reported by the zones below it, on every tier it leads.
+    VictimRegistry victimRegistry_;
+    std::atomic<long long> duplicateCyclesSkipped_; // cycles already broken by a registered victim
+    // Work thrown away by the deadlock aborts this node carried out as home node.
+    std::atomic<long long> victimAborts_;
+    std::atomic<long long> wastedStatements_;
+    std::atomic<long long> wastedLocks_;
+    std::atomic<long long> wastedTimeMs_;
+
     SafeQueue<long long> completedTransactionLatencies_;
     std::chrono::high_resolution_clock::time_point lastReportTime_;
 
-    std::atomic<long long> totalDeadlocksFromZones_;
-    std::atomic<long long> totalDeadlocksFromCentral_;
-
     std::chrono::high_resolution_clock::time_point lastTreeAdjustTime_;
-    long long prevTotalDeadlocksFromZones_ = 0;
-    long long prevTotalDeadlocksFromCentral_ = 0;
+    // Nodes a tree update did not reach; they get the whole tree with the next one.
+    std::unordered_set<NodeId> staleTreeNodes_;
 
 
 #ifdef TRANSACTION_TYPE_TPCC
@@ -108,49 +266,200 @@ private:
     void centralizedDetectLoop();
     void pathPushingDetectionLoop();
 
-    void checkAndResolveDeadlocks(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph);
-    void checkAndResolveDeadlocksForZone(NodeId zoneLeaderId, const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph);
-    TransactionId selectVictim(const std::vector<TransactionId> &cycle, const std::unordered_map<TransactionId, int> &transactionFrequencies);
+    // Resolves the cycles of a centralized round from the slots of the current round.
+    // aggregatedWfgMutex_ must be held.
+    void checkAndResolveDeadlocks();
+    // Resolves the cycles of this node's tier-0 zone from the member slots of the current
+    // round and reports its residual graph up the tree. Returns the number of cycles
+    // resolved. aggregatedWfgMutex_ must be held.
+    size_t checkAndResolveDeadlocksForZone();
+    // The transactions of roundWfgView_ that may be waited for from outside the zone: all
+    // but those whose home node is a member and reported every lock they hold inside it.
+    std::unordered_set<TransactionId> zoneEntryTransactions();
+    // Aborts a victim in each consistent cycle of workspace.cycles that no registered victim
+    // has broken yet and returns those cycles. victims, if given, receives the incarnations
+    // aborted.
+    std::vector<std::vector<TransactionId>> resolveZoneCycles(const DetectionWorkspace &workspace, WFGValidator &validator,
+                                                              std::unordered_set<Incarnation> *victims = nullptr);
+    // Builds the report of round roundId of the tier-`level` zone this node leads: its
+    // residual graph and the costs of its blocked transactions, with every cycle found and
+    // every victim aborted in its subtree.
+    NetworkMessage makeZoneReport(int level, long long roundId,
+                                  const std::unordered_map<TransactionId, std::vector<TransactionId>> &residual,
+                                  std::vector<WFGEdgeTag> edgeTags, std::vector<TransactionCost> costs,
+                                  std::vector<std::vector<TransactionId>> detectedCycles,
+                                  int deadlockCount, std::vector<ZoneReportStats> zoneStats, std::vector<Incarnation> victims);
+    // Sends msg to its receiver. The network keeps no stub to this node, so a message
+    // addressed here goes onto its own incoming queue and is handled like any other.
+    void sendToNode(const NetworkMessage &msg);
 
-    void handleWFGReport(NodeId reporterNodeId, const std::unordered_map<TransactionId, std::vector<TransactionId>> &wfgData);
+    // Builds this node's tagged local WFG as a WFG_REPORT to receiverId.
+    NetworkMessage makeLocalWFGReport(NodeId receiverId, long long roundId);
+    // On the central node, merges a WFG report; on every other node, a WFG_REPORT from the
+    // central node is a request and is answered with this node's tagged local WFG.
+    void handleWFGReport(NodeId reporterNodeId, long long roundId,
+                         const std::unordered_map<TransactionId, std::vector<TransactionId>> &wfgData,
+                         const std::vector<WFGEdgeTag> &edgeTags, const std::vector<TransactionCost> &transactionCosts);
+    // Starts a new WFG collection round expecting `expectedReports` reports and returns its id.
+    // A zone round also records the tree it was started under.
+    long long beginWFGRound(int expectedReports, std::shared_ptr<const DetectionZoneManager::Snapshot> tree = nullptr);
+    // Whether a report for roundId can join the current round; counts it as stale if not.
+    // aggregatedWfgMutex_ must be held.
+    bool acceptWFGReport(NodeId reporterNodeId, long long roundId);
+    // Whether a child leader's report, stamped with the child's own round roundId, is newer
+    // than the last one it sent to this tier; counts it as stale if not.
+    // tierAggregationsMutex_ must be held.
+    bool acceptWFGReport(TierAggregation &aggregation, NodeId childLeaderId, long long roundId);
+    // Counts and logs a report dropped for answering an old round.
+    void countStaleWFGReport(NodeId reporterNodeId, long long roundId);
+    // Resolves the cycles of the current round with the reports merged so far and ends it.
+    // aggregatedWfgMutex_ must be held.
+    void closeWFGRound();
+    // Waits until round roundId has closed, closing it with partial data once
+    // WFG_ROUND_TIMEOUT_MS has passed. Returns the cycles the round resolved.
+    size_t awaitWFGRound(long long roundId);
+    void noteZoneLeaderContact();
+    DeadlockDetectionMode detectionMode() const;
+    // Switches this node to `mode` if epoch is newer than the one it runs; MODE_ADAPTIVE only.
+    void applyDetectionMode(int mode, long long epoch);
+    // On the central node, makes `mode` the detector of the whole cluster under a new epoch.
+    void announceDetectionMode(DeadlockDetectionMode mode);
+    // Counts a resolved cycle of `length` transactions for the next load report.
+    void countResolvedCycle(size_t length);
+    // Switches the zone this node leads between WFG collection and probes after a round
+    // that resolved `cycles` cycles over `edges` WFG edges. aggregatedWfgMutex_ must be held.
+    void updateZoneStrategy(size_t cycles, size_t edges);
+    // Starts a zone probe, kept within zoneLeaderId's zone, for every local transaction
+    // blocked for ZONE_PROBE_BLOCKED_MS. Returns whether the zone should go back to WFG
+    // collection: too many to probe, or a probe overflowed since the last call.
+    bool launchZoneProbes(NodeId zoneLeaderId);
+    // Returns and forgets probeVictimsPending_.
+    std::vector<Incarnation> takeProbeVictims();
+    // On a zone member, takes over the zone if its leader has sent no detection request
+    // for as long as this node's place in the line of deputies allows, and tells the
+    // central node.
+    void watchZoneLeader(const std::shared_ptr<const DetectionZoneManager::Snapshot> &tree);
+    // On the central node, publishes a tree in which deputyId holds every seat of the
+    // stalled failedLeaderId, if treeVersion is still the current tree.
+    void handleZoneLeaderFailover(NodeId deputyId, NodeId failedLeaderId, long long treeVersion);
     // Handles a PAG request from another node.
     // In HAWK, this involves collecting and sending local cross-node WFDEdges.
     void handlePAGRequest(NodeId requesterNodeId);
-    // Handles a PAG response containing PAG edges from another node.
+    // Handles a PAG response containing the reporter's cross-node wait summary.
     // This is received by the central node to aggregate the global PAG.
-    void handlePAGResponse(NodeId reporterNodeId, const std::vector<WFDEdge> &pagEdges);
+    // Predicted pairs count PREDICTED_PAG_WEIGHT each, so zones can form before the first
+    // deadlock. The reporter's load is fed to the leader election.
+    void handlePAGResponse(NodeId reporterNodeId, const std::vector<PAGPairCount> &pairCounts,
+                           const std::vector<PAGPairCount> &predictedPairCounts, const NodeLoad &load);
+    // Counts the node pairs a newly blocked transaction depends on in pagSampler_.
+    void recordCrossNodeWait(TransactionId waitingTransId, const std::vector<TransactionId> &holdingTransIds);
+    // Load reported with every PAG response; resets the detection time counter.
+    NodeLoad collectNodeLoad();
+    // Runs findCycles into workspace.cycles and charges the time to this node's load.
+    void findCyclesTimed(DetectionWorkspace &workspace, const WFGView &view);
     void handleDeadlockResolution(const std::vector<TransactionId> &transIdsToAbort);
-    void handleAbortTransactionSignal(const std::vector<TransactionId> &transIdsToAbort);
+    // Aborts the listed transactions. When an incarnation is given for a transaction, it is
+    // only aborted if that is still its current lifetime on this node.
+    void handleAbortTransactionSignal(const std::vector<TransactionId> &transIdsToAbort,
+                                      const std::vector<Incarnation> &incarnations);
     // Handles the initiation of distributed detection (e.g., zone updates).
-    // This message is sent by the central node to all nodes to distribute the new detection zones.
-    // detectionZones: The new set of detection zones.
-    // detectionZoneLeaders: The leaders for each of the new zones.
-    void handleDistributedDetectionInit(const std::vector<std::vector<NodeId>>& detectionZones, const std::vector<NodeId>& detectionZoneLeaders);
+    // This message is sent by the central node to all nodes to distribute the new detection
+    // tree, in full or as a diff (see DetectionZoneManager::applyDetectionTree). Detection
+    // rounds of zones this node leads with unchanged members carry on across the update.
+    void handleDistributedDetectionInit(const NetworkMessage &msg);
+    // On the central node, sends a new detection tree to every node as a diff against the
+    // current one, or in full to nodes that missed an earlier update, then applies it here.
+    void publishDetectionTree(const std::vector<std::vector<NodeId>> &zones, const std::vector<NodeId> &leaders,
+                              const std::vector<int> &levels);
     // Handles a request from a zone leader to its members to collect and report WFG data.
     // centralNodeId: The ID of the zone leader making the request.
+    // roundId: The leader's round, echoed in the report.
     // zoneMembers: The list of nodes that are part of this zone.
-    void handleZoneDetectionRequest(NodeId centralNodeId, const std::vector<NodeId>& zoneMembers);
+    // treeVersion: The version of the tree the leader's zone comes from.
+    // strategy: The zone's ZoneDetectionStrategy; with probes, only the overflow flag is reported.
+    void handleZoneDetectionRequest(NodeId centralNodeId, long long roundId, long long treeVersion,
+                                    const std::vector<NodeId>& zoneMembers, int strategy);
     // Handles a WFG report from a zone member to its zone leader.
     // This report contains the local WFG (pruned for active transactions).
     // reporterNodeId: The ID of the node sending the report.
+    // roundId: The round the report answers; reports of any other round are dropped.
     // wfgDataPairs: The local WFG data in a serialized format.
-    void handleZoneWFGReport(NodeId reporterNodeId, const std::vector<std::pair<TransactionId, std::vector<TransactionId>>> &wfgDataPairs);
-    // Handles an aggregated WFG report sent by a zone leader to the central node.
-    // This message contains the WFG aggregated by the zone leader and any deadlocks detected within that zone.
+    // edgeTags: Provenance of the reported edges.
+    // transactionCosts: Abort cost of the reporter's blocked transactions, for victim selection.
+    // probeOverflow: A zone probe of the reporter overflowed.
+    // probeVictims: Incarnations the reporter's zone probes aborted since its last report.
+    void handleZoneWFGReport(NodeId reporterNodeId, long long roundId, WFGPairs wfgDataPairs,
+                             const std::vector<WFGEdgeTag> &edgeTags, std::vector<TransactionCost> transactionCosts,
+                             bool probeOverflow = false, const std::vector<Incarnation> &probeVictims = {});
+    // Handles an aggregated WFG report sent by a zone leader up the detection tree.
+    // This message contains the residual WFG of the leader's subtree and any deadlocks detected within it.
+    // It is aggregated by the leader of the next tier, or by the central node at the top.
     // zoneLeaderId: The ID of the zone leader sending the report.
-    // wfgDataPairs: The aggregated WFG data from the zone.
-    // detectedCycles: Deadlock cycles detected by the zone leader.
-    // reportedDeadlockCount: Number of deadlocks detected by the zone leader.
-    void handleCentralWFGReportFromZone(NodeId zoneLeaderId, const std::vector<std::pair<TransactionId, std::vector<TransactionId>>> &wfgDataPairs, const std::vector<std::vector<TransactionId>>& detectedCycles, int reportedDeadlockCount);
+    // roundId: The sender's own round the report closes.
+    // wfgDataPairs: The residual WFG data from the zone.
+    // detectedCycles: Deadlock cycles detected in the zone's subtree.
+    // reportedDeadlockCount: Number of deadlocks detected in the zone's subtree.
+    // edgeTags: Provenance of the forwarded edges, as originally reported by zone members.
+    // transactionCosts: Abort cost of the residual graph's blocked transactions, for victim selection.
+    // zoneLevel: Tier of the zone the report was aggregated in.
+    // victims: Incarnations aborted in the zone's subtree; registered before anything else.
+    void handleCentralWFGReportFromZone(NodeId zoneLeaderId, long long roundId, const std::vector<std::pair<TransactionId, std::vector<TransactionId>>> &wfgDataPairs, const std::vector<std::vector<TransactionId>>& detectedCycles, int reportedDeadlockCount,
+                                        const std::vector<WFGEdgeTag> &edgeTags,
+                                        const std::vector<TransactionCost> &transactionCosts, int zoneLevel,
+                                        const std::vector<ZoneReportStats> &zoneStats, const std::vector<Incarnation> &victims);
+    // The reports the central node waits for each round, as (tier, leader) pairs. Until the
+    // first tree every node leads a zone of its own.
+    std::vector<std::pair<int, NodeId>> expectedCentralReporters();
+    // Number of the expected leaders whose report for the open central round has arrived.
+    // centralReportsMutex_ must be held.
+    size_t countFreshCentralReports(const std::vector<std::pair<int, NodeId>> &expected);
+    // Closes the open central round and every open tier round WFG_ROUND_TIMEOUT_MS after its
+    // first report, with whatever reports arrived, so a stalled leader cannot keep one open.
+    void roundTimerLoop();
+    // Detects the cycles through several top-level zones in the fresh reports of the
+    // expected leaders, aborts their victims and ends the central round.
+    // centralReportsMutex_ must be held.
+    void closeCentralRound(const std::vector<std::pair<int, NodeId>> &expected);
+    // Stores a child leader's report in its slot in the round of the tier-`tier` zone this
+    // node leads, which has `expectedReports` members, and closes the round once all have
+    // reported into it.
+    void handleTierWFGReport(int tier, size_t expectedReports, NodeId childLeaderId, long long roundId,
+                             const std::vector<std::pair<TransactionId, std::vector<TransactionId>>> &wfgDataPairs,
+                             const std::vector<std::vector<TransactionId>> &detectedCycles, int reportedDeadlockCount,
+                             const std::vector<WFGEdgeTag> &edgeTags, const std::vector<TransactionCost> &transactionCosts,
+                             const std::vector<ZoneReportStats> &zoneStats, const std::vector<Incarnation> &victims);
+    // Detects the cycles through several child zones in the slots of the current round of
+    // the tier-`tier` zone, resolves them, ends the round and returns the report to forward.
+    // tierAggregationsMutex_ must be held.
+    NetworkMessage closeTierRound(int tier, TierAggregation &aggregation);
 
+    // Extends a probe by the transaction its last one waits for. A probe with a zone leader
+    // (centralNodeId) only travels between members of this node's zone and sets
+    // probeOverflowPending_ where it cannot go on.
     void handlePathPushingProbe(const NetworkMessage& msg);
     void initiatePathPushingProbes();
 
-    // Merges WFG data from a source into a target WFG.
-    // Used for aggregating WFG data in both centralized and HAWK modes.
-    void mergeWFG(std::unordered_map<TransactionId, std::vector<TransactionId>>& targetWfg,
-                  const std::vector<std::pair<TransactionId, std::vector<TransactionId>>>& sourceData);
+    // Stamps every edge of a freshly built local WFG with a new snapshot epoch and the
+    // incarnations of both transactions.
+    std::vector<WFGEdgeTag> tagLocalWFG(const std::unordered_map<TransactionId, std::vector<TransactionId>>& wfg);
+
+    // Picks the victim of cycle cycleIndex in workspace.cycles with the configured policy
+    // and the workspace's costs, queues it in batch and records it in the abort history and victimRegistry_. A cycle
+    // through a victim already queued in batch is resolved by that abort. Returns false,
+    // aborting nothing, if the cycle runs through a victim registered before this batch.
+    bool abortCycleVictim(const DetectionWorkspace &workspace, const WFGValidator &validator, size_t cycleIndex,
+                          AbortBatch &batch);
+
+    // Adds victimId to the message for its home node, unless it is already queued. The home
+    // node is taken from the incarnation when known, since TransactionIds are only unique
+    // per node. Returns false if the victim was already queued or has no known home node.
+    bool queueAbortSignal(AbortBatch &batch, TransactionId victimId, Incarnation incarnation);
+    // Sends one ABORT_TRANSACTION_SIGNAL per home node, all in parallel; victims homed on
+    // this node are aborted directly.
+    void flushAbortSignals(AbortBatch &batch);
 
+    // Copies a received WFG into a slot, reusing the slot's storage where it can.
+    static void assignWFGPairs(WFGPairs &target, const std::unordered_map<TransactionId, std::vector<TransactionId>> &source);
     // Converts WFG data from internal map format to a vector of pairs for network transmission.
     std::vector<std::pair<TransactionId, std::vector<TransactionId>>>
     convertWFGToMessageFormat(const std::unordered_map<TransactionId, std::vector<TransactionId>>& wfg);
@@ -0,0 +1,138 @@
+#include "LeaderElector.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+void LeaderElector::recordLoad(const NodeLoad &load)
+{
+    stalled_.erase(load.nodeId);
+    auto it = loads_.find(load.nodeId);
+    if (it == loads_.end())
+    {
+        loads_[load.nodeId] = {static_cast<double>(load.detectionTimeUs), static_cast<double>(load.activeTransactions),
+                               static_cast<double>(load.queueDepth)};
+        return;
+    }
+    SmoothedLoad &smoothed = it->second;
+    smoothed.detectionTimeUs += LEADER_LOAD_SMOOTHING * (load.detectionTimeUs - smoothed.detectionTimeUs);
+    smoothed.activeTransactions += LEADER_LOAD_SMOOTHING * (load.activeTransactions - smoothed.activeTransactions);
+    smoothed.queueDepth += LEADER_LOAD_SMOOTHING * (load.queueDepth - smoothed.queueDepth);
+}
+
+NodeId LeaderElector::electLeader(const WeightedPAG &weightedPag, const std::vector<NodeId> &zone, int level) const
+{
+    if (zone.size() < 2)
+    {
+        return zone.empty() ? 0 : zone.front();
+    }
+
+    std::unordered_map<NodeId, size_t> indexOf;
+    for (size_t i = 0; i < zone.size(); ++i)
+    {
+        indexOf[zone[i]] = i;
+    }
+    std::vector<double> centrality(zone.size(), 0.0);
+    for (NodeId member : zone)
+    {
+        auto out = weightedPag.find(member);
+        if (out == weightedPag.end())
+        {
+            continue;
+        }
+        for (const auto &neighbor : out->second)
+        {
+            auto to = indexOf.find(neighbor.first);
+            if (to != indexOf.end() && neighbor.first != member)
+            {
+                centrality[indexOf[member]] += neighbor.second;
+                centrality[to->second] += neighbor.second;
+            }
+        }
+    }
+
+    // Every component is scaled by its maximum within the zone, so the score only says
+    // how a member compares to the others.
+    SmoothedLoad peak;
+    double peakCentrality = 0.0;
+    std::vector<SmoothedLoad> load(zone.size());
+    for (size_t i = 0; i < zone.size(); ++i)
+    {
+        auto it = loads_.find(zone[i]);
+        if (it != loads_.end())
+        {
+            load[i] = it->second;
+        }
+        peak.detectionTimeUs = std::max(peak.detectionTimeUs, load[i].detectionTimeUs);
+        peak.activeTransactions = std::max(peak.activeTransactions, load[i].activeTransactions);
+        peak.queueDepth = std::max(peak.queueDepth, load[i].queueDepth);
+        peakCentrality = std::max(peakCentrality, centrality[i]);
+    }
+    auto share = [](double value, double max) { return max > 0.0 ? value / max : 0.0; };
+
+    NodeId best = 0;
+    double bestScore = -std::numeric_limits<double>::infinity();
+    NodeId incumbent = 0;
+    double incumbentScore = -std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < zone.size(); ++i)
+    {
+        if (stalled_.count(zone[i]))
+        {
+            continue;
+        }
+        double relativeLoad = (share(load[i].detectionTimeUs, peak.detectionTimeUs) +
+                               share(load[i].activeTransactions, peak.activeTransactions) +
+                               share(load[i].queueDepth, peak.queueDepth)) / 3.0;
+        double score = LEADER_CENTRALITY_WEIGHT * share(centrality[i], peakCentrality) - relativeLoad;
+        if (score > bestScore || (score == bestScore && zone[i] < best))
+        {
+            best = zone[i];
+            bestScore = score;
+        }
+        auto sitting = sittingLeaders_.find(zone[i]);
+        if (sitting != sittingLeaders_.end() && sitting->second >= level && score > incumbentScore)
+        {
+            incumbent = zone[i];
+            incumbentScore = score;
+        }
+    }
+    if (incumbent != 0 && bestScore < incumbentScore + LEADER_HYSTERESIS)
+    {
+        return incumbent;
+    }
+    // A zone of stalled nodes only still needs some leader.
+    return best != 0 ? best : zone.front();
+}
+
+void LeaderElector::electLeaders(const WeightedPAG &weightedPag, const std::vector<std::vector<NodeId>> &zones,
+                                 std::vector<NodeId> &leaders) const
+{
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        leaders[z] = electLeader(weightedPag, zones[z], 0);
+    }
+}
+
+void LeaderElector::markStalled(NodeId node)
+{
+    stalled_.insert(node);
+    sittingLeaders_.erase(node);
+}
+
+int LeaderElector::setSittingLeaders(const std::vector<NodeId> &leaders, const std::vector<int> &levels)
+{
+    std::unordered_map<NodeId, int> sitting;
+    int changed = 0;
+    for (size_t z = 0; z < leaders.size(); ++z)
+    {
+        int level = z < levels.size() ? levels[z] : 0;
+        auto previous = sittingLeaders_.find(leaders[z]);
+        if (previous == sittingLeaders_.end() || previous->second < level)
+        {
+            changed++;
+        }
+        sitting[leaders[z]] = std::max(sitting[leaders[z]], level);
+    }
+    sittingLeaders_ = std::move(sitting);
+    std::cout << "LeaderElector: " << changed << " of " << leaders.size() << " zones have a new leader.\n";
+    return changed;
+}
@@ -0,0 +1,54 @@
+#ifndef HAWK_LEADER_ELECTOR_H
+#define HAWK_LEADER_ELECTOR_H
+
+#include "commons.h"
+#include "PAGManager.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// LeaderElector picks the leader of each HAWK detection zone on the central node.
+// Nodes report their load with every PAG sample; the elector keeps a moving average per
+// node and scores each zone member by its PAG centrality within the zone (share of the
+// zone's dependency weight it takes part in) minus its load relative to the other members
+// (detection time, active transactions and queue depth, equally weighted). A sitting
+// leader keeps its zone unless a challenger beats its score by LEADER_HYSTERESIS, so
+// leadership does not flap between nodes of similar load.
+class LeaderElector
+{
+public:
+    LeaderElector() = default;
+
+    // Folds one load report into the node's moving average.
+    void recordLoad(const NodeLoad &load);
+
+    // Returns the leader of a zone of the given tier. Members without a load report count
+    // as idle. A member that led a zone of this tier or above before counts as sitting.
+    NodeId electLeader(const WeightedPAG &weightedPag, const std::vector<NodeId> &zone, int level) const;
+
+    // Replaces leaders[z] with the elected leader of every tier-0 zone.
+    void electLeaders(const WeightedPAG &weightedPag, const std::vector<std::vector<NodeId>> &zones,
+                      std::vector<NodeId> &leaders) const;
+
+    // Records the leaders of a new detection tree as the sitting ones and returns how many
+    // zones got a leader that did not lead on that tier before.
+    int setSittingLeaders(const std::vector<NodeId> &leaders, const std::vector<int> &levels);
+
+    // Keeps a leader its zone's deputy had to replace out of every election until the
+    // node reports its load again.
+    void markStalled(NodeId node);
+
+private:
+    struct SmoothedLoad
+    {
+        double detectionTimeUs = 0.0;
+        double activeTransactions = 0.0;
+        double queueDepth = 0.0;
+    };
+
+    std::unordered_map<NodeId, SmoothedLoad> loads_;
+    std::unordered_map<NodeId, int> sittingLeaders_; // leader -> highest tier it leads
+    std::unordered_set<NodeId> stalled_;
+};
+
+#endif // HAWK_LEADER_ELECTOR_H
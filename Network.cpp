@@ -37,6 +37,59 @@ void Network::convertWFGToProto(const std::unordered_map<TransactionId, std::vec
     }
 }
 
+void Network::convertEdgeTagsToProto(const std::vector<WFGEdgeTag>& internal_tags,
+                                    hawk::NetworkMessage::WFGData* proto_wfg_data) {
+    for (const auto& tag : internal_tags) {
+        hawk::WFGEdgeTag* proto_tag = proto_wfg_data->add_edge_tags();
+        proto_tag->set_waiting_trans_id(tag.waitingTransId);
+        proto_tag->set_holding_trans_id(tag.holdingTransId);
+        proto_tag->set_reporter_node_id(tag.reporterNodeId);
+        proto_tag->set_epoch(tag.epoch);
+        proto_tag->set_waiting_incarnation(tag.waitingIncarnation);
+        proto_tag->set_holding_incarnation(tag.holdingIncarnation);
+    }
+}
+
+std::vector<WFGEdgeTag> Network::convertProtoEdgeTagsToInternal(const hawk::NetworkMessage::WFGData& proto_wfg_data) {
+    std::vector<WFGEdgeTag> internal_tags;
+    internal_tags.reserve(proto_wfg_data.edge_tags_size());
+    for (const auto& proto_tag : proto_wfg_data.edge_tags()) {
+        internal_tags.push_back({proto_tag.waiting_trans_id(), proto_tag.holding_trans_id(),
+                                 proto_tag.reporter_node_id(), proto_tag.epoch(),
+                                 proto_tag.waiting_incarnation(), proto_tag.holding_incarnation()});
+    }
+    return internal_tags;
+}
+
+void Network::convertTransactionCostsToProto(const std::vector<TransactionCost>& internal_costs,
+                                            google::protobuf::RepeatedPtrField<hawk::TransactionCost>* proto_costs) {
+    for (const auto& cost : internal_costs) {
+        hawk::TransactionCost* proto_cost = proto_costs->Add();
+        proto_cost->set_trans_id(cost.transId);
+        proto_cost->set_incarnation(cost.incarnation);
+        proto_cost->set_age_ms(cost.ageMs);
+        proto_cost->set_statements_done(cost.statementsDone);
+        proto_cost->set_statements_total(cost.statementsTotal);
+        proto_cost->set_locks_held(cost.locksHeld);
+        for (NodeId node : cost.lockNodes) {
+            proto_cost->add_lock_nodes(node);
+        }
+    }
+}
+
+std::vector<TransactionCost>
+Network::convertProtoTransactionCostsToInternal(const google::protobuf::RepeatedPtrField<hawk::TransactionCost>& proto_costs) {
+    std::vector<TransactionCost> internal_costs;
+    internal_costs.reserve(proto_costs.size());
+    for (const auto& proto_cost : proto_costs) {
+        internal_costs.push_back({proto_cost.trans_id(), proto_cost.incarnation(), proto_cost.age_ms(),
+                                  proto_cost.statements_done(), proto_cost.statements_total(),
+                                  proto_cost.locks_held(),
+                                  std::vector<NodeId>(proto_cost.lock_nodes().begin(), proto_cost.lock_nodes().end())});
+    }
+    return internal_costs;
+}
+
 std::unordered_map<TransactionId, std::vector<TransactionId>>
 Network::convertProtoWFGToInternal(const hawk::NetworkMessage::WFGData& proto_wfg_data) {
     std::unordered_map<TransactionId, std::vector<TransactionId>> internal_wfg_data;
@@ -52,6 +105,7 @@ Network::convertProtoWFGToInternal(const hawk::NetworkMessage::WFGData& proto_wf
 
 void Network::convertDetectionZonesToProto(const std::vector<std::vector<NodeId>>& internal_zones,
                                           const std::vector<NodeId>& internal_leaders,
+                                          const std::vector<int>& internal_levels,
                                           hawk::NetworkMessage::DetectionZoneInitData* proto_data) {
     for (const auto& zone : internal_zones) {
         hawk::NetworkMessage::DetectionZoneInitData::NodeList* proto_node_list = proto_data->add_detection_zones();
@@ -62,13 +116,18 @@ void Network::convertDetectionZonesToProto(const std::vector<std::vector<NodeId>
     for (NodeId leader : internal_leaders) {
         proto_data->add_detection_zone_leaders(leader);
     }
+    for (int level : internal_levels) {
+        proto_data->add_detection_zone_levels(level);
+    }
 }
 
 void Network::convertProtoDetectionZonesToInternal(const hawk::NetworkMessage::DetectionZoneInitData& proto_data,
                                                   std::vector<std::vector<NodeId>>& internal_zones,
-                                                  std::vector<NodeId>& internal_leaders) {
+                                                  std::vector<NodeId>& internal_leaders,
+                                                  std::vector<int>& internal_levels) {
     internal_zones.clear();
     internal_leaders.clear();
+    internal_levels.clear();
     for (const auto& proto_node_list : proto_data.detection_zones()) {
         std::vector<NodeId> zone;
         for (NodeId nid : proto_node_list.nodes()) {
@@ -79,6 +138,9 @@ void Network::convertProtoDetectionZonesToInternal(const hawk::NetworkMessage::D
     for (NodeId leader : proto_data.detection_zone_leaders()) {
         internal_leaders.push_back(leader);
     }
+    for (int level : proto_data.detection_zone_levels()) {
+        internal_levels.push_back(level);
+    }
 }
 
 void Network::convertCyclesToProto(const std::vector<std::vector<TransactionId>>& internal_cycles,
@@ -106,6 +168,10 @@ Network::convertProtoCyclesToInternal(const hawk::NetworkMessage::DeadlockReport
 void Network::convertToProtoMessage(const NetworkMessage& internal_msg, hawk::NetworkMessage* proto_msg) {
     proto_msg->set_sender_id(internal_msg.senderId);
     proto_msg->set_receiver_id(internal_msg.receiverId);
+    proto_msg->set_round_id(internal_msg.roundId);
+    proto_msg->set_tree_version(internal_msg.treeVersion);
+    proto_msg->set_detection_mode(internal_msg.detectionMode);
+    proto_msg->set_mode_epoch(internal_msg.modeEpoch);
 
     switch (internal_msg.type) {
         case NetworkMessageType::LOCK_REQUEST: {
@@ -150,6 +216,12 @@ void Network::convertToProtoMessage(const NetworkMessage& internal_msg, hawk::Ne
                     }
                 }
             }
+            Network::convertEdgeTagsToProto(internal_msg.wfgEdgeTags, data);
+            Network::convertTransactionCostsToProto(internal_msg.transactionCosts, data->mutable_transaction_costs());
+            data->set_probe_overflow(internal_msg.probeOverflow);
+            for (Incarnation incarnation : internal_msg.victimIncarnations) {
+                data->add_victim_incarnations(incarnation);
+            }
             break;
         }
         case NetworkMessageType::DEADLOCK_RESOLUTION:
@@ -159,24 +231,47 @@ void Network::convertToProtoMessage(const NetworkMessage& internal_msg, hawk::Ne
             for (TransactionId tid : internal_msg.deadlockedTransactions) {
                 data->add_deadlocked_transactions(tid);
             }
+            for (Incarnation incarnation : internal_msg.deadlockedIncarnations) {
+                data->add_incarnations(incarnation);
+            }
             break;
         }
         case NetworkMessageType::PAG_RESPONSE: {
             proto_msg->set_type(hawk::NetworkMessageType::PAG_RESPONSE);
             hawk::NetworkMessage::PagData* data = proto_msg->mutable_pag_data();
-            for (const auto& edge : internal_msg.pagEdges) {
-                hawk::WFDEdge* proto_edge = data->add_pag_edges();
-                proto_edge->set_waiting_trans_id(edge.waitingTransId);
-                proto_edge->set_holding_trans_id(edge.holdingTransId);
-                proto_edge->set_waiting_node_id(edge.waitingNodeId);
-                proto_edge->set_holding_node_id(edge.holdingNodeId);
+            for (const auto& pair : internal_msg.pagPairCounts) {
+                hawk::PagPairCount* proto_pair = data->add_pair_counts();
+                proto_pair->set_waiting_node_id(pair.waitingNodeId);
+                proto_pair->set_holding_node_id(pair.holdingNodeId);
+                proto_pair->set_count(pair.count);
+            }
+            for (const auto& pair : internal_msg.predictedPagPairCounts) {
+                hawk::PagPairCount* proto_pair = data->add_predicted_pair_counts();
+                proto_pair->set_waiting_node_id(pair.waitingNodeId);
+                proto_pair->set_holding_node_id(pair.holdingNodeId);
+                proto_pair->set_count(pair.count);
             }
+            data->mutable_node_load()->set_node_id(internal_msg.nodeLoad.nodeId);
+            data->mutable_node_load()->set_detection_time_us(internal_msg.nodeLoad.detectionTimeUs);
+            data->mutable_node_load()->set_active_transactions(internal_msg.nodeLoad.activeTransactions);
+            data->mutable_node_load()->set_queue_depth(internal_msg.nodeLoad.queueDepth);
+            data->mutable_node_load()->set_cycles_resolved(internal_msg.nodeLoad.cyclesResolved);
+            data->mutable_node_load()->set_cycle_members(internal_msg.nodeLoad.cycleMembers);
             break;
         }
         case NetworkMessageType::DISTRIBUTED_DETECTION_INIT: {
             proto_msg->set_type(hawk::NetworkMessageType::DISTRIBUTED_DETECTION_INIT);
             hawk::NetworkMessage::DetectionZoneInitData* data = proto_msg->mutable_detection_zone_init_data();
-            Network::convertDetectionZonesToProto(internal_msg.detectionZones, internal_msg.detectionZoneLeaders, data);
+            Network::convertDetectionZonesToProto(internal_msg.detectionZones, internal_msg.detectionZoneLeaders,
+                                                  internal_msg.detectionZoneLevels, data);
+            data->set_tree_version(internal_msg.treeVersion);
+            data->set_base_tree_version(internal_msg.baseTreeVersion);
+            for (NodeId leader : internal_msg.removedZoneLeaders) {
+                data->add_removed_zone_leaders(leader);
+            }
+            for (int level : internal_msg.removedZoneLevels) {
+                data->add_removed_zone_levels(level);
+            }
             break;
         }
         case NetworkMessageType::CLIENT_RESOLVE_DEADLOCK_REQUEST: {
@@ -198,6 +293,8 @@ void Network::convertToProtoMessage(const NetworkMessage& internal_msg, hawk::Ne
             for (TransactionId tid : internal_msg.path) {
                 data->add_path(tid);
             }
+            data->set_zone_leader_id(internal_msg.centralNodeId);
+            Network::convertTransactionCostsToProto(internal_msg.transactionCosts, data->mutable_path_costs());
             break;
         }
         case NetworkMessageType::ZONE_DETECTION_REQUEST: {
@@ -207,6 +304,7 @@ void Network::convertToProtoMessage(const NetworkMessage& internal_msg, hawk::Ne
             for (NodeId nid : internal_msg.zoneMembers) {
                 data->add_zone_members(nid);
             }
+            data->set_strategy(internal_msg.zoneStrategy);
             break;
         }
         case NetworkMessageType::CENTRAL_WFG_REPORT_FROM_ZONE: {
@@ -225,9 +323,34 @@ void Network::convertToProtoMessage(const NetworkMessage& internal_msg, hawk::Ne
                     proto_cycle_list->add_transactions(tid);
                 }
             }
+            Network::convertEdgeTagsToProto(internal_msg.wfgEdgeTags, data->mutable_wfg_data());
+            Network::convertTransactionCostsToProto(internal_msg.transactionCosts, data->mutable_wfg_data()->mutable_transaction_costs());
             data->set_reported_deadlock_count(internal_msg.deadlockCount);
+            data->set_zone_level(internal_msg.zoneLevel);
+            for (const auto& stats : internal_msg.zoneStats) {
+                hawk::ZoneReportStats* proto_stats = data->add_zone_stats();
+                proto_stats->set_leader_id(stats.leaderId);
+                proto_stats->set_level(stats.level);
+                proto_stats->set_cycles_detected(stats.cyclesDetected);
+                proto_stats->set_detection_time_us(stats.detectionTimeUs);
+                proto_stats->set_report_edges(stats.reportEdges);
+                proto_stats->set_residual_edges(stats.residualEdges);
+            }
+            for (Incarnation incarnation : internal_msg.victimIncarnations) {
+                data->add_victim_incarnations(incarnation);
+            }
             break;
         }
+        case NetworkMessageType::ZONE_LEADER_FAILOVER: {
+            proto_msg->set_type(hawk::NetworkMessageType::ZONE_LEADER_FAILOVER);
+            proto_msg->mutable_zone_leader_failover_data()->set_failed_leader_id(internal_msg.failedLeaderId);
+            break;
+        }
+        case NetworkMessageType::PAG_REQUEST:
+        case NetworkMessageType::DETECTION_MODE_CHANGE:
+            // No payload; the detection mode and its epoch are top-level fields.
+            proto_msg->set_type(static_cast<hawk::NetworkMessageType>(internal_msg.type));
+            break;
         case NetworkMessageType::UNKNOWN:
             proto_msg->set_type(hawk::NetworkMessageType::UNKNOWN);
             break;
@@ -239,6 +362,10 @@ NetworkMessage Network::convertFromProtoMessage(const hawk::NetworkMessage& prot
     internal_msg.type = static_cast<NetworkMessageType>(proto_msg.type());
     internal_msg.senderId = proto_msg.sender_id();
     internal_msg.receiverId = proto_msg.receiver_id();
+    internal_msg.roundId = proto_msg.round_id();
+    internal_msg.treeVersion = proto_msg.tree_version();
+    internal_msg.detectionMode = proto_msg.detection_mode();
+    internal_msg.modeEpoch = proto_msg.mode_epoch();
 
     switch (proto_msg.type()) {
         case hawk::NetworkMessageType::LOCK_REQUEST: {
@@ -278,6 +405,11 @@ NetworkMessage Network::convertFromProtoMessage(const hawk::NetworkMessage& prot
                     internal_msg.wfgDataPairs.push_back({proto_pair.key(), values});
                 }
             }
+            internal_msg.wfgEdgeTags = Network::convertProtoEdgeTagsToInternal(proto_msg.wfg_data());
+            internal_msg.transactionCosts = Network::convertProtoTransactionCostsToInternal(proto_msg.wfg_data().transaction_costs());
+            internal_msg.probeOverflow = proto_msg.wfg_data().probe_overflow();
+            internal_msg.victimIncarnations.assign(proto_msg.wfg_data().victim_incarnations().begin(),
+                                                   proto_msg.wfg_data().victim_incarnations().end());
             break;
         }
         case hawk::NetworkMessageType::DEADLOCK_RESOLUTION:
@@ -286,23 +418,35 @@ NetworkMessage Network::convertFromProtoMessage(const hawk::NetworkMessage& prot
             for (TransactionId tid : data.deadlocked_transactions()) {
                 internal_msg.deadlockedTransactions.push_back(tid);
             }
+            for (Incarnation incarnation : data.incarnations()) {
+                internal_msg.deadlockedIncarnations.push_back(incarnation);
+            }
             break;
         }
         case hawk::NetworkMessageType::PAG_RESPONSE: {
             const auto& data = proto_msg.pag_data();
-            for (const auto& proto_edge : data.pag_edges()) {
-                WFDEdge edge;
-                edge.waitingTransId = proto_edge.waiting_trans_id();
-                edge.holdingTransId = proto_edge.holding_trans_id();
-                edge.waitingNodeId = proto_edge.waiting_node_id();
-                edge.holdingNodeId = proto_edge.holding_node_id();
-                internal_msg.pagEdges.push_back(edge);
+            for (const auto& proto_pair : data.pair_counts()) {
+                internal_msg.pagPairCounts.push_back({proto_pair.waiting_node_id(), proto_pair.holding_node_id(), proto_pair.count()});
+            }
+            for (const auto& proto_pair : data.predicted_pair_counts()) {
+                internal_msg.predictedPagPairCounts.push_back({proto_pair.waiting_node_id(), proto_pair.holding_node_id(), proto_pair.count()});
             }
+            internal_msg.nodeLoad.nodeId = data.node_load().node_id();
+            internal_msg.nodeLoad.detectionTimeUs = data.node_load().detection_time_us();
+            internal_msg.nodeLoad.activeTransactions = data.node_load().active_transactions();
+            internal_msg.nodeLoad.queueDepth = data.node_load().queue_depth();
+            internal_msg.nodeLoad.cyclesResolved = data.node_load().cycles_resolved();
+            internal_msg.nodeLoad.cycleMembers = data.node_load().cycle_members();
             break;
         }
         case hawk::NetworkMessageType::DISTRIBUTED_DETECTION_INIT: {
             const auto& data = proto_msg.detection_zone_init_data();
-            Network::convertProtoDetectionZonesToInternal(data, internal_msg.detectionZones, internal_msg.detectionZoneLeaders); 
+            Network::convertProtoDetectionZonesToInternal(data, internal_msg.detectionZones, internal_msg.detectionZoneLeaders,
+                                                          internal_msg.detectionZoneLevels);
+            internal_msg.treeVersion = data.tree_version();
+            internal_msg.baseTreeVersion = data.base_tree_version();
+            internal_msg.removedZoneLeaders.assign(data.removed_zone_leaders().begin(), data.removed_zone_leaders().end());
+            internal_msg.removedZoneLevels.assign(data.removed_zone_levels().begin(), data.removed_zone_levels().end());
             break;
         }
         case hawk::NetworkMessageType::CLIENT_RESOLVE_DEADLOCK_REQUEST: {
@@ -321,6 +465,8 @@ NetworkMessage Network::convertFromProtoMessage(const hawk::NetworkMessage& prot
             for (TransactionId tid : data.path()) {
                 internal_msg.path.push_back(tid);
             }
+            internal_msg.centralNodeId = data.zone_leader_id();
+            internal_msg.transactionCosts = Network::convertProtoTransactionCostsToInternal(data.path_costs());
             break;
         }
         case hawk::NetworkMessageType::ZONE_DETECTION_REQUEST: {
@@ -329,6 +475,7 @@ NetworkMessage Network::convertFromProtoMessage(const hawk::NetworkMessage& prot
             for (NodeId nid : data.zone_members()) {
                 internal_msg.zoneMembers.push_back(nid);
             }
+            internal_msg.zoneStrategy = data.strategy();
             break;
         }
         case hawk::NetworkMessageType::CENTRAL_WFG_REPORT_FROM_ZONE: {
@@ -350,9 +497,26 @@ NetworkMessage Network::convertFromProtoMessage(const hawk::NetworkMessage& prot
                 }
                 internal_msg.detectedCycles.push_back(cycle);
             }
+            internal_msg.wfgEdgeTags = Network::convertProtoEdgeTagsToInternal(data.wfg_data());
+            internal_msg.transactionCosts = Network::convertProtoTransactionCostsToInternal(data.wfg_data().transaction_costs());
             internal_msg.deadlockCount = data.reported_deadlock_count();
+            internal_msg.zoneLevel = data.zone_level();
+            for (const auto& proto_stats : data.zone_stats()) {
+                internal_msg.zoneStats.push_back({proto_stats.leader_id(), proto_stats.level(), proto_stats.cycles_detected(),
+                                                  proto_stats.detection_time_us(), proto_stats.report_edges(),
+                                                  proto_stats.residual_edges()});
+            }
+            internal_msg.victimIncarnations.assign(data.victim_incarnations().begin(), data.victim_incarnations().end());
             break;
         }
+        case hawk::NetworkMessageType::ZONE_LEADER_FAILOVER: {
+            internal_msg.failedLeaderId = proto_msg.zone_leader_failover_data().failed_leader_id();
+            break;
+        }
+        case hawk::NetworkMessageType::PAG_REQUEST:
+        case hawk::NetworkMessageType::DETECTION_MODE_CHANGE:
+            // No payload; the detection mode and its epoch were read from the top-level fields.
+            break;
         case hawk::NetworkMessageType::UNKNOWN:
             
             std::cerr << "Network: Received UNKNOWN message type. Sender: " << proto_msg.sender_id() << ", Receiver: " << proto_msg.receiver_id() << std::endl;
@@ -398,6 +562,8 @@ GRPC_RPC_HANDLER(SendDistributedDetectionInit)
 GRPC_RPC_HANDLER(SendZoneDetectionRequest)
 GRPC_RPC_HANDLER(SendZoneWFGReport)
 GRPC_RPC_HANDLER(SendCentralWFGReportFromZone)
+GRPC_RPC_HANDLER(SendZoneLeaderFailover)
+GRPC_RPC_HANDLER(SendDetectionModeChange)
 GRPC_RPC_HANDLER(SendPathPushingProbe)
 GRPC_RPC_HANDLER(SendClientCollectWFGRequest)
 GRPC_RPC_HANDLER(SendClientPrintDeadlockRequest)
@@ -513,7 +679,27 @@ bool Network::connectToServer(NodeId serverNodeId) {
 
 void Network::sendMessage(const NetworkMessage &msg) {
     std::unique_lock<std::mutex> lock(sendMutex_); 
+    deliverMessage(msg);
+}
+
+void Network::sendMessagesInParallel(const std::vector<NetworkMessage> &msgs) {
+    if (msgs.size() == 1) {
+        sendMessage(msgs[0]);
+        return;
+    }
+    // Stubs are thread-safe, so each RPC runs on its own task and the batch completes in
+    // about one round trip instead of one per message.
+    std::vector<std::future<void>> pending;
+    pending.reserve(msgs.size());
+    for (const NetworkMessage &msg : msgs) {
+        pending.push_back(std::async(std::launch::async, [this, &msg]() { deliverMessage(msg); }));
+    }
+    for (auto &future : pending) {
+        future.wait();
+    }
+}
 
+void Network::deliverMessage(const NetworkMessage &msg) {
     NodeId targetNodeId = msg.receiverId;
     if (targetNodeId == 0 && !isClient_) { 
                                          
@@ -598,6 +784,12 @@ void Network::sendMessage(const NetworkMessage &msg) {
             case hawk::NetworkMessageType::CENTRAL_WFG_REPORT_FROM_ZONE:
                 status = stub->SendCentralWFGReportFromZone(&context, proto_msg, &response);
                 break;
+            case hawk::NetworkMessageType::ZONE_LEADER_FAILOVER:
+                status = stub->SendZoneLeaderFailover(&context, proto_msg, &response);
+                break;
+            case hawk::NetworkMessageType::DETECTION_MODE_CHANGE:
+                status = stub->SendDetectionModeChange(&context, proto_msg, &response);
+                break;
             case hawk::NetworkMessageType::PATH_PUSHING_PROBE:
                 status = stub->SendPathPushingProbe(&context, proto_msg, &response);
                 break;
@@ -618,26 +810,23 @@ void Network::sendMessage(const NetworkMessage &msg) {
     }
 }
 
-void Network::broadcastTreeAdjustment(NodeId senderId, const std::vector<std::vector<NodeId>> &detectionZones, const std::vector<NodeId>& detectionZoneLeaders) {
-    NetworkMessage msg;
+std::vector<NodeId> Network::broadcastTreeAdjustment(const NetworkMessage &treeMsg, const std::unordered_set<NodeId> &excluded) {
+    NetworkMessage msg = treeMsg;
     msg.type = NetworkMessageType::DISTRIBUTED_DETECTION_INIT;
-    msg.senderId = senderId;
     msg.receiverId = 0; 
 
-    msg.detectionZones = detectionZones;
-    msg.detectionZoneLeaders = detectionZoneLeaders;
-
     hawk::NetworkMessage proto_msg;
     Network::convertToProtoMessage(msg, &proto_msg); 
 
-    
+    std::vector<NodeId> unreached;
     for (int i = 1; i <= numNodes_; ++i) {
-        if (i == nodeId_) {
+        if (i == nodeId_ || excluded.count(i)) {
             continue; 
         }
         auto it = peerStubs_.find(i);
         if (it == peerStubs_.end() || !it->second) {
             std::cerr << "Node " << nodeId_ << ": No gRPC stub found for broadcast to node " << i << std::endl;
+            unreached.push_back(i);
             continue;
         }
         grpc::ClientContext context;
@@ -646,9 +835,12 @@ void Network::broadcastTreeAdjustment(NodeId senderId, const std::vector<std::ve
         if (!status.ok()) {
             std::cerr << "Node " << nodeId_ << ": Broadcast to node " << i << " failed: "
                       << status.error_code() << " - " << status.error_message() << std::endl;
+            unreached.push_back(i);
         }
     }
-    std::cout << "Node " << nodeId_ << ": Broadcasted Tree Adjustment (Detection Init) message." << std::endl;
+    std::cout << "Node " << nodeId_ << ": Broadcasted Tree Adjustment (Detection Init) message, version " << msg.treeVersion
+              << (msg.baseTreeVersion > 0 ? " as a diff." : ".") << std::endl;
+    return unreached;
 }
 
 
@@ -10,6 +10,8 @@
 #include <mutex>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include <future>
 
 #include <grpcpp/grpcpp.h>
 #include "generated_protos/network.grpc.pb.h"
@@ -46,6 +48,10 @@ public:
                                        hawk::NetworkMessage* response) override;
         grpc::Status SendCentralWFGReportFromZone(grpc::ServerContext* context, const hawk::NetworkMessage* request,
                                                   hawk::NetworkMessage* response) override;
+        grpc::Status SendZoneLeaderFailover(grpc::ServerContext* context, const hawk::NetworkMessage* request,
+                                            hawk::NetworkMessage* response) override;
+        grpc::Status SendDetectionModeChange(grpc::ServerContext* context, const hawk::NetworkMessage* request,
+                                             hawk::NetworkMessage* response) override;
         grpc::Status SendPathPushingProbe(grpc::ServerContext* context, const hawk::NetworkMessage* request,
                                           hawk::NetworkMessage* response) override;
         grpc::Status SendClientCollectWFGRequest(grpc::ServerContext* context, const hawk::NetworkMessage* request,
@@ -69,7 +75,12 @@ public:
     void connectToPeers();
     bool connectToServer(NodeId serverNodeId);
     void sendMessage(const NetworkMessage &msg);
-    void broadcastTreeAdjustment(NodeId senderId, const std::vector<std::vector<NodeId>> &detectionZones, const std::vector<NodeId>& detectionZoneLeaders = {});
+    // Sends every message concurrently and returns once all RPCs have completed.
+    // Messages must not be addressed to this node or broadcast.
+    void sendMessagesInParallel(const std::vector<NetworkMessage> &msgs);
+    // Sends treeMsg as a DISTRIBUTED_DETECTION_INIT to every other node outside `excluded`
+    // and returns the nodes it did not reach.
+    std::vector<NodeId> broadcastTreeAdjustment(const NetworkMessage &treeMsg, const std::unordered_set<NodeId> &excluded = {});
     std::shared_ptr<SafeQueue<NetworkMessage>> getIncomingQueue() { return incomingQueue_; }
 
     void sendCollectCommand(NodeId targetNodeId);
@@ -92,6 +103,9 @@ private:
     std::shared_ptr<SafeQueue<NetworkMessage>> incomingQueue_;
     std::mutex sendMutex_;
 
+    // Performs the RPC for msg; callers are responsible for any serialization.
+    void deliverMessage(const NetworkMessage &msg);
+
     static void convertToProtoMessage(const NetworkMessage& internal_msg, hawk::NetworkMessage* proto_msg);
     static NetworkMessage convertFromProtoMessage(const hawk::NetworkMessage& proto_msg);
 
@@ -100,12 +114,24 @@ private:
     static std::unordered_map<TransactionId, std::vector<TransactionId>>
     convertProtoWFGToInternal(const hawk::NetworkMessage::WFGData& proto_wfg_data);
 
+    static void convertEdgeTagsToProto(const std::vector<WFGEdgeTag>& internal_tags,
+                                       hawk::NetworkMessage::WFGData* proto_wfg_data);
+    static std::vector<WFGEdgeTag> convertProtoEdgeTagsToInternal(const hawk::NetworkMessage::WFGData& proto_wfg_data);
+
+    // Costs travel with WFG reports and with path-pushing probes.
+    static void convertTransactionCostsToProto(const std::vector<TransactionCost>& internal_costs,
+                                               google::protobuf::RepeatedPtrField<hawk::TransactionCost>* proto_costs);
+    static std::vector<TransactionCost>
+    convertProtoTransactionCostsToInternal(const google::protobuf::RepeatedPtrField<hawk::TransactionCost>& proto_costs);
+
     static void convertDetectionZonesToProto(const std::vector<std::vector<NodeId>>& internal_zones,
                                              const std::vector<NodeId>& internal_leaders,
+                                             const std::vector<int>& internal_levels,
                                              hawk::NetworkMessage::DetectionZoneInitData* proto_data);
     static void convertProtoDetectionZonesToInternal(const hawk::NetworkMessage::DetectionZoneInitData& proto_data,
                                                      std::vector<std::vector<NodeId>>& internal_zones,
-                                                     std::vector<NodeId>& internal_leaders);
+                                                     std::vector<NodeId>& internal_leaders,
+                                                     std::vector<int>& internal_levels);
 
     static void convertCyclesToProto(const std::vector<std::vector<TransactionId>>& internal_cycles,
                                      hawk::NetworkMessage::DeadlockReportToClientData* proto_report);
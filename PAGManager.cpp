@@ -1,54 +1,148 @@
 #include "PAGManager.h"
 #include <algorithm>
-#include <set>
 #include <iostream>
-#include <unordered_set>
-// Helper DFS function for finding Strongly Connected Components (SCCs) using Tarjan's algorithm.
-// This is used internally by `greedySCCcut` to analyze the PAG and identify potential detection zones
-// in the HAWK scheme. It marks nodes with discovery times and low-link values to detect SCCs.
-void PAGManager::findSCCsDFS(NodeId u,
-                             const PAG &graph,
-                             std::unordered_map<NodeId, int> &disc,
-                             std::unordered_map<NodeId, int> &low,
-                             std::stack<NodeId> &st,
-                             std::unordered_map<NodeId, bool> &onStack,
-                             std::vector<std::vector<NodeId>> &sccs,
-                             int &time)
+NodeId PAGManager::flattenPAG(const PAG &graph)
 {
-    disc[u] = low[u] = ++time;
-    st.push(u);
-    onStack[u] = true;
+    // Chasing the map's nodes and adjacency vectors costs more than the search itself, so
+    // the map is walked exactly once.
+    NodeId maxNode = 0;
+    ws_.keys.clear();
+    ws_.edgeFrom.clear();
+    ws_.targets.clear();
+    for (const auto &pair : graph)
+    {
+        ws_.keys.push_back(pair.first);
+        maxNode = std::max(maxNode, pair.first);
+        for (NodeId v : pair.second)
+        {
+            ws_.edgeFrom.push_back(pair.first);
+            ws_.targets.push_back(v);
+            maxNode = std::max(maxNode, v);
+        }
+    }
+    return maxNode;
+}
 
-    if (graph.count(u))
+NodeId PAGManager::flattenPAG(const WeightedPAG &weightedPag, double minEdgeWeight)
+{
+    NodeId maxNode = 0;
+    ws_.keys.clear();
+    ws_.edgeFrom.clear();
+    ws_.targets.clear();
+    for (const auto &pair : weightedPag)
     {
-        for (NodeId v : graph.at(u))
+        size_t before = ws_.targets.size();
+        for (const auto &neighbor : pair.second)
         {
-            if (disc.find(v) == disc.end())
+            if (neighbor.second >= minEdgeWeight)
             {
-                findSCCsDFS(v, graph, disc, low, st, onStack, sccs, time);
-                low[u] = std::min(low[u], low[v]);
-            }
-            else if (onStack[v])
-            {
-                low[u] = std::min(low[u], disc[v]);
+                ws_.edgeFrom.push_back(pair.first);
+                ws_.targets.push_back(neighbor.first);
+                maxNode = std::max(maxNode, neighbor.first);
             }
         }
+        if (ws_.targets.size() > before)
+        {
+            ws_.keys.push_back(pair.first);
+            maxNode = std::max(maxNode, pair.first);
+        }
     }
+    return maxNode;
+}
 
-    if (low[u] == disc[u])
+// Finds the Strongly Connected Components (SCCs) of the PAG with Tarjan's algorithm.
+// This is used internally by `greedySCCcut` to analyze the PAG and identify potential detection zones
+// in the HAWK scheme.
+void PAGManager::findSCCs(NodeId maxNode)
+{
+    const size_t n = static_cast<size_t>(maxNode) + 1;
+
+    // Counting sort of the edges by source gives the CSR rows.
+    ws_.rowStart.assign(n + 1, 0);
+    ws_.present.assign(n, 0);
+    for (NodeId key : ws_.keys)
+    {
+        ws_.present[key] = 1;
+    }
+    for (size_t e = 0; e < ws_.targets.size(); ++e)
+    {
+        ws_.rowStart[ws_.edgeFrom[e] + 1]++;
+        ws_.present[ws_.targets[e]] = 1;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        ws_.rowStart[i + 1] += ws_.rowStart[i];
+    }
+    ws_.low.assign(ws_.rowStart.begin(), ws_.rowStart.end() - 1); // write cursor per row
+    ws_.sortedTargets.resize(ws_.targets.size());
+    for (size_t e = 0; e < ws_.targets.size(); ++e)
     {
-        std::vector<NodeId> scc;
-        while (true)
+        ws_.sortedTargets[ws_.low[ws_.edgeFrom[e]]++] = ws_.targets[e];
+    }
+    ws_.targets.swap(ws_.sortedTargets);
+
+    ws_.index.assign(n, -1);
+    ws_.low.assign(n, 0);
+    ws_.onStack.assign(n, 0);
+    ws_.sccStack.clear();
+    ws_.callStack.clear();
+    ws_.sccMembers.clear();
+    ws_.sccOffsets.assign(1, 0);
+    int counter = 0;
+
+    for (NodeId root = 0; root <= maxNode; ++root)
+    {
+        if (!ws_.present[root] || ws_.index[root] != -1)
         {
-            NodeId node = st.top();
-            st.pop();
-            onStack[node] = false;
-            scc.push_back(node);
-            if (node == u)
-                break;
+            continue;
+        }
+        ws_.index[root] = ws_.low[root] = counter++;
+        ws_.sccStack.push_back(root);
+        ws_.onStack[root] = 1;
+        ws_.callStack.push_back({root, ws_.rowStart[root]});
+
+        while (!ws_.callStack.empty())
+        {
+            NodeId u = ws_.callStack.back().first;
+            int &nextEdge = ws_.callStack.back().second;
+            if (nextEdge < ws_.rowStart[u + 1])
+            {
+                NodeId v = ws_.targets[nextEdge++];
+                if (ws_.index[v] == -1)
+                {
+                    ws_.index[v] = ws_.low[v] = counter++;
+                    ws_.sccStack.push_back(v);
+                    ws_.onStack[v] = 1;
+                    ws_.callStack.push_back({v, ws_.rowStart[v]});
+                }
+                else if (ws_.onStack[v])
+                {
+                    ws_.low[u] = std::min(ws_.low[u], ws_.index[v]);
+                }
+                continue;
+            }
+
+            if (ws_.low[u] == ws_.index[u])
+            {
+                size_t begin = ws_.sccMembers.size();
+                NodeId node;
+                do
+                {
+                    node = ws_.sccStack.back();
+                    ws_.sccStack.pop_back();
+                    ws_.onStack[node] = 0;
+                    ws_.sccMembers.push_back(node);
+                } while (node != u);
+                std::reverse(ws_.sccMembers.begin() + begin, ws_.sccMembers.end());
+                ws_.sccOffsets.push_back(ws_.sccMembers.size());
+            }
+            ws_.callStack.pop_back();
+            if (!ws_.callStack.empty())
+            {
+                NodeId parent = ws_.callStack.back().first;
+                ws_.low[parent] = std::min(ws_.low[parent], ws_.low[u]);
+            }
         }
-        std::reverse(scc.begin(), scc.end());
-        sccs.push_back(scc);
     }
 }
 // Generates the PAG from sampled cross-node WFD edges.
@@ -68,82 +162,162 @@ PAG PAGManager::generatePAG(const std::vector<WFDEdge> &sampledPagEdges)
     std::cout << "PAGManager: Generated PAG with " << pag.size() << " nodes (unique waiting nodes).\n";
     return pag;
 }
-// Implements the greedy SCC (Strongly Connected Component) cutting algorithm for HAWK.
-// This function takes the constructed PAG and partitions the nodes into detection zones
-// based on their SCCs. SCCs larger than a given threshold become dedicated detection zones.
-// Nodes not part of such large SCCs become singleton zones.
-// This is a core component of HAWK's adaptive zone formation.
-std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>>
-PAGManager::greedySCCcut(const PAG &pag, int threshold)
+// Decays the accumulated weights and adds one sampling round.
+// Frequent, long-lived dependencies between two nodes build up weight across rounds, while
+// one-off waits fade out; the zone partitioner can then favour the persistent ones.
+void PAGManager::accumulateSample(const std::vector<WFDEdge> &sampledPagEdges, double decayFactor)
 {
-    std::vector<std::vector<NodeId>> sccs;
-    std::unordered_map<NodeId, int> disc;
-    std::unordered_map<NodeId, int> low;
-    std::stack<NodeId> st;
-    std::unordered_map<NodeId, bool> onStack;
-    int time = 0;
+    WeightedPAG roundCounts;
+    for (const auto &edge : sampledPagEdges)
+    {
+        roundCounts[edge.waitingNodeId][edge.holdingNodeId] += 1.0;
+    }
+    accumulateSample(roundCounts, decayFactor);
+}
+
+void PAGManager::accumulateSample(const WeightedPAG &roundCounts, double decayFactor)
+{
+    for (auto waitingIt = weightedPag_.begin(); waitingIt != weightedPag_.end();)
+    {
+        auto &neighbors = waitingIt->second;
+        for (auto holdingIt = neighbors.begin(); holdingIt != neighbors.end();)
+        {
+            holdingIt->second *= decayFactor;
+            if (holdingIt->second < PAG_PRUNE_WEIGHT)
+            {
+                holdingIt = neighbors.erase(holdingIt);
+            }
+            else
+            {
+                ++holdingIt;
+            }
+        }
+        if (neighbors.empty())
+        {
+            waitingIt = weightedPag_.erase(waitingIt);
+        }
+        else
+        {
+            ++waitingIt;
+        }
+    }
 
-    for (const auto &pair : pag)
+    double sampledWaits = 0.0;
+    for (const auto &waiting : roundCounts)
     {
-        disc[pair.first] = -1;
-        onStack[pair.first] = false;
-        for (NodeId neighbor : pair.second)
+        for (const auto &holding : waiting.second)
         {
-            if (disc.find(neighbor) == disc.end())
+            if (waiting.first != holding.first)
             {
-                disc[neighbor] = -1;
-                onStack[neighbor] = false;
+                weightedPag_[waiting.first][holding.first] += holding.second;
+                sampledWaits += holding.second;
             }
         }
     }
+    std::cout << "PAGManager: Weighted PAG has " << weightedPag_.size() << " waiting nodes after "
+              << sampledWaits << " sampled cross-node waits.\n";
+}
 
-    for (const auto &pair : pag)
+PAG PAGManager::thresholdPAG(const WeightedPAG &weightedPag, double minEdgeWeight)
+{
+    PAG pag;
+    for (const auto &pair : weightedPag)
     {
-        if (disc[pair.first] == -1)
+        for (const auto &neighbor : pair.second)
         {
-            findSCCsDFS(pair.first, pag, disc, low, st, onStack, sccs, time);
+            if (neighbor.second >= minEdgeWeight)
+            {
+                pag[pair.first].push_back(neighbor.first);
+            }
         }
     }
+    return pag;
+}
+
+std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>>
+PAGManager::greedySCCcut(const WeightedPAG &weightedPag, int threshold, double minEdgeWeight)
+{
+    findSCCs(flattenPAG(weightedPag, minEdgeWeight));
+    return cutSCCs(threshold);
+}
+
+// Implements the greedy SCC (Strongly Connected Component) cutting algorithm for HAWK.
+// This function takes the constructed PAG and partitions the nodes into detection zones
+// based on their SCCs. SCCs larger than a given threshold become dedicated detection zones.
+// Nodes not part of such large SCCs become singleton zones.
+// This is a core component of HAWK's adaptive zone formation.
+std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>>
+PAGManager::greedySCCcut(const PAG &pag, int threshold)
+{
+    findSCCs(flattenPAG(pag));
+    return cutSCCs(threshold);
+}
+
+std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>> PAGManager::cutSCCs(int threshold)
+{
+    const size_t numSccs = ws_.sccOffsets.size() - 1;
 
     std::vector<std::vector<NodeId>> detectionZones;
     std::vector<NodeId> detectionZoneLeaders;
 
-    std::cout << "PAGManager: Found " << sccs.size() << " SCCs before cutting.\n";
+    std::cout << "PAGManager: Found " << numSccs << " SCCs before cutting.\n";
 
-    for (const auto &scc : sccs)
+    ws_.covered.assign(ws_.present.size(), 0);
+    for (size_t i = 0; i < numSccs; ++i)
     {
-        if (scc.size() >= threshold)
+        auto begin = ws_.sccMembers.begin() + ws_.sccOffsets[i];
+        auto end = ws_.sccMembers.begin() + ws_.sccOffsets[i + 1];
+        if (end - begin < threshold)
         {
-            detectionZones.push_back(scc);
-            NodeId leader = scc[0];
-            for (size_t i = 1; i < scc.size(); ++i) {
-                if (scc[i] < leader) {
-                    leader = scc[i];
-                }
-            }
-            detectionZoneLeaders.push_back(leader);
-            std::cout << "SCC kept: Zone leader " << leader << " for zone with " << scc.size() << " members.\n";
+            continue;
         }
-    }
-
-    std::unordered_set<NodeId> covered_nodes;
-    for(const auto& zone : detectionZones) {
-        for(NodeId node : zone) {
-            covered_nodes.insert(node);
+        detectionZones.emplace_back(begin, end);
+        detectionZoneLeaders.push_back(*std::min_element(begin, end));
+        for (auto it = begin; it != end; ++it)
+        {
+            ws_.covered[*it] = 1;
         }
     }
+    std::cout << "PAGManager: Kept " << detectionZones.size() << " SCCs of at least " << threshold << " nodes.\n";
 
-    for (const auto& pair : pag) {
-        NodeId node = pair.first;
-        if (covered_nodes.find(node) == covered_nodes.end()) {
+    // Nodes that only appear as holders have no PAG entry of their own, so walk every
+    // node the SCC search saw rather than just the PAG keys.
+    size_t isolated = 0;
+    for (NodeId node = 0; node < static_cast<NodeId>(ws_.present.size()); ++node)
+    {
+        if (ws_.present[node] && !ws_.covered[node])
+        {
             detectionZones.push_back({node});
             detectionZoneLeaders.push_back(node);
-            covered_nodes.insert(node);
-            std::cout << "Isolated node: Node " << node << " becomes its own detection zone.\n";
+            isolated++;
         }
     }
+    std::cout << "PAGManager: " << isolated << " isolated nodes become their own detection zones.\n";
 
     std::cout << "Greedy SCC cut resulted in " << detectionZones.size() << " detection zones.\n";
 
     return {detectionZones, detectionZoneLeaders};
-}
\ No newline at end of file
+}
+
+void PAGManager::addSingletonZones(std::vector<std::vector<NodeId>> &zones, std::vector<NodeId> &leaders, int numNodes)
+{
+    std::vector<bool> covered(numNodes + 1, false);
+    for (const auto &zone : zones)
+    {
+        for (NodeId node : zone)
+        {
+            if (node >= 1 && node <= numNodes)
+            {
+                covered[node] = true;
+            }
+        }
+    }
+    for (NodeId node = 1; node <= numNodes; ++node)
+    {
+        if (!covered[node])
+        {
+            zones.push_back({node});
+            leaders.push_back(node);
+        }
+    }
+}
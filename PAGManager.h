@@ -10,6 +10,8 @@
 // and edges represent cross-node dependencies between transactions.
 // This graph is central to the HAWK detection zone formation.
 using PAG = std::unordered_map<NodeId, std::vector<NodeId>>;
+// Weighted PAG: waitingNode -> holdingNode -> decayed number of sampled cross-node waits.
+using WeightedPAG = std::unordered_map<NodeId, std::unordered_map<NodeId, double>>;
 
 class PAGManager
 {
@@ -21,6 +23,19 @@ public:
     // sampledPagEdges: A list of WFDEdges representing dependencies between nodes.
     // Returns: The constructed PAG.
     PAG generatePAG(const std::vector<WFDEdge> &sampledPagEdges);
+
+    // Folds one sampling round into the weighted PAG kept by this manager. Existing
+    // weights are first multiplied by decayFactor, then the round's count of every
+    // (waitingNode, holdingNode) pair is added. Edges that decay below PAG_PRUNE_WEIGHT are
+    // removed.
+    void accumulateSample(const WeightedPAG &roundCounts, double decayFactor = PAG_DECAY_FACTOR);
+    // Same, counting every sampled cross-node edge once.
+    void accumulateSample(const std::vector<WFDEdge> &sampledPagEdges, double decayFactor = PAG_DECAY_FACTOR);
+    const WeightedPAG &getWeightedPAG() const { return weightedPag_; }
+
+    // Returns the unweighted PAG made of the edges whose weight is at least minEdgeWeight,
+    // with each neighbour listed once.
+    static PAG thresholdPAG(const WeightedPAG &weightedPag, double minEdgeWeight);
     // Implements the greedy SCC (Strongly Connected Component) cutting algorithm.
     // This function takes the constructed PAG and a threshold to identify
     // strongly connected components (SCCs) within the PAG. These SCCs are then
@@ -31,27 +46,55 @@ public:
     //          and a vector of their corresponding zone leaders.
     std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>>
     greedySCCcut(const PAG &pag, int threshold);
+    // Greedy SCC cut over the persistent part of a weighted PAG: only edges with weight of
+    // at least minEdgeWeight can hold an SCC together.
+    std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>>
+    greedySCCcut(const WeightedPAG &weightedPag, int threshold, double minEdgeWeight = PAG_MIN_EDGE_WEIGHT);
+
+    // Adds a singleton zone for every node in 1..numNodes that no zone covers yet.
+    // A PAG only contains nodes with cross-node waits; without this, the remaining nodes
+    // would have no zone leader and their local deadlocks would never be collected.
+    static void addSingletonZones(std::vector<std::vector<NodeId>> &zones, std::vector<NodeId> &leaders, int numNodes);
 
 private:
-    // Helper function for Tarjan's algorithm (or a similar DFS-based algorithm) to find SCCs.
-    // This is a recursive DFS function that computes discovery times (disc) and low-link values (low)
-    // to identify SCCs in the PAG. SCCs are then used by `greedySCCcut` to define detection zones.
-    // u: The current node being visited.
-    // graph: The PAG.
-    // disc: Discovery times of nodes.
-    // low: Lowest discovery time reachable from node u.
-    // st: Stack used to store nodes currently in the recursion path.
-    // onStack: Boolean map indicating if a node is on the stack.
-    // sccs: Vector to store the identified SCCs.
-    // timer: Global timer for discovery times.
-    void findSCCsDFS(NodeId u,
-                     const PAG &graph,
-                     std::unordered_map<NodeId, int> &disc,
-                     std::unordered_map<NodeId, int> &low,
-                     std::stack<NodeId> &st,
-                     std::unordered_map<NodeId, bool> &onStack,
-                     std::vector<std::vector<NodeId>> &sccs,
-                     int &timer);
+    WeightedPAG weightedPag_;
+
+    // Reusable scratch space for the SCC search. Node ids are small and dense, so every
+    // per-node array is a plain vector indexed by NodeId. It is cleared but never freed,
+    // so once it has grown to the cluster size a search performs no heap allocations.
+    struct SCCWorkspace
+    {
+        std::vector<NodeId> keys;                      // nodes with a PAG entry
+        std::vector<NodeId> edgeFrom;                  // edge sources, in map order
+        std::vector<NodeId> sortedTargets;
+        std::vector<int> rowStart;                     // CSR row offsets, size maxNodeId + 2
+        std::vector<NodeId> targets;                   // CSR column indices
+        std::vector<char> present;                     // node appears in the PAG
+        std::vector<int> index;                        // discovery order, -1 if unvisited
+        std::vector<int> low;
+        std::vector<char> onStack;
+        std::vector<char> covered;                     // node is in a kept zone
+        std::vector<NodeId> sccStack;
+        std::vector<std::pair<NodeId, int>> callStack; // (node, next edge index)
+        std::vector<NodeId> sccMembers;                // all SCCs back to back
+        std::vector<size_t> sccOffsets;                // SCC i is sccMembers[sccOffsets[i], sccOffsets[i + 1])
+    };
+
+    SCCWorkspace ws_;
+
+    // Copy the PAG's edges into ws_.keys / edgeFrom / targets in one pass over the hash
+    // map and return the largest NodeId seen. The weighted variant keeps only edges of at
+    // least minEdgeWeight, and only nodes with such an edge.
+    NodeId flattenPAG(const PAG &graph);
+    NodeId flattenPAG(const WeightedPAG &weightedPag, double minEdgeWeight);
+    // Tarjan's algorithm over an explicit call stack, so a long dependency chain cannot
+    // overflow the thread stack. Runs on the flattened PAG and fills ws_.sccMembers and
+    // ws_.sccOffsets; roots are taken in ascending NodeId order, which makes the result
+    // independent of hash order.
+    void findSCCs(NodeId maxNode);
+    // Turns the SCCs found last into zones: SCCs of at least `threshold` nodes, and a
+    // singleton for every other node.
+    std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>> cutSCCs(int threshold);
 };
 
 #endif // HAWK_PAG_MANAGER_H
\ No newline at end of file
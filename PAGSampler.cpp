@@ -0,0 +1,55 @@
+#include "PAGSampler.h"
+
+PAGSampler::PAGSampler(size_t capacity) : capacity_(capacity > 0 ? capacity : 1)
+{
+}
+
+void PAGSampler::recordWait(NodeId waitingNode, NodeId holdingNode)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    long long key = pairKey(waitingNode, holdingNode);
+    auto it = indexOf_.find(key);
+    if (it != indexOf_.end())
+    {
+        entries_[it->second].count++;
+        return;
+    }
+    if (entries_.size() < capacity_)
+    {
+        indexOf_[key] = entries_.size();
+        entries_.push_back({waitingNode, holdingNode, 1, 0});
+        return;
+    }
+
+    // Only rounds with more distinct pairs than the capacity get here; the scan is bounded
+    // by the capacity.
+    size_t victim = 0;
+    for (size_t i = 1; i < entries_.size(); ++i)
+    {
+        if (entries_[i].count < entries_[victim].count)
+        {
+            victim = i;
+        }
+    }
+    Entry &entry = entries_[victim];
+    indexOf_.erase(pairKey(entry.waitingNode, entry.holdingNode));
+    indexOf_[key] = victim;
+    entry = {waitingNode, holdingNode, entry.count + 1, entry.count};
+}
+
+std::vector<PAGPairCount> PAGSampler::drain()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<PAGPairCount> summary;
+    summary.reserve(entries_.size());
+    for (const Entry &entry : entries_)
+    {
+        if (entry.count > entry.error)
+        {
+            summary.push_back({entry.waitingNode, entry.holdingNode, entry.count - entry.error});
+        }
+    }
+    entries_.clear();
+    indexOf_.clear();
+    return summary;
+}
@@ -0,0 +1,46 @@
+#ifndef HAWK_PAG_SAMPLER_H
+#define HAWK_PAG_SAMPLER_H
+
+#include "commons.h"
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+// PAGSampler summarises the cross-node waits a node sees between two PAG rounds, so that
+// a PAG response no longer grows with the number of waiting transactions. Every wait adds
+// one to the (waiting node, holding node) pair it creates. The pairs are kept in a
+// Space-Saving table of at most `capacity` entries: a new pair arriving at a full table
+// replaces the pair with the lowest count and inherits that count as its error. Any pair
+// making up more than 1/capacity of the waits of a round is guaranteed to be kept.
+class PAGSampler
+{
+public:
+    explicit PAGSampler(size_t capacity = PAG_SAMPLER_CAPACITY);
+
+    void recordWait(NodeId waitingNode, NodeId holdingNode);
+
+    // Returns the pairs of the round with their guaranteed count (count minus error; pairs
+    // with nothing guaranteed are left out) and starts a new round.
+    std::vector<PAGPairCount> drain();
+
+private:
+    struct Entry
+    {
+        NodeId waitingNode;
+        NodeId holdingNode;
+        long long count;
+        long long error;
+    };
+
+    static long long pairKey(NodeId waitingNode, NodeId holdingNode)
+    {
+        return (static_cast<long long>(waitingNode) << 32) | static_cast<unsigned int>(holdingNode);
+    }
+
+    size_t capacity_;
+    std::vector<Entry> entries_;
+    std::unordered_map<long long, size_t> indexOf_;
+    std::mutex mutex_;
+};
+
+#endif // HAWK_PAG_SAMPLER_H
@@ -0,0 +1,141 @@
+#include "PAGTrace.h"
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+void putUint32(std::ostream &out, uint32_t value)
+{
+    char bytes[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+    out.write(bytes, 4);
+}
+
+void putUint64(std::ostream &out, uint64_t value)
+{
+    putUint32(out, static_cast<uint32_t>(value));
+    putUint32(out, static_cast<uint32_t>(value >> 32));
+}
+
+bool getUint32(std::istream &in, uint32_t &value)
+{
+    unsigned char bytes[4];
+    if (!in.read(reinterpret_cast<char *>(bytes), 4))
+    {
+        return false;
+    }
+    value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+    return true;
+}
+
+bool getUint64(std::istream &in, uint64_t &value)
+{
+    uint32_t low;
+    uint32_t high;
+    if (!getUint32(in, low) || !getUint32(in, high))
+    {
+        return false;
+    }
+    value = (static_cast<uint64_t>(high) << 32) | low;
+    return true;
+}
+
+bool getPairs(std::istream &in, uint32_t count, std::vector<PAGPairCount> &pairs)
+{
+    pairs.reserve(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t waiting;
+        uint32_t holding;
+        uint32_t waits;
+        if (!getUint32(in, waiting) || !getUint32(in, holding) || !getUint32(in, waits))
+        {
+            return false;
+        }
+        pairs.push_back({static_cast<NodeId>(waiting), static_cast<NodeId>(holding), waits});
+    }
+    return true;
+}
+} // namespace
+
+bool PAGTrace::open(const std::string &path, int numNodes)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_)
+    {
+        std::cerr << "PAGTrace: Cannot write " << path << "\n";
+        return false;
+    }
+    putUint32(out_, MAGIC);
+    putUint32(out_, FORMAT_VERSION);
+    putUint32(out_, static_cast<uint32_t>(numNodes));
+    openedAt_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+void PAGTrace::writeRound(const std::vector<PAGPairCount> &waits, const std::vector<PAGPairCount> &predicted)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!out_.is_open())
+    {
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - openedAt_);
+    putUint64(out_, static_cast<uint64_t>(elapsed.count()));
+    putUint32(out_, static_cast<uint32_t>(waits.size()));
+    putUint32(out_, static_cast<uint32_t>(predicted.size()));
+    writePairs(waits);
+    writePairs(predicted);
+    // A run is usually stopped by killing it; keep every finished round on disk.
+    out_.flush();
+}
+
+void PAGTrace::writePairs(const std::vector<PAGPairCount> &pairs)
+{
+    for (const PAGPairCount &pair : pairs)
+    {
+        putUint32(out_, static_cast<uint32_t>(pair.waitingNodeId));
+        putUint32(out_, static_cast<uint32_t>(pair.holdingNodeId));
+        putUint32(out_, static_cast<uint32_t>(std::min<long long>(pair.count, UINT32_MAX)));
+    }
+}
+
+bool PAGTrace::load(const std::string &path, int &numNodes, std::vector<PAGTraceRound> &rounds)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "PAGTrace: Cannot read " << path << "\n";
+        return false;
+    }
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nodes;
+    if (!getUint32(in, magic) || !getUint32(in, version) || !getUint32(in, nodes) || magic != MAGIC ||
+        version != FORMAT_VERSION)
+    {
+        std::cerr << "PAGTrace: " << path << " is not a PAG trace of format version " << FORMAT_VERSION << "\n";
+        return false;
+    }
+    numNodes = static_cast<int>(nodes);
+    rounds.clear();
+    while (true)
+    {
+        PAGTraceRound round;
+        uint64_t timestampMs;
+        uint32_t numWaits;
+        uint32_t numPredicted;
+        if (!getUint64(in, timestampMs) || !getUint32(in, numWaits) || !getUint32(in, numPredicted) ||
+            !getPairs(in, numWaits, round.waits) || !getPairs(in, numPredicted, round.predicted))
+        {
+            break;
+        }
+        round.timestampMs = static_cast<long long>(timestampMs);
+        rounds.push_back(std::move(round));
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef HAWK_PAG_TRACE_H
+#define HAWK_PAG_TRACE_H
+
+#include "commons.h"
+#include <vector>
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+// One PAG sampling round as the central node received it.
+struct PAGTraceRound
+{
+    long long timestampMs = 0; // since the trace was opened
+    std::vector<PAGPairCount> waits;     // observed cross-node waits
+    std::vector<PAGPairCount> predicted; // remote accesses declared by new transactions
+};
+
+// PAGTrace records the PAG rounds of a run so zone partitioning can be replayed offline
+// (ZonePlanner). The file is a header ("HPAG", format version, number of nodes, all
+// uint32) followed by one record per round: uint64 timestamp, uint32 number of wait pairs,
+// uint32 number of predicted pairs, then 12 bytes per pair (uint32 waiting node, uint32
+// holding node, uint32 count). Integers are little-endian.
+class PAGTrace
+{
+public:
+    PAGTrace() = default;
+
+    // Creates or truncates path and writes the header. Returns false if it cannot.
+    bool open(const std::string &path, int numNodes);
+    bool isOpen() const { return out_.is_open(); }
+
+    void writeRound(const std::vector<PAGPairCount> &waits, const std::vector<PAGPairCount> &predicted);
+
+    // Reads a whole trace. Returns false on a missing file or a bad header; a truncated
+    // last round is dropped.
+    static bool load(const std::string &path, int &numNodes, std::vector<PAGTraceRound> &rounds);
+
+private:
+    static const uint32_t MAGIC = 0x47415048; // "HPAG" read as little-endian uint32
+    static const uint32_t FORMAT_VERSION = 1;
+
+    void writePairs(const std::vector<PAGPairCount> &pairs);
+
+    std::ofstream out_;
+    std::chrono::steady_clock::time_point openedAt_;
+    std::mutex mutex_;
+};
+
+#endif // HAWK_PAG_TRACE_H
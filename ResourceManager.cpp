@@ -21,6 +21,17 @@ bool ResourceManager::acquireLock(TransactionId transId, ResourceId resId, LockM
     {
         resourceWaitingQueues_[resId].push(transId);
         std::cout << "Node " << nodeId_ << ": Trans " << transId << " BLOCKED on R" << resId << " (Mode: " << (mode == LockMode::EXCLUSIVE ? "EX" : "SH") << ").\n";
+        if (onTransactionBlocked)
+        {
+            std::vector<TransactionId> holders;
+            for (const auto &holder : resourceHolders_[resId])
+            {
+                holders.push_back(holder.first);
+            }
+            queues_lock.unlock();
+            holders_lock.unlock();
+            onTransactionBlocked(transId, holders);
+        }
         return false;
     }
     else
@@ -6,6 +6,7 @@
 #include <queue>
 #include <mutex>
 #include <functional>
+#include <vector>
 
 // ResourceManager is responsible for managing local resources and handling lock requests
 // and releases for those resources. It maintains who holds which locks and who is waiting.
@@ -26,6 +27,9 @@ public:
     std::vector<ResourceId> getLocalResources() const;
 
     std::function<void(TransactionId, ResourceId)> notifyTransactionToRetryAcquire;
+    // Called with the blocked transaction and the holders it now waits for, after the
+    // resource locks are released.
+    std::function<void(TransactionId, const std::vector<TransactionId> &)> onTransactionBlocked;
 
     bool removeTransactionFromWaitingQueue(TransactionId transId, ResourceId resId);
 
@@ -55,6 +55,12 @@ public:
         return queue_.empty();
     }
 
+    size_t size() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
     std::vector<T> drain() {
         std::unique_lock<std::mutex> lock(mutex_);
         std::vector<T> elements;
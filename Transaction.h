@@ -23,9 +23,11 @@ struct Transaction
 
     TransactionId id;
     NodeId homeNodeId;
+    Incarnation incarnation = 0;
     std::vector<SQLStatement> statements;
     TransactionStatus status = TransactionStatus::RUNNING;
     std::chrono::high_resolution_clock::time_point startTime;
+    std::chrono::high_resolution_clock::time_point blockedSince; // when status last became BLOCKED
     std::unordered_map<ResourceId, LockMode> acquiredLocks;
     int currentSQLIndex = 0;
 
@@ -24,6 +24,7 @@ std::shared_ptr<Transaction> TransactionManager::beginTransaction()
     newTrans->id = getNextTransactionId();
     newTrans->homeNodeId = nodeId;
     newTrans->startTime = std::chrono::high_resolution_clock::now();
+    newTrans->incarnation = makeIncarnation(nodeId, nextIncarnationSequence++);
 
     int numSqls = RandomGenerators::getExponentialInt(SQL_COUNT_LAMBDA, MIN_SQLS_PER_TRANSACTION, MAX_SQLS_PER_TRANSACTION);
     newTrans->statements = generateRandomSQLStatements(newTrans->id, newTrans->homeNodeId);
@@ -39,6 +40,7 @@ std::shared_ptr<Transaction> TransactionManager::beginControlledTransaction(cons
     newTrans->id = getNextTransactionId();
     newTrans->homeNodeId = nodeId;
     newTrans->startTime = std::chrono::high_resolution_clock::now();
+    newTrans->incarnation = makeIncarnation(nodeId, nextIncarnationSequence++);
     newTrans->statements = statements;
 
     std::unique_lock<std::mutex> lock(activeTransactionsMutex);
@@ -86,6 +88,7 @@ bool TransactionManager::tryExecuteNextSQLStatement(TransactionId transId)
         else
         {
             trans->status = TransactionStatus::BLOCKED;
+            trans->blockedSince = std::chrono::high_resolution_clock::now();
             trans->waitingForResourceId = resId;
             return false;
         }
@@ -109,6 +112,7 @@ bool TransactionManager::tryExecuteNextSQLStatement(TransactionId transId)
         sendNetworkMessage(requestMsg);
 
         trans->status = TransactionStatus::BLOCKED;
+        trans->blockedSince = std::chrono::high_resolution_clock::now();
         return false;
     }
 }
@@ -249,6 +253,7 @@ std::vector<long long> TransactionManager::getCompletedTransactionLatencies() {
 
 void TransactionManager::addTPCCTransaction(std::shared_ptr<Transaction> tpccTrans) {
     std::unique_lock<std::mutex> lock(activeTransactionsMutex);
+    tpccTrans->incarnation = makeIncarnation(nodeId, nextIncarnationSequence++);
     activeTransactions[tpccTrans->id] = tpccTrans;
 }
 
@@ -274,6 +279,72 @@ NodeId TransactionManager::getTransactionHomeNode(TransactionId transId) {
     return 0;
 }
 
+Incarnation TransactionManager::getTransactionIncarnation(TransactionId transId) {
+    std::unique_lock<std::mutex> lock(activeTransactionsMutex);
+    auto it = activeTransactions.find(transId);
+    if (it != activeTransactions.end()) {
+        return it->second->incarnation;
+    }
+    return 0;
+}
+
+std::vector<TransactionCost> TransactionManager::getBlockedTransactionCosts() {
+    auto now = std::chrono::high_resolution_clock::now();
+    std::vector<TransactionCost> costs;
+    std::unique_lock<std::mutex> lock(activeTransactionsMutex);
+    for (const auto &pair : activeTransactions) {
+        const std::shared_ptr<Transaction> &trans = pair.second;
+        if (trans->status != TransactionStatus::BLOCKED) {
+            continue;
+        }
+        costs.push_back(makeTransactionCost(*trans, now));
+    }
+    return costs;
+}
+
+bool TransactionManager::getTransactionCost(TransactionId transId, TransactionCost &cost) {
+    auto now = std::chrono::high_resolution_clock::now();
+    std::unique_lock<std::mutex> lock(activeTransactionsMutex);
+    auto it = activeTransactions.find(transId);
+    if (it == activeTransactions.end()) {
+        return false;
+    }
+    cost = makeTransactionCost(*it->second, now);
+    return true;
+}
+
+TransactionCost TransactionManager::makeTransactionCost(const Transaction &trans,
+                                                        std::chrono::high_resolution_clock::time_point now) {
+    TransactionCost cost;
+    cost.transId = trans.id;
+    cost.incarnation = trans.incarnation;
+    cost.ageMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - trans.startTime).count();
+    cost.statementsDone = trans.currentSQLIndex;
+    cost.statementsTotal = static_cast<int>(trans.statements.size());
+    cost.locksHeld = static_cast<int>(trans.acquiredLocks.size());
+    for (const auto &lock : trans.acquiredLocks) {
+        NodeId owner = getOwnerNodeId(lock.first);
+        if (std::find(cost.lockNodes.begin(), cost.lockNodes.end(), owner) == cost.lockNodes.end()) {
+            cost.lockNodes.push_back(owner);
+        }
+    }
+    return cost;
+}
+
+std::vector<TransactionId> TransactionManager::getTransactionsBlockedFor(long long minMs) {
+    auto now = std::chrono::high_resolution_clock::now();
+    std::vector<TransactionId> blocked;
+    std::unique_lock<std::mutex> lock(activeTransactionsMutex);
+    for (const auto &pair : activeTransactions) {
+        const std::shared_ptr<Transaction> &trans = pair.second;
+        if (trans->status == TransactionStatus::BLOCKED &&
+            std::chrono::duration_cast<std::chrono::milliseconds>(now - trans->blockedSince).count() >= minMs) {
+            blocked.push_back(trans->id);
+        }
+    }
+    return blocked;
+}
+
 std::vector<SQLStatement> TransactionManager::generateRandomSQLStatements(TransactionId transId, NodeId homeNodeId)
 {
     std::vector<SQLStatement> statements;
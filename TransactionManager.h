@@ -14,6 +14,7 @@
 #include <mutex>
 #include <functional>
 #include <unordered_set>
+#include <atomic>
 
 class Network;
 
@@ -60,6 +61,18 @@ public:
 
     NodeId getTransactionHomeNode(TransactionId transId);
 
+    // Returns the incarnation of an active transaction, or 0 if it is not active here.
+    Incarnation getTransactionIncarnation(TransactionId transId);
+
+    // Returns what aborting each currently blocked transaction would throw away.
+    // Every member of a deadlock cycle is blocked, so this covers all victim candidates
+    // homed on this node.
+    std::vector<TransactionCost> getBlockedTransactionCosts();
+    // Fills cost for one active transaction. Returns false if it is not active here.
+    bool getTransactionCost(TransactionId transId, TransactionCost &cost);
+    // Transactions that have been blocked for at least minMs.
+    std::vector<TransactionId> getTransactionsBlockedFor(long long minMs);
+
 private:
     NodeId nodeId;
     ResourceManager &resourceManager;
@@ -67,6 +80,7 @@ private:
     std::function<void(const NetworkMessage &)> sendNetworkMessage;
 
     TransactionId nextTransactionId = 1;
+    std::atomic<long long> nextIncarnationSequence{1};
 
     std::unordered_map<TransactionId, std::shared_ptr<Transaction>> activeTransactions;
     std::mutex activeTransactionsMutex;
@@ -74,6 +88,7 @@ private:
     SafeQueue<long long> completedTransactionLatencies_;
 
     void notifyTransactionToRetryAcquire(TransactionId transId, ResourceId resId);
+    TransactionCost makeTransactionCost(const Transaction &trans, std::chrono::high_resolution_clock::time_point now);
 
     std::vector<SQLStatement> generateRandomSQLStatements(TransactionId transId, NodeId homeNodeId);
     TPCCRandom& rng_;
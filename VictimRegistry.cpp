@@ -0,0 +1,59 @@
+#include "VictimRegistry.h"
+#include <algorithm>
+
+bool VictimRegistry::add(Incarnation incarnation)
+{
+    if (incarnation == 0)
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    Clock::time_point now = Clock::now();
+    expire(now);
+    Clock::time_point expiry = now + std::chrono::milliseconds(VICTIM_REGISTRY_TTL_MS);
+    if (!expiresAt_.emplace(incarnation, expiry).second)
+    {
+        return false;
+    }
+    nextExpiry_ = std::min(nextExpiry_, expiry);
+    return true;
+}
+
+void VictimRegistry::addAll(const std::vector<Incarnation> &incarnations)
+{
+    for (Incarnation incarnation : incarnations)
+    {
+        add(incarnation);
+    }
+}
+
+bool VictimRegistry::contains(Incarnation incarnation)
+{
+    if (incarnation == 0)
+    {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    expire(Clock::now());
+    return expiresAt_.count(incarnation) > 0;
+}
+
+void VictimRegistry::expire(Clock::time_point now)
+{
+    // Entries share one lifetime, so a sweep is only due once the oldest has expired.
+    if (now < nextExpiry_)
+    {
+        return;
+    }
+    nextExpiry_ = Clock::time_point::max();
+    for (auto it = expiresAt_.begin(); it != expiresAt_.end();)
+    {
+        if (it->second <= now)
+        {
+            it = expiresAt_.erase(it);
+            continue;
+        }
+        nextExpiry_ = std::min(nextExpiry_, it->second);
+        ++it;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef HAWK_VICTIM_REGISTRY_H
+#define HAWK_VICTIM_REGISTRY_H
+
+#include "commons.h"
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// VictimRegistry remembers, by incarnation, the deadlock victims this node has aborted and
+// those the zones reporting to it have aborted. Each tier of the detection tree resolves
+// cycles of its own, and the edges it sees may have been reported before the victims of
+// the tiers below, or of an earlier round, were aborted. Aborting one member breaks every
+// cycle through it, so a cycle with a registered member needs no second abort.
+// An entry expires VICTIM_REGISTRY_TTL_MS after it was added. By then the victim's edges
+// have left every WFG, or its abort was lost and its cycles are due to be resolved again.
+class VictimRegistry
+{
+public:
+    // Registers incarnation as a victim. Returns false if it already was one or is 0.
+    bool add(Incarnation incarnation);
+    void addAll(const std::vector<Incarnation> &incarnations);
+
+    bool contains(Incarnation incarnation);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Drops the entries that expired by now. mutex_ must be held.
+    void expire(Clock::time_point now);
+
+    std::mutex mutex_;
+    std::unordered_map<Incarnation, Clock::time_point> expiresAt_;
+    Clock::time_point nextExpiry_ = Clock::time_point::max(); // earliest entry in expiresAt_
+};
+
+#endif // HAWK_VICTIM_REGISTRY_H
@@ -0,0 +1,226 @@
+#include "VictimSelector.h"
+#include <algorithm>
+#include <unordered_set>
+
+VictimSelector::VictimSelector(VictimPolicy policy)
+    : policy_(policy)
+{
+}
+
+bool VictimSelector::parsePolicy(const std::string &name, VictimPolicy &policy)
+{
+    static const VictimPolicy allPolicies[] = {
+        VictimPolicy::MOST_CYCLES, VictimPolicy::YOUNGEST, VictimPolicy::LEAST_WORK,
+        VictimPolicy::FEWEST_LOCKS, VictimPolicy::DEADLINE_AWARE, VictimPolicy::STARVATION_AWARE};
+    for (VictimPolicy candidate : allPolicies)
+    {
+        if (name == policyName(candidate))
+        {
+            policy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *VictimSelector::policyName(VictimPolicy policy)
+{
+    switch (policy)
+    {
+    case VictimPolicy::MOST_CYCLES:
+        return "most-cycles";
+    case VictimPolicy::YOUNGEST:
+        return "youngest";
+    case VictimPolicy::LEAST_WORK:
+        return "least-work";
+    case VictimPolicy::FEWEST_LOCKS:
+        return "fewest-locks";
+    case VictimPolicy::DEADLINE_AWARE:
+        return "deadline";
+    case VictimPolicy::STARVATION_AWARE:
+        return "starvation";
+    }
+    return "unknown";
+}
+
+void VictimCostTable::add(const std::vector<TransactionCost> &costs)
+{
+    for (const TransactionCost &cost : costs)
+    {
+        if (cost.incarnation != 0)
+        {
+            costsByIncarnation_[cost.incarnation] = cost;
+        }
+    }
+}
+
+void VictimCostTable::clear()
+{
+    costsByIncarnation_.clear();
+}
+
+const TransactionCost *VictimCostTable::find(TransactionId transId, Incarnation incarnation) const
+{
+    if (incarnation == 0)
+    {
+        return nullptr;
+    }
+    auto it = costsByIncarnation_.find(incarnation);
+    if (it == costsByIncarnation_.end() || it->second.transId != transId)
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+std::vector<TransactionCost> VictimCostTable::collect(const std::vector<WFGEdgeTag> &tags) const
+{
+    std::vector<TransactionCost> costs;
+    std::unordered_set<Incarnation> seen;
+    for (const WFGEdgeTag &tag : tags)
+    {
+        const TransactionCost *cost = find(tag.waitingTransId, tag.waitingIncarnation);
+        if (cost && seen.insert(tag.waitingIncarnation).second)
+        {
+            costs.push_back(*cost);
+        }
+    }
+    return costs;
+}
+
+int VictimSelector::getPriorAborts(TransactionId transId, Incarnation incarnation) const
+{
+    if (incarnation == 0)
+    {
+        return 0;
+    }
+    auto it = abortHistory_.find(historyKey(transId, incarnation));
+    if (it == abortHistory_.end() || it->second.expiresAt <= Clock::now())
+    {
+        return 0;
+    }
+    return it->second.aborts;
+}
+
+void VictimSelector::recordVictim(TransactionId victimId, Incarnation incarnation)
+{
+    if (incarnation == 0)
+    {
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    expireHistory(now);
+    Clock::time_point expiry = now + std::chrono::milliseconds(VICTIM_REGISTRY_TTL_MS);
+    AbortHistoryEntry &entry = abortHistory_.emplace(historyKey(victimId, incarnation), AbortHistoryEntry{0, expiry}).first->second;
+    entry.aborts++;
+    entry.expiresAt = expiry;
+    nextExpiry_ = std::min(nextExpiry_, expiry);
+}
+
+void VictimSelector::expireHistory(Clock::time_point now)
+{
+    // Renewing an entry only moves its expiry later, so nextExpiry_ stays a lower bound.
+    if (now < nextExpiry_)
+    {
+        return;
+    }
+    nextExpiry_ = Clock::time_point::max();
+    for (auto it = abortHistory_.begin(); it != abortHistory_.end();)
+    {
+        if (it->second.expiresAt <= now)
+        {
+            it = abortHistory_.erase(it);
+            continue;
+        }
+        nextExpiry_ = std::min(nextExpiry_, it->second.expiresAt);
+        ++it;
+    }
+}
+
+bool VictimSelector::isBetterVictim(const Candidate &a, const Candidate &b) const
+{
+    const long long ageA = a.cost ? a.cost->ageMs : 0;
+    const long long ageB = b.cost ? b.cost->ageMs : 0;
+    const int workA = a.cost ? a.cost->statementsDone : 0;
+    const int workB = b.cost ? b.cost->statementsDone : 0;
+    const int locksA = a.cost ? a.cost->locksHeld : 0;
+    const int locksB = b.cost ? b.cost->locksHeld : 0;
+
+    switch (policy_)
+    {
+    case VictimPolicy::MOST_CYCLES:
+        break;
+    case VictimPolicy::YOUNGEST:
+        if (ageA != ageB) return ageA < ageB;
+        break;
+    case VictimPolicy::LEAST_WORK:
+        if (workA != workB) return workA < workB;
+        if (locksA != locksB) return locksA < locksB;
+        if (ageA != ageB) return ageA < ageB;
+        break;
+    case VictimPolicy::FEWEST_LOCKS:
+        if (locksA != locksB) return locksA < locksB;
+        if (workA != workB) return workA < workB;
+        break;
+    case VictimPolicy::DEADLINE_AWARE:
+    {
+        // Transactions past their deadline have no slack left and are protected.
+        const long long slackA = std::max(0LL, VICTIM_DEADLINE_MS - ageA);
+        const long long slackB = std::max(0LL, VICTIM_DEADLINE_MS - ageB);
+        if (slackA != slackB) return slackA > slackB;
+        if (workA != workB) return workA < workB;
+        break;
+    }
+    case VictimPolicy::STARVATION_AWARE:
+        if (a.priorAborts != b.priorAborts) return a.priorAborts < b.priorAborts;
+        if (ageA != ageB) return ageA < ageB;
+        if (workA != workB) return workA < workB;
+        break;
+    }
+    return DeadlockDetector::compareTransactionPriority({a.transId, a.frequency}, {b.transId, b.frequency});
+}
+
+TransactionId VictimSelector::selectVictim(const CycleSet &cycles, size_t cycleIndex, const WFGValidator &validator,
+                                           const VictimCostTable &costs) const
+{
+    const size_t begin = cycles.offsets[cycleIndex];
+    const size_t end = cycles.offsets[cycleIndex + 1];
+
+    Candidate best{0, 0, nullptr, 0};
+    for (size_t i = begin; i < end; ++i)
+    {
+        TransactionId member = cycles.members[i];
+        Candidate candidate{member, cycles.memberFrequency[i], nullptr, 0};
+        if (policy_ != VictimPolicy::MOST_CYCLES)
+        {
+            Incarnation incarnation = validator.getCycleMemberIncarnation(cycles, cycleIndex, member);
+            candidate.cost = costs.find(member, incarnation);
+            candidate.priorAborts = getPriorAborts(member, incarnation);
+        }
+        if (i == begin || isBetterVictim(candidate, best))
+        {
+            best = candidate;
+        }
+    }
+    return best.transId;
+}
+
+TransactionId VictimSelector::selectVictim(const std::vector<TransactionId> &cycle,
+                                           const std::vector<TransactionCost> &costs) const
+{
+    Candidate best{0, 0, nullptr, 0};
+    for (size_t i = 0; i < cycle.size(); ++i)
+    {
+        Candidate candidate{cycle[i], 1, nullptr, 0};
+        if (policy_ != VictimPolicy::MOST_CYCLES && i < costs.size() && costs[i].transId == cycle[i])
+        {
+            candidate.cost = &costs[i];
+            candidate.priorAborts = getPriorAborts(cycle[i], costs[i].incarnation);
+        }
+        if (i == 0 || isBetterVictim(candidate, best))
+        {
+            best = candidate;
+        }
+    }
+    return best.transId;
+}
@@ -0,0 +1,105 @@
+#ifndef HAWK_VICTIM_SELECTOR_H
+#define HAWK_VICTIM_SELECTOR_H
+
+#include "commons.h"
+#include "DeadlockDetector.h"
+#include "WFGValidator.h"
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <chrono>
+
+// How a detecting node picks the transaction to abort in each deadlock cycle.
+enum class VictimPolicy
+{
+    MOST_CYCLES,     // transaction in the most cycles, then lowest id (original behaviour)
+    YOUNGEST,        // most recently started transaction
+    LEAST_WORK,      // fewest statements executed, protecting nearly-complete transactions
+    FEWEST_LOCKS,    // fewest locks held
+    DEADLINE_AWARE,  // most slack left before VICTIM_DEADLINE_MS
+    STARVATION_AWARE // fewest earlier aborts, then youngest
+};
+
+// The abort costs one detection round ranks its cycles by. Home nodes report a
+// TransactionCost for each of their blocked transactions together with their WFG, and a
+// zone leader forwards those of its residual graph with its report. Every kind of round
+// fills a table of its own, so rounds running at the same time never see each other's.
+class VictimCostTable
+{
+public:
+    // Records the costs from one report.
+    void add(const std::vector<TransactionCost> &costs);
+    void clear();
+
+    // Returns the cost reported for this lifetime of transId, or nullptr if none was.
+    const TransactionCost *find(TransactionId transId, Incarnation incarnation) const;
+    // Returns the known costs of the waiting transactions of tags, each once, for
+    // forwarding with a residual graph.
+    std::vector<TransactionCost> collect(const std::vector<WFGEdgeTag> &tags) const;
+
+private:
+    std::unordered_map<Incarnation, TransactionCost> costsByIncarnation_;
+};
+
+// VictimSelector chooses deadlock victims on an aggregating node (central node or zone
+// leader). It ranks the members of a cycle by the costs of the round according to the
+// configured policy. Members without a reported cost are treated as having done no work yet.
+// It also keeps an abort history keyed by home node and TransactionId, so a transaction
+// that is retried under the same id keeps its count across incarnations. An entry expires
+// VICTIM_REGISTRY_TTL_MS after the transaction's last abort.
+class VictimSelector
+{
+public:
+    explicit VictimSelector(VictimPolicy policy = VictimPolicy::MOST_CYCLES);
+
+    // Parses a policy name as accepted on the command line (see policyName).
+    static bool parsePolicy(const std::string &name, VictimPolicy &policy);
+    static const char *policyName(VictimPolicy policy);
+
+    VictimPolicy getPolicy() const { return policy_; }
+
+    // Returns the victim of cycle cycleIndex. The validator resolves each member to the
+    // incarnation it was reported with, which is how its cost is looked up in costs.
+    TransactionId selectVictim(const CycleSet &cycles, size_t cycleIndex, const WFGValidator &validator,
+                               const VictimCostTable &costs) const;
+    // Returns the victim of a cycle found by a path-pushing probe, which carries the cost
+    // of every member itself; costs is parallel to cycle. Each member is in this one cycle.
+    TransactionId selectVictim(const std::vector<TransactionId> &cycle, const std::vector<TransactionCost> &costs) const;
+
+    // Adds a chosen victim to the abort history used by STARVATION_AWARE.
+    void recordVictim(TransactionId victimId, Incarnation incarnation);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct AbortHistoryEntry
+    {
+        int aborts;
+        Clock::time_point expiresAt;
+    };
+
+    struct Candidate
+    {
+        TransactionId transId;
+        int frequency;
+        const TransactionCost *cost;
+        int priorAborts;
+    };
+
+    // True if a should be aborted rather than b.
+    bool isBetterVictim(const Candidate &a, const Candidate &b) const;
+    int getPriorAborts(TransactionId transId, Incarnation incarnation) const;
+    // Drops the history entries that expired by now.
+    void expireHistory(Clock::time_point now);
+
+    static long long historyKey(TransactionId transId, Incarnation incarnation)
+    {
+        return (static_cast<long long>(getIncarnationHomeNode(incarnation)) << 32) | static_cast<unsigned int>(transId);
+    }
+
+    VictimPolicy policy_;
+    std::unordered_map<long long, AbortHistoryEntry> abortHistory_;
+    Clock::time_point nextExpiry_ = Clock::time_point::max(); // earliest entry in abortHistory_
+};
+
+#endif // HAWK_VICTIM_SELECTOR_H
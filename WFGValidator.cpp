@@ -0,0 +1,179 @@
+#include "WFGValidator.h"
+#include <algorithm>
+#include <iostream>
+
+void WFGValidator::addEdgeTags(const std::vector<WFGEdgeTag> &tags)
+{
+    for (const auto &tag : tags)
+    {
+        long long &latest = latestEpoch_[tag.reporterNodeId];
+        if (tag.epoch < latest)
+        {
+            continue;
+        }
+        latest = tag.epoch;
+
+        auto it = edgeTags_.find(edgeKey(tag.waitingTransId, tag.holdingTransId));
+        if (it == edgeTags_.end())
+        {
+            edgeTags_.emplace(edgeKey(tag.waitingTransId, tag.holdingTransId), tag);
+        }
+        else if (it->second.reporterNodeId != tag.reporterNodeId || it->second.epoch <= tag.epoch)
+        {
+            it->second = tag;
+        }
+    }
+}
+
+const WFGEdgeTag *WFGValidator::findCurrentTag(TransactionId waiting, TransactionId holding) const
+{
+    auto it = edgeTags_.find(edgeKey(waiting, holding));
+    if (it == edgeTags_.end())
+    {
+        return nullptr;
+    }
+    auto epochIt = latestEpoch_.find(it->second.reporterNodeId);
+    if (epochIt == latestEpoch_.end() || it->second.epoch != epochIt->second)
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+std::unordered_map<TransactionId, std::vector<TransactionId>>
+WFGValidator::pruneGraph(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph) const
+{
+    std::unordered_map<TransactionId, std::vector<TransactionId>> prunedGraph;
+    for (const auto &pair : graph)
+    {
+        for (TransactionId target : pair.second)
+        {
+            if (findCurrentTag(pair.first, target))
+            {
+                prunedGraph[pair.first].push_back(target);
+            }
+        }
+    }
+    return prunedGraph;
+}
+
+void WFGValidator::pruneReport(WFGPairs &report) const
+{
+    for (auto &pair : report)
+    {
+        TransactionId waiting = pair.first;
+        auto &holding = pair.second;
+        holding.erase(std::remove_if(holding.begin(), holding.end(),
+                                     [this, waiting](TransactionId target) { return !findCurrentTag(waiting, target); }),
+                      holding.end());
+    }
+    report.erase(std::remove_if(report.begin(), report.end(), [](const auto &pair) { return pair.second.empty(); }),
+                 report.end());
+}
+
+void WFGValidator::dropVictims(WFGPairs &report, const std::unordered_set<Incarnation> &victims) const
+{
+    if (victims.empty())
+    {
+        return;
+    }
+    for (auto &pair : report)
+    {
+        TransactionId waiting = pair.first;
+        auto &holding = pair.second;
+        holding.erase(std::remove_if(holding.begin(), holding.end(),
+                                     [&](TransactionId target) {
+                                         const WFGEdgeTag *tag = findCurrentTag(waiting, target);
+                                         return tag && (victims.count(tag->waitingIncarnation) ||
+                                                        victims.count(tag->holdingIncarnation));
+                                     }),
+                      holding.end());
+    }
+    report.erase(std::remove_if(report.begin(), report.end(), [](const auto &pair) { return pair.second.empty(); }),
+                 report.end());
+}
+
+std::vector<WFGEdgeTag>
+WFGValidator::collectTags(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph) const
+{
+    std::vector<WFGEdgeTag> tags;
+    for (const auto &pair : graph)
+    {
+        for (TransactionId target : pair.second)
+        {
+            if (const WFGEdgeTag *tag = findCurrentTag(pair.first, target))
+            {
+                tags.push_back(*tag);
+            }
+        }
+    }
+    return tags;
+}
+
+bool WFGValidator::isCycleConsistent(const CycleSet &cycles, size_t cycleIndex) const
+{
+    const size_t begin = cycles.offsets[cycleIndex];
+    const size_t end = cycles.offsets[cycleIndex + 1];
+    const WFGEdgeTag *previous = nullptr;
+    const WFGEdgeTag *first = nullptr;
+    for (size_t i = begin; i < end; ++i)
+    {
+        TransactionId waiting = cycles.members[i];
+        TransactionId holding = cycles.members[i + 1 < end ? i + 1 : begin];
+        const WFGEdgeTag *tag = findCurrentTag(waiting, holding);
+        if (!tag)
+        {
+            return false;
+        }
+        if (previous && previous->holdingIncarnation != 0 && tag->waitingIncarnation != 0 &&
+            previous->holdingIncarnation != tag->waitingIncarnation)
+        {
+            return false;
+        }
+        if (!first)
+        {
+            first = tag;
+        }
+        previous = tag;
+    }
+    // Close the cycle: the last edge's holder is the first edge's waiter.
+    return !(previous && previous->holdingIncarnation != 0 && first->waitingIncarnation != 0 &&
+             previous->holdingIncarnation != first->waitingIncarnation);
+}
+
+Incarnation WFGValidator::getCycleMemberIncarnation(const CycleSet &cycles, size_t cycleIndex,
+                                                     TransactionId member) const
+{
+    const size_t begin = cycles.offsets[cycleIndex];
+    const size_t end = cycles.offsets[cycleIndex + 1];
+    for (size_t i = begin; i < end; ++i)
+    {
+        if (cycles.members[i] == member)
+        {
+            const WFGEdgeTag *tag = findCurrentTag(member, cycles.members[i + 1 < end ? i + 1 : begin]);
+            return tag ? tag->waitingIncarnation : 0;
+        }
+    }
+    return 0;
+}
+
+std::vector<NodeId> WFGValidator::getCycleReporters(const CycleSet &cycles, size_t cycleIndex) const
+{
+    const size_t begin = cycles.offsets[cycleIndex];
+    const size_t end = cycles.offsets[cycleIndex + 1];
+    std::vector<NodeId> reporters;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const WFGEdgeTag *tag = findCurrentTag(cycles.members[i], cycles.members[i + 1 < end ? i + 1 : begin]);
+        if (tag && std::find(reporters.begin(), reporters.end(), tag->reporterNodeId) == reporters.end())
+        {
+            reporters.push_back(tag->reporterNodeId);
+        }
+    }
+    return reporters;
+}
+
+void WFGValidator::clearRound()
+{
+    edgeTags_.clear();
+}
@@ -0,0 +1,75 @@
+#ifndef HAWK_WFG_VALIDATOR_H
+#define HAWK_WFG_VALIDATOR_H
+
+#include "commons.h"
+#include "DeadlockDetector.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// WFGValidator guards an aggregating node (central node or zone leader) against phantom
+// deadlocks. Aggregated WFGs are stitched together from reports taken at different times,
+// so a cycle can be closed by an edge that no longer exists, or pass through two different
+// transactions that happen to share a TransactionId. Every reported edge carries a
+// WFGEdgeTag; the validator keeps the newest snapshot epoch seen from each reporter and
+// only accepts cycles whose edges all come from current snapshots and agree on the
+// incarnation of every transaction they share.
+class WFGValidator
+{
+public:
+    WFGValidator() = default;
+
+    // Records the edge tags of one report. Tags from a snapshot older than one already
+    // seen from the same reporter are dropped immediately.
+    void addEdgeTags(const std::vector<WFGEdgeTag> &tags);
+
+    // Returns the subgraph of graph whose edges carry a tag from a current snapshot.
+    // Aggregators use this instead of pruning against their own active transactions,
+    // which never contain transactions homed on other nodes.
+    std::unordered_map<TransactionId, std::vector<TransactionId>>
+    pruneGraph(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph) const;
+
+    // Drops, in place, the edges of one report that carry no tag from a current snapshot.
+    // Zone leaders prune each member's report this way instead of copying a pruned graph.
+    void pruneReport(WFGPairs &report) const;
+
+    // Drops, in place, the edges of one report to or from a lifetime in victims. Their
+    // cycles are already broken, so they need not travel up the tree.
+    void dropVictims(WFGPairs &report, const std::unordered_set<Incarnation> &victims) const;
+
+    // Returns the current tag of edge waiting -> holding, or nullptr if it has none.
+    const WFGEdgeTag *findCurrentTag(TransactionId waiting, TransactionId holding) const;
+
+    // Returns the current tags of all edges in graph, for forwarding to the next tier.
+    std::vector<WFGEdgeTag> collectTags(const std::unordered_map<TransactionId, std::vector<TransactionId>> &graph) const;
+
+    // Checks cycle cycleIndex of cycles: every edge must have a current tag, and adjacent
+    // edges must agree on the incarnation of the transaction between them.
+    bool isCycleConsistent(const CycleSet &cycles, size_t cycleIndex) const;
+
+    // Returns the incarnation of member as reported on its outgoing edge in cycle
+    // cycleIndex, or 0 if unknown. Used to address abort signals to one lifetime.
+    Incarnation getCycleMemberIncarnation(const CycleSet &cycles, size_t cycleIndex, TransactionId member) const;
+
+    // Returns the nodes that reported the edges of cycle cycleIndex, each listed once.
+    std::vector<NodeId> getCycleReporters(const CycleSet &cycles, size_t cycleIndex) const;
+
+    // Forgets this round's tags. Per-reporter epochs are kept so that late replies from
+    // an earlier round are still recognised as stale.
+    void clearRound();
+
+    long long getPhantomCycleCount() const { return phantomCycles_; }
+    void countPhantomCycle() { ++phantomCycles_; }
+
+private:
+    static long long edgeKey(TransactionId waiting, TransactionId holding)
+    {
+        return (static_cast<long long>(waiting) << 32) | static_cast<unsigned int>(holding);
+    }
+
+    std::unordered_map<long long, WFGEdgeTag> edgeTags_;
+    std::unordered_map<NodeId, long long> latestEpoch_;
+    long long phantomCycles_ = 0;
+};
+
+#endif // HAWK_WFG_VALIDATOR_H
@@ -0,0 +1,598 @@
+#include "ZonePartitioner.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace
+{
+// Moves made since the best cut of an FM pass before the pass gives up.
+const int FM_MAX_MOVES_WITHOUT_IMPROVEMENT = 50;
+const int FM_MAX_PASSES = 8;
+const double GAIN_EPSILON = 1e-9;
+// Two vertices are only matched along an edge carrying at least this share of the
+// heaviest edge of either endpoint. Matching along a light edge because the heavy neighbours are already taken glues
+// unrelated groups together in a way refinement under the size bound rarely undoes.
+const double MIN_MATCH_WEIGHT_RATIO = 0.5;
+} // namespace
+
+bool ZonePartitioner::coarsen(Level &fine, Level &coarse, int maxZoneSize)
+{
+    const int n = static_cast<int>(fine.adj.size());
+
+    // Low-degree vertices go first so that they are not left without a partner.
+    std::vector<int> order(n);
+    for (int v = 0; v < n; ++v)
+    {
+        order[v] = v;
+    }
+    std::sort(order.begin(), order.end(), [&fine](int a, int b) {
+        if (fine.adj[a].size() != fine.adj[b].size())
+        {
+            return fine.adj[a].size() < fine.adj[b].size();
+        }
+        return a < b;
+    });
+
+    std::vector<double> heaviest(n, 0.0);
+    for (int v = 0; v < n; ++v)
+    {
+        for (const auto &edge : fine.adj[v])
+        {
+            heaviest[v] = std::max(heaviest[v], edge.second);
+        }
+    }
+
+    fine.coarseOf.assign(n, -1);
+    int coarseCount = 0;
+    for (int u : order)
+    {
+        if (fine.coarseOf[u] != -1)
+        {
+            continue;
+        }
+        int partner = -1;
+        double partnerWeight = 0.0;
+        for (const auto &edge : fine.adj[u])
+        {
+            int v = edge.first;
+            if (edge.second < std::max(heaviest[u], heaviest[v]) * MIN_MATCH_WEIGHT_RATIO || fine.coarseOf[v] != -1 || fine.vertexWeight[u] + fine.vertexWeight[v] > maxZoneSize)
+            {
+                continue;
+            }
+            if (edge.second > partnerWeight || (edge.second == partnerWeight && partner != -1 && v < partner))
+            {
+                partner = v;
+                partnerWeight = edge.second;
+            }
+        }
+        fine.coarseOf[u] = coarseCount;
+        if (partner != -1)
+        {
+            fine.coarseOf[partner] = coarseCount;
+        }
+        coarseCount++;
+    }
+
+    // Stop once a level removes fewer than 5% of the vertices.
+    if ((n - coarseCount) * 20 < n)
+    {
+        return false;
+    }
+
+    coarse.vertexWeight.assign(coarseCount, 0);
+    coarse.adj.assign(coarseCount, {});
+    for (int u = 0; u < n; ++u)
+    {
+        int cu = fine.coarseOf[u];
+        coarse.vertexWeight[cu] += fine.vertexWeight[u];
+        for (const auto &edge : fine.adj[u])
+        {
+            int cv = fine.coarseOf[edge.first];
+            if (cu != cv)
+            {
+                coarse.adj[cu][cv] += edge.second;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<int> ZonePartitioner::initialPartition(const Level &level, int maxZoneSize)
+{
+    const int n = static_cast<int>(level.adj.size());
+    std::vector<int> part(n);
+    std::vector<int> partSize(n);
+    std::vector<std::unordered_map<int, double>> partAdj = level.adj;
+    for (int v = 0; v < n; ++v)
+    {
+        part[v] = v;
+        partSize[v] = level.vertexWeight[v];
+    }
+
+    while (true)
+    {
+        int bestA = -1;
+        int bestB = -1;
+        double bestWeight = 0.0;
+        for (int a = 0; a < n; ++a)
+        {
+            for (const auto &edge : partAdj[a])
+            {
+                int b = edge.first;
+                if (a < b && partSize[a] + partSize[b] <= maxZoneSize && edge.second > bestWeight)
+                {
+                    bestA = a;
+                    bestB = b;
+                    bestWeight = edge.second;
+                }
+            }
+        }
+        if (bestA == -1)
+        {
+            break;
+        }
+
+        // Merge zone bestB into zone bestA.
+        for (const auto &edge : partAdj[bestB])
+        {
+            int c = edge.first;
+            partAdj[c].erase(bestB);
+            if (c != bestA)
+            {
+                partAdj[bestA][c] += edge.second;
+                partAdj[c][bestA] += edge.second;
+            }
+        }
+        partAdj[bestA].erase(bestB);
+        partAdj[bestB].clear();
+        partSize[bestA] += partSize[bestB];
+        partSize[bestB] = 0;
+        for (int v = 0; v < n; ++v)
+        {
+            if (part[v] == bestB)
+            {
+                part[v] = bestA;
+            }
+        }
+    }
+    return part;
+}
+
+void ZonePartitioner::refine(const Level &level, std::vector<int> &part, int maxZoneSize)
+{
+    const int n = static_cast<int>(level.adj.size());
+    std::vector<int> partSize(n, 0);
+    for (int v = 0; v < n; ++v)
+    {
+        partSize[part[v]] += level.vertexWeight[v];
+    }
+
+    // Best single-vertex move per vertex: target zone (-1 if none fits) and cut reduction.
+    std::vector<int> bestTarget(n);
+    std::vector<double> bestMoveGain(n);
+    // Edge weight from the vertex being scored into each zone; zones are vertex indices, so
+    // a flat array reset through the list of touched zones is enough.
+    std::vector<double> connection(n, 0.0);
+    std::vector<int> touched;
+    auto updateBestMove = [&](int v) {
+        for (const auto &edge : level.adj[v])
+        {
+            int zone = part[edge.first];
+            if (connection[zone] == 0.0)
+            {
+                touched.push_back(zone);
+            }
+            connection[zone] += edge.second;
+        }
+        const double internal = connection[part[v]];
+        bestTarget[v] = -1;
+        bestMoveGain[v] = -std::numeric_limits<double>::infinity();
+        for (int zone : touched)
+        {
+            if (zone != part[v] && partSize[zone] + level.vertexWeight[v] <= maxZoneSize &&
+                connection[zone] - internal > bestMoveGain[v])
+            {
+                bestTarget[v] = zone;
+                bestMoveGain[v] = connection[zone] - internal;
+            }
+            connection[zone] = 0.0;
+        }
+        touched.clear();
+    };
+
+    for (int pass = 0; pass < FM_MAX_PASSES; ++pass)
+    {
+        std::vector<bool> locked(n, false);
+        std::vector<std::pair<int, int>> moves; // (vertex, zone it came from)
+        double cumulativeGain = 0.0;
+        double bestGain = 0.0;
+        size_t bestMoveCount = 0;
+        for (int v = 0; v < n; ++v)
+        {
+            updateBestMove(v);
+        }
+
+        while (moves.size() - bestMoveCount < static_cast<size_t>(FM_MAX_MOVES_WITHOUT_IMPROVEMENT))
+        {
+            // Gains are kept current for the neighbours of every moved vertex; a cached
+            // target that has since filled up is recomputed before it is used.
+            int moveVertex = -1;
+            while (true)
+            {
+                moveVertex = -1;
+                for (int v = 0; v < n; ++v)
+                {
+                    if (!locked[v] && bestTarget[v] != -1 &&
+                        (moveVertex == -1 || bestMoveGain[v] > bestMoveGain[moveVertex]))
+                    {
+                        moveVertex = v;
+                    }
+                }
+                if (moveVertex == -1 ||
+                    partSize[bestTarget[moveVertex]] + level.vertexWeight[moveVertex] <= maxZoneSize)
+                {
+                    break;
+                }
+                updateBestMove(moveVertex);
+            }
+            if (moveVertex == -1)
+            {
+                break;
+            }
+            const int moveTarget = bestTarget[moveVertex];
+            const double moveGain = bestMoveGain[moveVertex];
+
+            moves.push_back({moveVertex, part[moveVertex]});
+            partSize[part[moveVertex]] -= level.vertexWeight[moveVertex];
+            partSize[moveTarget] += level.vertexWeight[moveVertex];
+            part[moveVertex] = moveTarget;
+            locked[moveVertex] = true;
+            for (const auto &edge : level.adj[moveVertex])
+            {
+                if (!locked[edge.first])
+                {
+                    updateBestMove(edge.first);
+                }
+            }
+            cumulativeGain += moveGain;
+            if (cumulativeGain > bestGain + GAIN_EPSILON)
+            {
+                bestGain = cumulativeGain;
+                bestMoveCount = moves.size();
+            }
+        }
+
+        // Undo the moves made after the best cut of this pass.
+        while (moves.size() > bestMoveCount)
+        {
+            int v = moves.back().first;
+            int from = moves.back().second;
+            partSize[part[v]] -= level.vertexWeight[v];
+            partSize[from] += level.vertexWeight[v];
+            part[v] = from;
+            moves.pop_back();
+        }
+        if (bestGain <= GAIN_EPSILON)
+        {
+            break;
+        }
+    }
+}
+
+std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>>
+ZonePartitioner::partition(const WeightedPAG &weightedPag, int maxZoneSize, double minEdgeWeight)
+{
+    std::vector<NodeId> nodes;
+    std::unordered_map<NodeId, int> index;
+    auto intern = [&nodes, &index](NodeId node) {
+        auto it = index.find(node);
+        if (it != index.end())
+        {
+            return it->second;
+        }
+        index[node] = static_cast<int>(nodes.size());
+        nodes.push_back(node);
+        return static_cast<int>(nodes.size()) - 1;
+    };
+
+    // The zone partition only cares how strongly two nodes depend on each other, not in
+    // which direction, so the finest level is the symmetrised PAG.
+    std::vector<Level> levels(1);
+    for (const auto &pair : weightedPag)
+    {
+        for (const auto &neighbor : pair.second)
+        {
+            if (neighbor.second < minEdgeWeight || neighbor.first == pair.first)
+            {
+                continue;
+            }
+            int a = intern(pair.first);
+            int b = intern(neighbor.first);
+            if (levels[0].adj.size() < nodes.size())
+            {
+                levels[0].adj.resize(nodes.size());
+            }
+            levels[0].adj[a][b] += neighbor.second;
+            levels[0].adj[b][a] += neighbor.second;
+        }
+    }
+    if (nodes.empty())
+    {
+        return {};
+    }
+    levels[0].vertexWeight.assign(nodes.size(), 1);
+
+    while (levels.back().adj.size() > 1)
+    {
+        Level coarse;
+        if (!coarsen(levels.back(), coarse, maxZoneSize))
+        {
+            break;
+        }
+        levels.push_back(std::move(coarse));
+    }
+
+    std::vector<int> part = initialPartition(levels.back(), maxZoneSize);
+    refine(levels.back(), part, maxZoneSize);
+    for (int l = static_cast<int>(levels.size()) - 2; l >= 0; --l)
+    {
+        std::vector<int> finerPart(levels[l].adj.size());
+        for (size_t v = 0; v < finerPart.size(); ++v)
+        {
+            finerPart[v] = part[levels[l].coarseOf[v]];
+        }
+        part = std::move(finerPart);
+        refine(levels[l], part, maxZoneSize);
+    }
+
+    std::unordered_map<int, std::vector<NodeId>> membersByPart;
+    for (size_t v = 0; v < nodes.size(); ++v)
+    {
+        membersByPart[part[v]].push_back(nodes[v]);
+    }
+    std::vector<std::vector<NodeId>> zones;
+    for (auto &pair : membersByPart)
+    {
+        std::sort(pair.second.begin(), pair.second.end());
+        zones.push_back(std::move(pair.second));
+    }
+    std::sort(zones.begin(), zones.end());
+
+    std::vector<NodeId> leaders;
+    for (const auto &zone : zones)
+    {
+        leaders.push_back(zone.front());
+    }
+    std::cout << "ZonePartitioner: " << nodes.size() << " nodes in " << zones.size() << " zones of at most "
+              << maxZoneSize << " nodes (" << levels.size() << " levels, cut weight "
+              << cutWeight(weightedPag, zones) << ").\n";
+    return {zones, leaders};
+}
+
+void ZonePartitioner::buildHierarchy(const WeightedPAG &weightedPag, std::vector<std::vector<NodeId>> &zones,
+                                     std::vector<NodeId> &leaders, std::vector<int> &levels, int fanout,
+                                     const std::function<NodeId(const std::vector<NodeId> &, int)> &chooseLeader)
+{
+    if (fanout < 2)
+    {
+        return;
+    }
+
+    // Every node is represented by the leader of the zone it ends up in on the current tier.
+    std::unordered_map<NodeId, NodeId> representative;
+    std::vector<NodeId> tierLeaders;
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        for (NodeId node : zones[z])
+        {
+            representative[node] = leaders[z];
+        }
+        tierLeaders.push_back(leaders[z]);
+    }
+
+    for (int level = 1; tierLeaders.size() > static_cast<size_t>(fanout); ++level)
+    {
+        WeightedPAG leaderPag;
+        for (const auto &pair : weightedPag)
+        {
+            auto from = representative.find(pair.first);
+            for (const auto &neighbor : pair.second)
+            {
+                auto to = representative.find(neighbor.first);
+                if (from != representative.end() && to != representative.end() && from->second != to->second)
+                {
+                    leaderPag[from->second][to->second] += neighbor.second;
+                }
+            }
+        }
+
+        auto grouped = partition(leaderPag, fanout, 0.0);
+        std::vector<std::vector<NodeId>> groups = std::move(grouped.first);
+        std::vector<NodeId> groupLeaders = std::move(grouped.second);
+        std::unordered_map<NodeId, bool> placed;
+        for (const auto &group : groups)
+        {
+            for (NodeId leader : group)
+            {
+                placed[leader] = true;
+            }
+        }
+        std::vector<NodeId> unplaced;
+        for (NodeId leader : tierLeaders)
+        {
+            if (!placed.count(leader))
+            {
+                unplaced.push_back(leader);
+            }
+        }
+        std::sort(unplaced.begin(), unplaced.end());
+        for (size_t i = 0; i < unplaced.size(); i += fanout)
+        {
+            groups.emplace_back(unplaced.begin() + i, unplaced.begin() + std::min(unplaced.size(), i + fanout));
+            groupLeaders.push_back(groups.back().front());
+        }
+        if (groups.size() >= tierLeaders.size())
+        {
+            break;
+        }
+        for (size_t g = 0; g < groups.size() && chooseLeader; ++g)
+        {
+            if (groups[g].size() > 1)
+            {
+                groupLeaders[g] = chooseLeader(groups[g], level);
+            }
+        }
+
+        std::unordered_map<NodeId, NodeId> groupLeaderOf;
+        tierLeaders.clear();
+        for (size_t g = 0; g < groups.size(); ++g)
+        {
+            for (NodeId leader : groups[g])
+            {
+                groupLeaderOf[leader] = groupLeaders[g];
+            }
+            tierLeaders.push_back(groupLeaders[g]);
+            // A zone of one leader would only relay its member's report to itself.
+            if (groups[g].size() > 1)
+            {
+                zones.push_back(groups[g]);
+                leaders.push_back(groupLeaders[g]);
+                levels.push_back(level);
+            }
+        }
+        for (auto &pair : representative)
+        {
+            pair.second = groupLeaderOf[pair.second];
+        }
+    }
+    std::cout << "ZonePartitioner: detection tree has " << (levels.empty() ? 0 : levels.back()) + 1
+              << " tiers below the central node.\n";
+}
+
+int ZonePartitioner::repartition(const WeightedPAG &weightedPag, std::vector<std::vector<NodeId>> &zones,
+                                 std::vector<NodeId> &leaders, int maxZoneSize, double minGain, double minEdgeWeight)
+{
+    std::unordered_map<NodeId, std::unordered_map<NodeId, double>> adj;
+    for (const auto &pair : weightedPag)
+    {
+        for (const auto &neighbor : pair.second)
+        {
+            if (neighbor.second < minEdgeWeight || neighbor.first == pair.first)
+            {
+                continue;
+            }
+            adj[pair.first][neighbor.first] += neighbor.second;
+            adj[neighbor.first][pair.first] += neighbor.second;
+        }
+    }
+
+    std::unordered_map<NodeId, int> zoneOf;
+    std::vector<int> zoneSize(zones.size());
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        for (NodeId node : zones[z])
+        {
+            zoneOf[node] = static_cast<int>(z);
+        }
+        zoneSize[z] = static_cast<int>(zones[z].size());
+    }
+    std::vector<NodeId> nodes;
+    for (const auto &pair : adj)
+    {
+        nodes.push_back(pair.first);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    for (NodeId node : nodes)
+    {
+        if (!zoneOf.count(node))
+        {
+            zoneOf[node] = static_cast<int>(zoneSize.size());
+            zoneSize.push_back(1);
+        }
+    }
+
+    int moved = 0;
+    std::unordered_map<int, double> affinity;
+    for (NodeId node : nodes)
+    {
+        affinity.clear();
+        double total = 0.0;
+        for (const auto &neighbor : adj[node])
+        {
+            affinity[zoneOf[neighbor.first]] += neighbor.second;
+            total += neighbor.second;
+        }
+        int own = zoneOf[node];
+        int target = own;
+        double targetAffinity = affinity[own];
+        for (const auto &candidate : affinity)
+        {
+            if (candidate.first == own || zoneSize[candidate.first] >= maxZoneSize)
+            {
+                continue;
+            }
+            if (candidate.second > targetAffinity || (candidate.second == targetAffinity && candidate.first < target))
+            {
+                target = candidate.first;
+                targetAffinity = candidate.second;
+            }
+        }
+        if (target != own && targetAffinity - affinity[own] > minGain * total + GAIN_EPSILON)
+        {
+            zoneSize[own]--;
+            zoneSize[target]++;
+            zoneOf[node] = target;
+            moved++;
+        }
+    }
+
+    std::vector<std::vector<NodeId>> members(zoneSize.size());
+    for (const auto &pair : zoneOf)
+    {
+        members[pair.second].push_back(pair.first);
+    }
+    std::vector<std::vector<NodeId>> newZones;
+    std::vector<NodeId> newLeaders;
+    for (size_t z = 0; z < members.size(); ++z)
+    {
+        if (members[z].empty())
+        {
+            continue;
+        }
+        std::sort(members[z].begin(), members[z].end());
+        bool leaderStayed = z < leaders.size() && std::binary_search(members[z].begin(), members[z].end(), leaders[z]);
+        newLeaders.push_back(leaderStayed ? leaders[z] : members[z].front());
+        newZones.push_back(std::move(members[z]));
+    }
+    zones = std::move(newZones);
+    leaders = std::move(newLeaders);
+    std::cout << "ZonePartitioner: moved " << moved << " of " << zoneOf.size() << " nodes, " << zones.size()
+              << " zones (cut weight " << cutWeight(weightedPag, zones) << ").\n";
+    return moved;
+}
+
+double ZonePartitioner::cutWeight(const WeightedPAG &weightedPag, const std::vector<std::vector<NodeId>> &zones)
+{
+    std::unordered_map<NodeId, int> zoneOf;
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        for (NodeId node : zones[z])
+        {
+            zoneOf[node] = static_cast<int>(z);
+        }
+    }
+    double cut = 0.0;
+    for (const auto &pair : weightedPag)
+    {
+        auto from = zoneOf.find(pair.first);
+        for (const auto &neighbor : pair.second)
+        {
+            auto to = zoneOf.find(neighbor.first);
+            if (from == zoneOf.end() || to == zoneOf.end() || from->second != to->second)
+            {
+                cut += neighbor.second;
+            }
+        }
+    }
+    return cut;
+}
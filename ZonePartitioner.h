@@ -0,0 +1,75 @@
+#ifndef HAWK_ZONE_PARTITIONER_H
+#define HAWK_ZONE_PARTITIONER_H
+
+#include "commons.h"
+#include "PAGManager.h"
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+// ZonePartitioner is the alternative to PAGManager::greedySCCcut for forming HAWK
+// detection zones. Instead of keeping whole SCCs, which under skewed load can grow into
+// one zone spanning most of the cluster, it splits the weighted PAG into zones of at most
+// maxZoneSize nodes while keeping as much dependency weight as possible inside zones.
+// It is a multilevel scheme: the PAG is made undirected and coarsened by heavy-edge
+// matching, the coarsest graph is merged greedily into zones, and the partition is
+// refined with Fiduccia-Mattheyses passes while it is projected back to the nodes.
+// Nodes without any PAG edge of at least minEdgeWeight are not placed in a zone; callers
+// cover them with PAGManager::addSingletonZones.
+class ZonePartitioner
+{
+public:
+    ZonePartitioner() = default;
+
+    // Returns the zones and their leaders (the lowest member of each zone).
+    std::pair<std::vector<std::vector<NodeId>>, std::vector<NodeId>>
+    partition(const WeightedPAG &weightedPag, int maxZoneSize, double minEdgeWeight = PAG_MIN_EDGE_WEIGHT);
+
+    // Updates existing tier-0 zones in place instead of partitioning from scratch. A node
+    // moves to another zone only if its PAG weight towards that zone exceeds the weight
+    // towards its own by more than minGain of its total weight and the zone has room; each
+    // node moves at most once per call, so membership churn stays proportional to how much
+    // the PAG changed. PAG nodes without a zone start as singletons, emptied zones are
+    // dropped and a zone keeps its leader while the leader stays in it. Returns the number
+    // of nodes moved.
+    int repartition(const WeightedPAG &weightedPag, std::vector<std::vector<NodeId>> &zones, std::vector<NodeId> &leaders,
+                    int maxZoneSize, double minGain, double minEdgeWeight = PAG_MIN_EDGE_WEIGHT);
+
+    // Total weight of the PAG edges whose endpoints are in different zones (or not in
+    // any zone). This is the dependency weight that has to be escalated past zone leaders.
+    static double cutWeight(const WeightedPAG &weightedPag, const std::vector<std::vector<NodeId>> &zones);
+
+    // Extends a tier-0 zone table (levels all 0) into a detection tree of any depth. The
+    // leaders of each tier are partitioned again on the PAG between their zones, into zones
+    // of at most `fanout` leaders, until no more than `fanout` leaders are left to report
+    // to the central node. Leaders without any dependency on another zone are grouped by
+    // id only to bound the fan-in. New zones are appended with their tier in `levels`.
+    // chooseLeader(members, tier) picks the leader of each new zone; by default it is the
+    // lowest member.
+    void buildHierarchy(const WeightedPAG &weightedPag, std::vector<std::vector<NodeId>> &zones,
+                        std::vector<NodeId> &leaders, std::vector<int> &levels, int fanout,
+                        const std::function<NodeId(const std::vector<NodeId> &, int)> &chooseLeader = nullptr);
+
+private:
+    // One level of the multilevel hierarchy, on dense vertex indices.
+    struct Level
+    {
+        std::vector<int> vertexWeight;                   // number of PAG nodes merged into the vertex
+        std::vector<std::unordered_map<int, double>> adj; // symmetric edge weights
+        std::vector<int> coarseOf;                       // vertex on the next coarser level
+    };
+
+    // Matches vertices of fine along their heaviest edges and fills coarse with the
+    // contracted graph. Returns false if matching no longer shrinks the graph noticeably.
+    static bool coarsen(Level &fine, Level &coarse, int maxZoneSize);
+
+    // Starts from one zone per vertex and merges the most strongly connected pairs of
+    // zones while they fit in maxZoneSize.
+    static std::vector<int> initialPartition(const Level &level, int maxZoneSize);
+
+    // Runs FM passes that move single vertices between zones, keeping the best prefix of
+    // each pass, until a pass no longer reduces the cut.
+    static void refine(const Level &level, std::vector<int> &part, int maxZoneSize);
+};
+
+#endif // HAWK_ZONE_PARTITIONER_H
@@ -0,0 +1,208 @@
+#include "ZonePlanner.h"
+#include "ZonePartitioner.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+// Planning runs the same code as the central node, which reports every cut; keep the
+// replay output to the result lines.
+class ScopedSilence
+{
+public:
+    ScopedSilence() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+    ~ScopedSilence() { std::cout.rdbuf(saved_); }
+
+private:
+    std::ostringstream sink_;
+    std::streambuf *saved_;
+};
+} // namespace
+
+ZonePlanner::ZonePlanner(int numNodes) : numNodes_(numNodes) {}
+
+bool ZonePlanner::parseStrategy(const std::string &text, Strategy &strategy)
+{
+    size_t colon = text.find(':');
+    if (colon == std::string::npos)
+    {
+        return false;
+    }
+    std::string kind = text.substr(0, colon);
+    try
+    {
+        strategy.parameter = std::stoi(text.substr(colon + 1));
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    if (strategy.parameter < 1)
+    {
+        return false;
+    }
+    strategy.name = text;
+    strategy.incremental = kind == "incremental";
+    if (kind == "scc")
+    {
+        strategy.mode = ZONES_GREEDY_SCC_CUT;
+    }
+    else if (kind == "balanced" || kind == "incremental")
+    {
+        strategy.mode = ZONES_BALANCED;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+ZonePlanner::Result ZonePlanner::replay(const std::vector<PAGTraceRound> &rounds, const Strategy &strategy)
+{
+    Result result;
+    PAGManager pagManager;
+    ZonePartitioner partitioner;
+    std::vector<std::vector<NodeId>> zones;
+    std::vector<NodeId> leaders;
+    // Until the first plan every node is its own zone, as on a cluster without a tree.
+    std::vector<int> zoneOf(numNodes_ + 1);
+    for (int node = 0; node <= numNodes_; ++node)
+    {
+        zoneOf[node] = node;
+    }
+
+    for (const PAGTraceRound &round : rounds)
+    {
+        judgeRound(round, zoneOf, result);
+
+        WeightedPAG roundCounts;
+        for (const PAGPairCount &pair : round.waits)
+        {
+            roundCounts[pair.waitingNodeId][pair.holdingNodeId] += pair.count;
+        }
+        for (const PAGPairCount &pair : round.predicted)
+        {
+            roundCounts[pair.waitingNodeId][pair.holdingNodeId] += PREDICTED_PAG_WEIGHT * pair.count;
+        }
+
+        ScopedSilence silence;
+        auto start = std::chrono::steady_clock::now();
+        pagManager.accumulateSample(roundCounts);
+        const WeightedPAG &weightedPag = pagManager.getWeightedPAG();
+        if (strategy.mode == ZONES_GREEDY_SCC_CUT)
+        {
+            auto cut = pagManager.greedySCCcut(weightedPag, strategy.parameter);
+            zones = std::move(cut.first);
+            leaders = std::move(cut.second);
+        }
+        else if (strategy.incremental && result.rounds > 0)
+        {
+            partitioner.repartition(weightedPag, zones, leaders, strategy.parameter, ZONE_MOVE_MIN_GAIN);
+        }
+        else
+        {
+            auto cut = partitioner.partition(weightedPag, strategy.parameter);
+            zones = std::move(cut.first);
+            leaders = std::move(cut.second);
+        }
+        PAGManager::addSingletonZones(zones, leaders, numNodes_);
+        result.planMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (size_t z = 0; z < zones.size(); ++z)
+        {
+            result.maxZoneSize = std::max(result.maxZoneSize, zones[z].size());
+            for (NodeId member : zones[z])
+            {
+                if (member >= 0 && member <= numNodes_)
+                {
+                    zoneOf[member] = static_cast<int>(z);
+                }
+            }
+        }
+        result.rounds++;
+    }
+    result.zones = zones.size();
+    return result;
+}
+
+void ZonePlanner::judgeRound(const PAGTraceRound &round, const std::vector<int> &zoneOf, Result &result)
+{
+    PAG waits;
+    for (const PAGPairCount &pair : round.waits)
+    {
+        if (pair.count > 0)
+        {
+            waits[pair.waitingNodeId].push_back(pair.holdingNodeId);
+        }
+    }
+    if (waits.empty())
+    {
+        return;
+    }
+
+    std::vector<std::vector<NodeId>> sets;
+    {
+        ScopedSilence silence;
+        sets = sccFinder_.greedySCCcut(waits, 2).first;
+    }
+    auto zoneOfNode = [&](NodeId node) { return node >= 0 && node <= numNodes_ ? zoneOf[node] : -1 - node; };
+    std::vector<int> setOf(numNodes_ + 1, -1);
+    for (size_t s = 0; s < sets.size(); ++s)
+    {
+        if (sets[s].size() < 2)
+        {
+            continue;
+        }
+        bool oneZone = true;
+        for (NodeId member : sets[s])
+        {
+            oneZone = oneZone && zoneOfNode(member) == zoneOfNode(sets[s].front());
+            if (member >= 0 && member <= numNodes_)
+            {
+                setOf[member] = static_cast<int>(s);
+            }
+        }
+        (oneZone ? result.caughtCycles : result.escalatedCycles)++;
+    }
+
+    for (const PAGPairCount &pair : round.waits)
+    {
+        NodeId from = pair.waitingNodeId;
+        NodeId to = pair.holdingNodeId;
+        if (from < 0 || from > numNodes_ || to < 0 || to > numNodes_ || setOf[from] < 0 || setOf[from] != setOf[to])
+        {
+            continue;
+        }
+        result.cyclicWaits += pair.count;
+        if (zoneOf[from] == zoneOf[to])
+        {
+            result.caughtWaits += pair.count;
+        }
+    }
+}
+
+int ZonePlanner::run(const std::vector<PAGTraceRound> &rounds, const std::vector<Strategy> &strategies)
+{
+    std::cout << std::left << std::setw(18) << "strategy" << std::right << std::setw(8) << "rounds" << std::setw(10)
+              << "caught" << std::setw(11) << "escalated" << std::setw(10) << "caught%" << std::setw(15)
+              << "in-zone wait%" << std::setw(8) << "zones" << std::setw(10) << "max zone" << std::setw(12)
+              << "plan ms" << "\n";
+    for (const Strategy &strategy : strategies)
+    {
+        Result result = replay(rounds, strategy);
+        long long cycles = result.caughtCycles + result.escalatedCycles;
+        double caughtShare = cycles > 0 ? 100.0 * result.caughtCycles / cycles : 0.0;
+        double waitShare = result.cyclicWaits > 0 ? 100.0 * result.caughtWaits / result.cyclicWaits : 0.0;
+        std::cout << std::left << std::setw(18) << strategy.name << std::right << std::setw(8) << result.rounds
+                  << std::setw(10) << result.caughtCycles << std::setw(11) << result.escalatedCycles << std::fixed
+                  << std::setprecision(1) << std::setw(10) << caughtShare << std::setw(15) << waitShare << std::setw(8)
+                  << result.zones << std::setw(10) << result.maxZoneSize << std::setprecision(3) << std::setw(12)
+                  << result.planMs << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+    return static_cast<int>(strategies.size());
+}
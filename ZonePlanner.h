@@ -0,0 +1,60 @@
+#ifndef HAWK_ZONE_PLANNER_H
+#define HAWK_ZONE_PLANNER_H
+
+#include "commons.h"
+#include "PAGManager.h"
+#include "PAGTrace.h"
+#include <vector>
+#include <string>
+
+// ZonePlanner replays a recorded PAG trace (PAGTrace) through a zone partitioning strategy,
+// so SCC_CUT_THRESHOLD and the partitioners can be compared without running the cluster.
+// Each round's waits are first judged against the zones planned from the rounds before
+// it, as the live system would have had them, then folded into the decayed PAG and the
+// zones are planned again. A strongly connected set of nodes in a round's wait graph
+// stands for the deadlock cycles that round could form: it is caught if one zone holds
+// all of it and escalated otherwise. Zones are replanned every round, so the figures are
+// what the strategy can do at best, not what the adjustment triggers would have allowed.
+class ZonePlanner
+{
+public:
+    struct Strategy
+    {
+        std::string name;
+        ZonePartitioningMode mode = ZONES_GREEDY_SCC_CUT;
+        int parameter = SCC_CUT_THRESHOLD; // SCC threshold, or maximum zone size
+        bool incremental = false;          // repartition the previous zones after the first round
+    };
+
+    struct Result
+    {
+        int rounds = 0;
+        long long caughtCycles = 0;
+        long long escalatedCycles = 0;
+        long long cyclicWaits = 0; // waits on edges inside a strongly connected set
+        long long caughtWaits = 0; // those of them between members of one zone
+        size_t zones = 0;          // after the last round
+        size_t maxZoneSize = 0;    // over all rounds
+        double planMs = 0.0;       // total planning time
+    };
+
+    explicit ZonePlanner(int numNodes);
+
+    // Parses "scc:<threshold>", "balanced:<max zone size>" or "incremental:<max zone size>".
+    static bool parseStrategy(const std::string &text, Strategy &strategy);
+
+    Result replay(const std::vector<PAGTraceRound> &rounds, const Strategy &strategy);
+
+    // Replays every strategy and prints one line per strategy. Returns the number of
+    // strategies replayed.
+    int run(const std::vector<PAGTraceRound> &rounds, const std::vector<Strategy> &strategies);
+
+private:
+    // Adds this round's cycles to result, judged against zoneOf (node -> zone index).
+    void judgeRound(const PAGTraceRound &round, const std::vector<int> &zoneOf, Result &result);
+
+    int numNodes_;
+    PAGManager sccFinder_; // finds the strongly connected sets of each round
+};
+
+#endif // HAWK_ZONE_PLANNER_H
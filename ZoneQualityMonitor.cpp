@@ -0,0 +1,176 @@
+#include "ZoneQualityMonitor.h"
+#include <algorithm>
+#include <iostream>
+
+void ZoneQualityMonitor::setTree(const std::vector<std::vector<NodeId>> &zones, const std::vector<NodeId> &leaders,
+                                 const std::vector<int> &levels, const WeightedPAG &weightedPag)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    zoneOf_.clear();
+    for (size_t z = 0; z < zones.size(); ++z)
+    {
+        if (z < levels.size() && levels[z] != 0)
+        {
+            continue;
+        }
+        for (NodeId member : zones[z])
+        {
+            zoneOf_[member] = leaders[z];
+        }
+    }
+    builtCutShare_ = cutShare(weightedPag);
+}
+
+void ZoneQualityMonitor::recordZoneStats(const std::vector<ZoneReportStats> &stats)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (const ZoneReportStats &zone : stats)
+    {
+        ZoneCounters &counters = zones_[{zone.level, zone.leaderId}];
+        counters.cycles += zone.cyclesDetected;
+        counters.detectionTimeUs += zone.detectionTimeUs;
+        counters.reportEdges += zone.reportEdges;
+        counters.residualEdges += zone.residualEdges;
+        counters.rounds++;
+    }
+}
+
+void ZoneQualityMonitor::recordEscapedCycle(const std::vector<NodeId> &reporters)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    escapedCycles_++;
+    std::vector<NodeId> charged;
+    for (NodeId reporter : reporters)
+    {
+        // Before the first tree every node is its own zone.
+        auto it = zoneOf_.find(reporter);
+        NodeId leader = it != zoneOf_.end() ? it->second : reporter;
+        if (std::find(charged.begin(), charged.end(), leader) == charged.end())
+        {
+            charged.push_back(leader);
+            zones_[{0, leader}].escaped++;
+        }
+    }
+}
+
+ZoneQualityMonitor::Summary ZoneQualityMonitor::closeInterval(const WeightedPAG &weightedPag)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    Summary summary;
+    summary.escapedCycles = escapedCycles_;
+    summary.cutShare = cutShare(weightedPag);
+    summary.builtCutShare = builtCutShare_;
+
+    std::unordered_map<NodeId, long long> leaderTimeUs; // a leader may lead several tiers
+    long long rounds = 0;
+    long long reportEdges = 0;
+    long long residualEdges = 0;
+    for (const auto &entry : zones_)
+    {
+        const ZoneCounters &counters = entry.second;
+        summary.zoneCycles += counters.cycles;
+        rounds += counters.rounds;
+        reportEdges += counters.reportEdges;
+        residualEdges += counters.residualEdges;
+        if (counters.rounds > 0)
+        {
+            leaderTimeUs[entry.first.second] += counters.detectionTimeUs;
+        }
+    }
+    long long totalCycles = summary.zoneCycles + summary.escapedCycles;
+    summary.escapedShare = totalCycles > 0 ? static_cast<double>(summary.escapedCycles) / totalCycles : 0.0;
+    if (rounds > 0)
+    {
+        summary.meanReportEdges = static_cast<double>(reportEdges) / rounds;
+        summary.meanResidualEdges = static_cast<double>(residualEdges) / rounds;
+    }
+    long long totalLeaderTimeUs = 0;
+    for (const auto &leader : leaderTimeUs)
+    {
+        totalLeaderTimeUs += leader.second;
+        if (leader.second > summary.busiestLeaderTimeUs)
+        {
+            summary.busiestLeader = leader.first;
+            summary.busiestLeaderTimeUs = leader.second;
+        }
+    }
+    if (!leaderTimeUs.empty())
+    {
+        summary.meanLeaderTimeUs = static_cast<double>(totalLeaderTimeUs) / leaderTimeUs.size();
+    }
+
+    std::cout << "ZoneQualityMonitor: " << summary.zoneCycles << " cycles resolved in zones, " << summary.escapedCycles
+              << " escaped to the central node (" << summary.escapedShare * 100 << "%), PAG cut " << summary.cutShare * 100
+              << "% (" << summary.builtCutShare * 100 << "% when built), busiest leader " << summary.busiestLeader << " "
+              << summary.busiestLeaderTimeUs << " us (mean " << summary.meanLeaderTimeUs << " us), "
+              << summary.meanReportEdges << " edges in / " << summary.meanResidualEdges << " out per leader round.\n";
+
+    // The zones that let the most cycles through are where the partition is worst.
+    const size_t REPORTED_ZONES = 5;
+    std::vector<std::pair<std::pair<int, NodeId>, ZoneCounters>> leaky;
+    for (const auto &entry : zones_)
+    {
+        if (entry.second.escaped > 0)
+        {
+            leaky.push_back(entry);
+        }
+    }
+    std::sort(leaky.begin(), leaky.end(),
+              [](const auto &a, const auto &b) { return a.second.escaped > b.second.escaped; });
+    for (size_t i = 0; i < leaky.size() && i < REPORTED_ZONES; ++i)
+    {
+        const ZoneCounters &counters = leaky[i].second;
+        std::cout << "ZoneQualityMonitor:   zone of leader " << leaky[i].first.second << ": " << counters.cycles
+                  << " resolved, " << counters.escaped << " escaped, " << counters.detectionTimeUs << " us in "
+                  << counters.rounds << " rounds.\n";
+    }
+
+    zones_.clear();
+    escapedCycles_ = 0;
+    return summary;
+}
+
+bool ZoneQualityMonitor::shouldAdjust(const Summary &summary, std::string &reason)
+{
+    if (summary.escapedShare > ZONE_MAX_ESCAPED_SHARE)
+    {
+        reason = "most cycles escaped the zones";
+        return true;
+    }
+    if (summary.cutShare - summary.builtCutShare > ZONE_MAX_CUT_DRIFT)
+    {
+        reason = "the zones cut much more of the PAG than when they were built";
+        return true;
+    }
+    if (summary.busiestLeaderTimeUs >= ZONE_LEADER_MIN_DETECTION_US &&
+        summary.busiestLeaderTimeUs > ZONE_LEADER_OVERLOAD * summary.meanLeaderTimeUs)
+    {
+        reason = "leader " + std::to_string(summary.busiestLeader) + " is overloaded";
+        return true;
+    }
+    reason = summary.zoneCycles + summary.escapedCycles > 0 ? "zones hold their cycles" : "no deadlocks";
+    return false;
+}
+
+double ZoneQualityMonitor::cutShare(const WeightedPAG &weightedPag) const
+{
+    double total = 0.0;
+    double cut = 0.0;
+    auto zoneOf = [this](NodeId node) {
+        auto it = zoneOf_.find(node);
+        return it != zoneOf_.end() ? it->second : node;
+    };
+    for (const auto &from : weightedPag)
+    {
+        NodeId fromZone = zoneOf(from.first);
+        for (const auto &to : from.second)
+        {
+            total += to.second;
+            if (zoneOf(to.first) != fromZone)
+            {
+                cut += to.second;
+            }
+        }
+    }
+    return total > 0.0 ? cut / total : 0.0;
+}
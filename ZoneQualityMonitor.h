@@ -0,0 +1,75 @@
+#ifndef HAWK_ZONE_QUALITY_MONITOR_H
+#define HAWK_ZONE_QUALITY_MONITOR_H
+
+#include "commons.h"
+#include "PAGManager.h"
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <mutex>
+#include <string>
+
+// ZoneQualityMonitor shows, on the central node, how well the detection zones in place fit
+// the workload, and decides from that when the tree is rebuilt. Per zone it adds up the
+// cycles its leader resolved, the cycles that escaped it (resolved by the central node on
+// edges reported by one of its members), the leader's detection time, and the WFG edges
+// the leader aggregated and forwarded. Per tree it keeps the share of PAG weight its
+// tier-0 zones cut when it was built, to tell when the workload has drifted away from it.
+class ZoneQualityMonitor
+{
+public:
+    // Figures of one interval, over all zones.
+    struct Summary
+    {
+        long long zoneCycles = 0;    // resolved by some zone leader, on any tier
+        long long escapedCycles = 0; // resolved only by the central node
+        double escapedShare = 0.0;   // escapedCycles / (zoneCycles + escapedCycles)
+        double cutShare = 0.0;       // PAG weight between tier-0 zones / total, now
+        double builtCutShare = 0.0;  // the same when the tree was built
+        NodeId busiestLeader = 0;
+        long long busiestLeaderTimeUs = 0;
+        double meanLeaderTimeUs = 0.0;
+        double meanReportEdges = 0.0;   // per leader round
+        double meanResidualEdges = 0.0; // per leader round
+    };
+
+    ZoneQualityMonitor() = default;
+
+    // Records a new detection tree and the PAG it was built from.
+    void setTree(const std::vector<std::vector<NodeId>> &zones, const std::vector<NodeId> &leaders,
+                 const std::vector<int> &levels, const WeightedPAG &weightedPag);
+
+    void recordZoneStats(const std::vector<ZoneReportStats> &stats);
+
+    // Counts a cycle the central node resolved against every tier-0 zone of its reporters.
+    void recordEscapedCycle(const std::vector<NodeId> &reporters);
+
+    // Summarises the interval against the current PAG, prints it with the zones that let
+    // the most cycles escape, and starts a new interval.
+    Summary closeInterval(const WeightedPAG &weightedPag);
+
+    // Whether the tree should be rebuilt; reason explains the answer either way.
+    static bool shouldAdjust(const Summary &summary, std::string &reason);
+
+private:
+    struct ZoneCounters
+    {
+        long long cycles = 0;
+        long long escaped = 0;
+        long long detectionTimeUs = 0;
+        long long reportEdges = 0;
+        long long residualEdges = 0;
+        int rounds = 0;
+    };
+
+    // Share of the PAG's weight on edges between different zones of zoneOf_.
+    double cutShare(const WeightedPAG &weightedPag) const;
+
+    std::map<std::pair<int, NodeId>, ZoneCounters> zones_; // (tier, leader) -> this interval
+    std::unordered_map<NodeId, NodeId> zoneOf_;            // node -> its tier-0 leader
+    long long escapedCycles_ = 0;
+    double builtCutShare_ = 0.0;
+    std::mutex mutex_;
+};
+
+#endif // HAWK_ZONE_QUALITY_MONITOR_H
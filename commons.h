@@ -28,6 +28,21 @@ using NodeId = int;
 using TransactionId = int;
 using ResourceId = int;
 
+// One lifetime of a transaction: the home node in the high 32 bits and a per-node
+// sequence number in the low 32 bits. TransactionIds are allocated per node, so the
+// incarnation is what tells two transactions with the same id apart. 0 means unknown.
+using Incarnation = long long;
+
+inline Incarnation makeIncarnation(NodeId homeNodeId, long long sequence)
+{
+    return (static_cast<long long>(homeNodeId) << 32) | (sequence & 0xffffffffLL);
+}
+
+inline NodeId getIncarnationHomeNode(Incarnation incarnation)
+{
+    return static_cast<NodeId>(incarnation >> 32);
+}
+
 
 const int NUM_NODES = 128; // Total number of nodes in the distributed database system.
 const int RESOURCES_PER_NODE = 1000; // Number of resources managed by each node.
@@ -52,15 +67,93 @@ const double EXCLUSIVE_LOCK_PROBABILITY = 0.5; // Probability of an exclusive lo
 
 
 const int DEADLOCK_DETECTION_INTERVAL_MS = 50;
+// HAWK zone detection rounds: a zone leader starts a round only once the previous one has
+// completed or timed out. The pause between rounds halves after a round that found a
+// cycle and grows by half after one that did not, within these bounds, so detection
+// traffic follows deadlock activity.
+const int ZONE_ROUND_MIN_INTERVAL_MS = 10;
+const int ZONE_ROUND_MAX_INTERVAL_MS = 1000;
+// A WFG collection round (central node, or zone leader) still missing reports after this
+// long is closed with the reports it has.
+const int WFG_ROUND_TIMEOUT_MS = 500;
+// A zone leader's detection requests double as its heartbeat. A member that has had none
+// for this long while its leader should be polling counts the leader as stalled; the
+// zone's deputies take over one after another, each waiting one more period.
+const int ZONE_LEADER_TIMEOUT_MS = 3 * ZONE_ROUND_MAX_INTERVAL_MS;
+
+// How a HAWK tier-0 zone finds its own cycles. Its leader starts with WFG collection and
+// switches to probes after ZONE_PROBE_SPARSE_ROUNDS rounds in a row with no cycle and at
+// most ZONE_PROBE_SPARSE_EDGES edges. It switches back as soon as a probe overflows.
+enum ZoneDetectionStrategy {
+    ZONE_DETECT_WFG = 0,   // members send their WFG to the leader every round
+    ZONE_DETECT_PROBES = 1 // members chase their long-blocked transactions with PATH_PUSHING_PROBEs
+};
+const int ZONE_PROBE_SPARSE_EDGES = 8;
+const int ZONE_PROBE_SPARSE_ROUNDS = 5;
+const int ZONE_PROBE_BLOCKED_MS = 100; // members probe transactions blocked at least this long
+// A probe overflows when it would leave the zone or grow past ZONE_PROBE_MAX_PATH, and a
+// member overflows when it has more than ZONE_PROBE_MAX_PER_MEMBER transactions to probe.
+const int ZONE_PROBE_MAX_PATH = 16;
+const int ZONE_PROBE_MAX_PER_MEMBER = 8;
+// Latency budget used by the deadline-aware victim policy; a transaction older than this
+// is never preferred as a victim over one that still has slack.
+const int VICTIM_DEADLINE_MS = 2000;
+// A node remembers every victim aborted by itself or reported by the zones below it for
+// this long; a cycle through one of them is already broken and is not resolved again.
+// VictimSelector's abort history forgets a transaction this long after its last abort.
+const int VICTIM_REGISTRY_TTL_MS = 2 * ZONE_ROUND_MAX_INTERVAL_MS;
 
 // TPC-C specific constants
 const int WAREHOUSES_PER_NODE = 10;
 const int NUM_WAREHOUSES = NUM_NODES * WAREHOUSES_PER_NODE;
 
 const int PAG_SAMPLE_INTERVAL_MS = 5000;
+// Weight kept by a PAG edge from one sampling round to the next; with 0.5 a dependency
+// seen once stops counting after a few rounds while persistent ones keep accumulating.
+const double PAG_DECAY_FACTOR = 0.5;
+// Minimum decayed weight for a PAG edge to be considered by the zone partitioner.
+const double PAG_MIN_EDGE_WEIGHT = 1.0;
+// Decayed weights below this are dropped from the PAG altogether.
+const double PAG_PRUNE_WEIGHT = 0.01;
+// Most (waiting node, holding node) pairs a node keeps and reports per PAG round (PAGSampler).
+const size_t PAG_SAMPLER_CAPACITY = 256;
+// Weight of a predicted dependency (a transaction declaring access to a remote node's
+// warehouse when it is created) against an observed cross-node wait. Declared accesses
+// far outnumber waits, and most never conflict.
+const double PREDICTED_PAG_WEIGHT = 0.1;
+// When not empty, the central node records every PAG round in this file (PAGTrace), to be
+// replayed offline with `distributed_deadlock_detector plan`.
+const std::string PAG_TRACE_FILE = "";
 // const int TREE_ADJUST_INTERVAL_MS = 60000;
 const int SCC_CUT_THRESHOLD = 2;
 
+// How the central node turns the PAG into HAWK detection zones.
+enum ZonePartitioningMode {
+    ZONES_GREEDY_SCC_CUT = 0, // PAGManager::greedySCCcut: every SCC above SCC_CUT_THRESHOLD is a zone.
+    ZONES_BALANCED = 1        // ZonePartitioner: zones of at most MAX_ZONE_SIZE nodes with minimum cut weight.
+};
+
+const ZonePartitioningMode ZONE_PARTITIONING_MODE = ZONES_GREEDY_SCC_CUT;
+const int MAX_ZONE_SIZE = 16; // Upper bound on zone size for ZONES_BALANCED.
+// Most reports a leader of the HAWK detection tree aggregates per round. Zone leaders are
+// grouped into higher tiers until at most this many of them report to the central node.
+const int HAWK_TREE_FANOUT = 16;
+// After the first tree adjustment zones are only updated incrementally: a node changes
+// zone when its PAG weight towards another zone exceeds that towards its own by more
+// than this share of its total weight.
+const double ZONE_MOVE_MIN_GAIN = 0.25;
+
+// Zone leader election (LeaderElector).
+const double LEADER_LOAD_SMOOTHING = 0.3;   // weight of the newest load report in the moving average
+const double LEADER_CENTRALITY_WEIGHT = 1.0; // weight of PAG centrality against load in a candidate's score
+const double LEADER_HYSTERESIS = 0.25;      // score margin a challenger needs to replace a sitting leader
+
+// Tree adjustment triggers (ZoneQualityMonitor), checked every PAG round.
+const double ZONE_MAX_ESCAPED_SHARE = 0.5;  // share of cycles the zones let through to the central node
+const double ZONE_MAX_CUT_DRIFT = 0.2;      // growth of the PAG weight share cut by the zones since the tree was built
+const double ZONE_LEADER_OVERLOAD = 4.0;    // busiest leader's detection time over the leaders' mean
+const long long ZONE_LEADER_MIN_DETECTION_US = 10000; // below this a leader never counts as overloaded
+
 const int MONITORING_INTERVAL_MS = 2000;
 
 const int TOTAL_RUN_TIME_SECONDS = 1800;
@@ -77,11 +170,26 @@ enum DeadlockDetectionMode {
     MODE_NONE = 0, 
     MODE_CENTRALIZED = 1,  // Centralized deadlock detection mode.
     MODE_HAWK = 2,   // HAWK (Hierarchical Adaptive Wait-for Graph) deadlock detection mode.
-    MODE_PATH_PUSHING = 3  // Path Pushing deadlock detection mode.
+    MODE_PATH_PUSHING = 3, // Path Pushing deadlock detection mode.
+    MODE_ADAPTIVE = 4      // Runs one of the three above, chosen at runtime (DetectionModeSelector).
 };
 
 
 const DeadlockDetectionMode DEADLOCK_DETECTION_MODE = MODE_CENTRALIZED;
+// MODE_ADAPTIVE: the cluster starts in ADAPTIVE_INITIAL_MODE and the central node picks the
+// detector again after every PAG round, from that round's cross-node wait rate, the
+// length of the cycles resolved and the time spent detecting them.
+const DeadlockDetectionMode ADAPTIVE_INITIAL_MODE = MODE_CENTRALIZED;
+// Below this many cross-node waits per node and second, waits are rare enough for path-pushing,
+const double ADAPTIVE_RARE_WAITS_PER_NODE_S = 1.0;
+// as long as the cycles it has to chase stay this short on average.
+const double ADAPTIVE_MAX_PROBE_CYCLE_LENGTH = 4.0;
+// Centralized detection is preferred up to this many nodes, until detection takes more
+// than this share of the central node's time; HAWK takes over from there.
+const int ADAPTIVE_CENTRALIZED_MAX_NODES = 16;
+const double ADAPTIVE_MAX_CENTRAL_DETECTION_SHARE = 0.05;
+// PAG rounds in a row another detector must be preferred before the cluster switches.
+const int ADAPTIVE_SWITCH_ROUNDS = 2;
 
 // --- Transaction Type Control Macros ---
 // Define transaction type, only one can be selected
@@ -134,6 +242,8 @@ enum NetworkMessageType
     ZONE_DETECTION_REQUEST = 11,
     ZONE_WFG_REPORT = 12,
     CENTRAL_WFG_REPORT_FROM_ZONE = 13,
+    ZONE_LEADER_FAILOVER = 20, // deputy to the central node: it took over a stalled leader's zone
+    DETECTION_MODE_CHANGE = 21, // central node to all, MODE_ADAPTIVE: the detector to run from now on
 
     // Path-Pushing Detection
     PATH_PUSHING_PROBE = 14,
@@ -156,6 +266,64 @@ struct WFDEdge
     NodeId holdingNodeId; 
 };
 
+// Number of cross-node waits from waitingNodeId on holdingNodeId a node saw in one PAG round.
+struct PAGPairCount
+{
+    NodeId waitingNodeId;
+    NodeId holdingNodeId;
+    long long count;
+};
+
+// Provenance of one reported WFG edge. The epoch is the reporter's WFG snapshot counter,
+// so edges left over from an older snapshot of the same node can be told apart from fresh
+// ones; the incarnations pin down which lifetime of each transaction the edge refers to.
+struct WFGEdgeTag
+{
+    TransactionId waitingTransId;
+    TransactionId holdingTransId;
+    NodeId reporterNodeId;
+    long long epoch;
+    Incarnation waitingIncarnation;
+    Incarnation holdingIncarnation;
+};
+
+
+// What aborting one lifetime of a transaction would throw away, reported by its home node
+// alongside the WFG, or added to a path-pushing probe, so the detecting node can pick
+// victims by cost (see VictimSelector).
+struct TransactionCost
+{
+    TransactionId transId;
+    Incarnation incarnation;
+    long long ageMs;     // time since the transaction started
+    int statementsDone;
+    int statementsTotal;
+    int locksHeld;
+    std::vector<NodeId> lockNodes; // nodes it holds locks on, each listed once
+};
+
+// Load a node reports with its PAG sample; the central node uses it to pick zone leaders.
+struct NodeLoad
+{
+    NodeId nodeId;
+    long long detectionTimeUs; // time spent detecting deadlocks since the previous report
+    int activeTransactions;
+    int queueDepth;            // messages waiting in the node's incoming queue
+    int cyclesResolved;        // deadlock cycles this node resolved since the previous report
+    long long cycleMembers;    // their total length
+};
+
+// Per-zone figures a leader attaches to its CENTRAL_WFG_REPORT_FROM_ZONE; a report from a
+// higher tier carries those of every zone in its subtree (ZoneQualityMonitor).
+struct ZoneReportStats
+{
+    NodeId leaderId;
+    int level;
+    int cyclesDetected;        // cycles the leader resolved in this round
+    long long detectionTimeUs; // time the leader spent resolving them
+    int reportEdges;           // WFG edges the leader aggregated
+    int residualEdges;         // edges it forwarded up the tree
+};
 
 // Structure for network messages, containing various fields depending on the message type.
 // This union-like structure allows different types of data to be carried by a single message.
@@ -180,13 +348,34 @@ struct NetworkMessage
 
 
     std::vector<TransactionId> deadlockedTransactions;
+    std::vector<Incarnation> deadlockedIncarnations; // parallel to deadlockedTransactions, 0 = unchecked
+
+    std::vector<WFGEdgeTag> wfgEdgeTags; // provenance of the edges in wfgData / wfgDataPairs
+    std::vector<TransactionCost> transactionCosts; // abort cost of the reporter's blocked transactions, or of a probe's path
 
 
-    std::vector<WFDEdge> pagEdges;
+    std::vector<PAGPairCount> pagPairCounts; // sender's cross-node wait summary, with PAG_RESPONSE
+    std::vector<PAGPairCount> predictedPagPairCounts; // sender's declared remote accesses, with PAG_RESPONSE
+    NodeLoad nodeLoad{0, 0, 0, 0, 0, 0}; // sender's load, with PAG_RESPONSE
 
 
     std::vector<std::vector<NodeId>> detectionZones; 
     std::vector<NodeId> detectionZoneLeaders; 
+    std::vector<int> detectionZoneLevels; // parallel to detectionZones, tier of each zone (0 = nodes)
+    int zoneLevel = 0; // tier of the zone a CENTRAL_WFG_REPORT_FROM_ZONE was aggregated in
+    std::vector<ZoneReportStats> zoneStats; // with CENTRAL_WFG_REPORT_FROM_ZONE
+    // Victims aborted in the reporting subtree, with CENTRAL_WFG_REPORT_FROM_ZONE, or by the
+    // reporter's zone probes, with ZONE_WFG_REPORT.
+    std::vector<Incarnation> victimIncarnations;
+    long long roundId = 0; // WFG collection round a WFG_REPORT / ZONE_DETECTION_REQUEST opens or a report answers
+    // DISTRIBUTED_DETECTION_INIT carries the whole tree (baseTreeVersion 0) or only the
+    // zones changed since baseTreeVersion plus the (tier, leader) keys of removed zones.
+    // ZONE_DETECTION_REQUEST carries the tree version its zone comes from, and
+    // ZONE_WFG_REPORT the version the member had when it answered.
+    long long treeVersion = 0;
+    long long baseTreeVersion = 0;
+    std::vector<NodeId> removedZoneLeaders;
+    std::vector<int> removedZoneLevels; // parallel to removedZoneLeaders
 
     TransactionId victimTransId;
 
@@ -198,8 +387,17 @@ struct NetworkMessage
     std::vector<TransactionId> path;
 
 
-    NodeId centralNodeId; 
+    // Zone leader of a ZONE_DETECTION_REQUEST, or of a PATH_PUSHING_PROBE kept within its
+    // zone (0 for an unrestricted probe).
+    NodeId centralNodeId = 0; 
     std::vector<NodeId> zoneMembers; 
+    int zoneStrategy = ZONE_DETECT_WFG; // with ZONE_DETECTION_REQUEST
+    bool probeOverflow = false; // with ZONE_WFG_REPORT: a zone probe of the sender overflowed
+    // MODE_ADAPTIVE: the detector the cluster runs and the epoch of that choice, with
+    // DETECTION_MODE_CHANGE and repeated on every PAG_REQUEST for nodes that missed it.
+    int detectionMode = MODE_NONE;
+    long long modeEpoch = 0;
+    NodeId failedLeaderId = 0; // with ZONE_LEADER_FAILOVER, the leader the sender replaced
 };
 
 // Utility function to determine the owner node of a given resource.
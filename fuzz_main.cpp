@@ -0,0 +1,16 @@
+#include <iostream>
+#include <string>
+#include <random>
+
+#include "DetectorFuzzer.h"
+
+// Offline check of the deadlock detectors against a ground-truth oracle. Built as its
+// own binary (make fuzz) because DetectorFuzzer replaces the global operator new.
+int main(int argc, char *argv[])
+{
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 200;
+    unsigned int seed = argc > 2 ? static_cast<unsigned int>(std::stoul(argv[2])) : std::random_device{}();
+    std::cout << "Fuzzing deadlock detectors: " << iterations << " iterations, seed " << seed << "\n";
+    DetectorFuzzer fuzzer(seed);
+    return fuzzer.run(iterations) == 0 ? 0 : 1;
+}
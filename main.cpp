@@ -9,6 +9,8 @@
 #include "commons.h"
 #include "Network.h"
 #include "DistributedDBNode.h"
+#include "PAGTrace.h"
+#include "ZonePlanner.h"
 
 std::atomic<bool> systemRunning(true);
 
@@ -77,12 +79,19 @@ int main(int argc, char *argv[])
     }
     else if (argc > 1 && std::string(argv[1]) == "server")
     {
-        if (argc != 3)
+        if (argc != 3 && argc != 4)
         {
-            std::cerr << "Usage: " << argv[0] << " server <node_id>\\n";
+            std::cerr << "Usage: " << argv[0] << " server <node_id> [victim_policy]\\n";
             return 1;
         }
         NodeId nodeId = std::stoi(argv[2]);
+        VictimPolicy victimPolicy = VictimPolicy::MOST_CYCLES;
+        if (argc == 4 && !VictimSelector::parsePolicy(argv[3], victimPolicy))
+        {
+            std::cerr << "Unknown victim policy '" << argv[3]
+                      << "'. Use most-cycles, youngest, least-work, fewest-locks, deadline or starvation.\\n";
+            return 1;
+        }
         std::cout << "Starting Distributed Deadlock Detection System (Node " << nodeId << " Server Mode)...\\n";
         std::cout << "Number of nodes: " << NUM_NODES << "\\n";
         std::cout << "Resources per node: " << RESOURCES_PER_NODE << "\\n";
@@ -95,6 +104,8 @@ int main(int argc, char *argv[])
         else if (DEADLOCK_DETECTION_MODE == MODE_CENTRALIZED) std::cout << "CENTRALIZED\\n";
         else if (DEADLOCK_DETECTION_MODE == MODE_HAWK) std::cout << "HAWK\\n";
         else if (DEADLOCK_DETECTION_MODE == MODE_PATH_PUSHING) std::cout << "PATH_PUSHING\\n";
+        else if (DEADLOCK_DETECTION_MODE == MODE_ADAPTIVE) std::cout << "ADAPTIVE\\n";
+        std::cout << "Victim Policy: " << VictimSelector::policyName(victimPolicy) << "\\n";
         std::cout << "Transaction Type: ";
 #ifdef TRANSACTION_TYPE_TPCC
         std::cout << "TPC-C\\n";
@@ -103,7 +114,7 @@ int main(int argc, char *argv[])
 #endif
 
         Network network(nodeId, NUM_NODES);
-        DistributedDBNode node(nodeId, NUM_NODES, network);
+        DistributedDBNode node(nodeId, NUM_NODES, network, victimPolicy);
 
         node.run();
 
@@ -126,11 +137,47 @@ int main(int argc, char *argv[])
         {
             std::cout << "Node " << nodeId << ": No transactions completed during the simulation.\\n";
         }
+        node.printVictimPolicyStats();
         std::cout << "Node " << nodeId << " gracefully shut down.\\n";
     }
+    else if (argc > 2 && std::string(argv[1]) == "plan")
+    {
+        // Offline replay of a recorded PAG trace through zone partitioning strategies.
+        int numNodes = 0;
+        std::vector<PAGTraceRound> rounds;
+        if (!PAGTrace::load(argv[2], numNodes, rounds))
+        {
+            return 1;
+        }
+        std::vector<std::string> names;
+        for (int i = 3; i < argc; ++i)
+        {
+            names.push_back(argv[i]);
+        }
+        if (names.empty())
+        {
+            names = {"scc:2", "scc:3", "scc:4", "balanced:" + std::to_string(MAX_ZONE_SIZE),
+                     "incremental:" + std::to_string(MAX_ZONE_SIZE)};
+        }
+        std::vector<ZonePlanner::Strategy> strategies;
+        for (const std::string &name : names)
+        {
+            ZonePlanner::Strategy strategy;
+            if (!ZonePlanner::parseStrategy(name, strategy))
+            {
+                std::cerr << "Unknown strategy '" << name << "'. Use scc:<threshold>, balanced:<max zone size> or incremental:<max zone size>.\n";
+                return 1;
+            }
+            strategies.push_back(strategy);
+        }
+        std::cout << "Replaying " << rounds.size() << " PAG rounds of " << numNodes << " nodes from " << argv[2] << "\n";
+        ZonePlanner planner(numNodes);
+        planner.run(rounds, strategies);
+    }
     else
     {
-        std::cerr << "Usage: " << argv[0] << " <server | client> <node_id | server_node_id>\\n";
+        std::cerr << "Usage: " << argv[0] << " <server | client> <node_id | server_node_id> [victim_policy]\\n";
+        std::cerr << "       " << argv[0] << " plan <pag_trace> [strategy ...]\\n";
         return 1;
     }
 
@@ -10,6 +10,10 @@ GRPC_INSTALL_DIR="/home/user/software/grpc-v1.59.0"
 
 IP_PREFIX="10.181.81."
 
+# Victim policy used by the detecting nodes: most-cycles, youngest, least-work,
+# fewest-locks, deadline or starvation.
+VICTIM_POLICY="${VICTIM_POLICY:-most-cycles}"
+
 # --- Cleanup previous runs ---
 echo "Cleaning up previous runs..."
 make clean
@@ -33,7 +37,7 @@ for (( i=1; i<=$NUM_NODES; i++ ))
 do
     IP_ADDRESS="${IP_PREFIX}${i}"
     echo "Starting node $i on ${IP_ADDRESS}..."
-    SSH_COMMAND="cd $TARGET_DIR && nohup ./distributed_deadlock_detector server $i > node_$i.log 2>&1 & echo \$!"
+    SSH_COMMAND="cd $TARGET_DIR && nohup ./distributed_deadlock_detector server $i $VICTIM_POLICY > node_$i.log 2>&1 & echo \$!"
     
     REMOTE_PID=$(ssh "$IP_ADDRESS" "$SSH_COMMAND")
     if [ $? -eq 0 ] && [ -n "$REMOTE_PID" ]; then
@@ -8,7 +8,24 @@ TPCCNewOrderTransaction::TPCCNewOrderTransaction(TPCCDatabase& db, LockTable& lo
                                                  int w_id, int d_id, int c_id,
                                                  const std::vector<std::pair<int, int>>& item_info)
     : TPCCTransaction(db, lock_table, txn_id, home_node_id, rng),
-      w_id_(w_id), d_id_(d_id), c_id_(c_id), item_info_(item_info) {}
+      w_id_(w_id), d_id_(d_id), c_id_(c_id), item_info_(item_info) {
+    // The supplying warehouses are chosen here rather than in execute() so the
+    // transaction's remote accesses are known before it runs.
+    supply_w_ids_.reserve(item_info_.size());
+    for (size_t i = 0; i < item_info_.size(); ++i) {
+        if (rng_.generateRandomDouble(0.0, 1.0) < 0.2) {
+            supply_w_ids_.push_back(rng_.generateRandomWarehouseId(home_node_id_));
+        } else {
+            supply_w_ids_.push_back(w_id_);
+        }
+    }
+}
+
+std::vector<int> TPCCNewOrderTransaction::declaredWarehouses() const {
+    std::vector<int> warehouses = supply_w_ids_;
+    warehouses.push_back(w_id_);
+    return warehouses;
+}
 
 bool TPCCNewOrderTransaction::execute() {
     try {
@@ -63,12 +80,7 @@ bool TPCCNewOrderTransaction::execute() {
             // int ol_supply_w_id = item_info_[i].second;
             int ol_quantity = 5;
 
-            int ol_supply_w_id;
-            if (rng_.generateRandomDouble(0.0, 1.0) < 0.2) {
-                ol_supply_w_id = rng_.generateRandomWarehouseId(home_node_id_);
-            } else {
-                ol_supply_w_id = w_id_;
-            }
+            int ol_supply_w_id = supply_w_ids_[i];
 
             ResourceId item_res_id = getTPCCResourceId("ITEM", 0, 0, 0, ol_i_id);
             if (!acquireLock(item_res_id, LockMode::SHARED)) {
@@ -45,6 +45,11 @@ inline ResourceId getTPCCResourceId(const std::string& table_name, int w_id, int
     return 0;
 }
 
+// Node that stores a warehouse; node n holds warehouses (n - 1) * WAREHOUSES_PER_NODE + 1 onwards.
+inline NodeId getTPCCWarehouseNode(int w_id) {
+    return (w_id - 1) / WAREHOUSES_PER_NODE + 1;
+}
+
 class TPCCTransaction : public Transaction {
 public:
     TPCCDatabase& db_;
@@ -63,6 +68,21 @@ public:
 
     virtual bool execute() = 0;
 
+    // Warehouses the transaction will touch, known when it is created.
+    virtual std::vector<int> declaredWarehouses() const = 0;
+
+    // Nodes other than the home node that store a declared warehouse, each listed once.
+    std::vector<NodeId> remoteAccessNodes() const {
+        std::vector<NodeId> nodes;
+        for (int w_id : declaredWarehouses()) {
+            NodeId node = getTPCCWarehouseNode(w_id);
+            if (node != home_node_id_ && std::find(nodes.begin(), nodes.end(), node) == nodes.end()) {
+                nodes.push_back(node);
+            }
+        }
+        return nodes;
+    }
+
 protected:
     bool acquireLock(ResourceId resId, LockMode mode) {
         bool success = lock_table_.acquireLock(this->id, resId, mode);
@@ -96,12 +116,14 @@ public:
                             const std::vector<std::pair<int, int>>& item_info);
 
     bool execute() override;
+    std::vector<int> declaredWarehouses() const override;
 
 private:
     int w_id_;
     int d_id_;
     int c_id_;
     std::vector<std::pair<int, int>> item_info_;
+    std::vector<int> supply_w_ids_; // ol_supply_w_id per item, drawn up front
 };
 
 class TPCCPaymentTransaction : public TPCCTransaction {
@@ -111,6 +133,7 @@ public:
                            int w_id, int d_id, int c_w_id, int c_d_id, int c_id, double h_amount);
 
     bool execute() override;
+    std::vector<int> declaredWarehouses() const override { return {w_id_, c_w_id_}; }
 
 private:
     int w_id_;
@@ -129,6 +152,7 @@ public:
                                int w_id, int d_id, int c_id);
 
     bool execute() override;
+    std::vector<int> declaredWarehouses() const override { return {w_id_}; }
 
 private:
     int w_id_;
@@ -144,6 +168,7 @@ public:
                             int w_id, int o_carrier_id);
 
     bool execute() override;
+    std::vector<int> declaredWarehouses() const override { return {w_id_}; }
 
 private:
     int w_id_;
@@ -157,6 +182,7 @@ public:
                               int w_id, int d_id, int threshold);
 
     bool execute() override;
+    std::vector<int> declaredWarehouses() const override { return {w_id_}; }
 
 private:
     int w_id_;